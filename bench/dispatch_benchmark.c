@@ -0,0 +1,193 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  dispatch_benchmark.c
+ *
+ *    Description:  Measures instructions per second of the cpu core on each of the
+ *                  ROMs given on the command line. A checksum of the machine state
+ *                  is printed alongside so runs of different cores can be compared.
+ *                  Each ROM is also run frame by frame, the way hosts drive it, where
+ *                  runs end on cycle budgets rather than instruction counts
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 09:12:40
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Matt Gercz (matt.gercz@icloud.com)
+ *
+ * =====================================================================================
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "global_declarations.h"
+#include "cpu_emulator.h"
+#include "memory.h"
+#include "scheduler.h"
+#include "idle_loop.h"
+#ifdef JIT
+#include "jit.h"
+#elif defined(BLOCK_CACHE)
+#include "block_cache.h"
+#endif
+
+#define DEFAULT_INSTRUCTIONS 10000000 // Instructions executed per ROM
+#define DEFAULT_FRAMES 600 // Frames run per ROM
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  state_checksum
+ *  Description:  Hashes the registers, flags, and addressable memory (FNV-1a)
+ *       Return:  A 32-bit checksum of the current machine state
+ * =====================================================================================
+ */
+    static unsigned int
+state_checksum(GB *gb)
+{
+    unsigned int hash = 0x811C9DC5u;
+    unsigned char state[] = {gb->regs.A, gb->regs.B, gb->regs.C, gb->regs.D, gb->regs.E, gb->regs.H,
+                             gb->regs.L, get_flag(FLAG_Z), get_flag(FLAG_N), get_flag(FLAG_H),
+                             get_flag(FLAG_C), gb->regs.IME,
+                             (unsigned char) gb->regs.SP, (unsigned char) (gb->regs.SP >> 0x8u),
+                             (unsigned char) gb->regs.PC, (unsigned char) (gb->regs.PC >> 0x8u)};
+
+    for (unsigned int i = 0; i < sizeof(state); i++)
+    {
+        hash = (hash ^ state[i]) * 0x01000193u;
+    }
+    for (unsigned int addr = 0x8000; addr <= 0xFFFF; addr++)
+    {
+        hash = (hash ^ read_memory(gb, (unsigned short) addr)) * 0x01000193u;
+    }
+
+    return hash;
+}        /* -----  end of function state_checksum  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  print_core_stats
+ *  Description:  Prints the counters of whichever code cache the core was built with
+ * =====================================================================================
+ */
+    static void
+print_core_stats(GB *gb)
+{
+#ifdef JIT
+    printf("    blocks compiled %lu, executed %lu, native instructions %lu, "
+           "invalidations %lu\n", gb->jit_stats.blocks_compiled, gb->jit_stats.blocks_executed,
+           gb->jit_stats.instructions_executed, gb->jit_stats.invalidations);
+#elif defined(BLOCK_CACHE)
+    printf("    block hits %lu, misses %lu, replayed instructions %lu, "
+           "invalidations %lu\n", gb->block_cache_stats.hits, gb->block_cache_stats.misses,
+           gb->block_cache_stats.instructions_replayed, gb->block_cache_stats.invalidations);
+#else
+    (void) gb;
+#endif
+}        /* -----  end of function print_core_stats  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  run_frames
+ *  Description:  Runs a ROM one frame at a time, each run ending at the next V-Blank
+ *   Parameters:  frames is the number of frames to run
+ * =====================================================================================
+ */
+    static void
+run_frames(const char *rom, long frames)
+{
+    struct timespec start, end;
+    GB *gb = init_gb();
+
+    if (load_cartridge(gb, rom))
+    {
+        free_gb(gb);
+        return;
+    }
+    init_memory(gb, NULL);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (long frame = 0; frame < frames; frame++)
+    {
+        cpu_run_cycles(gb, next_vblank(gb) - gb->clock.cycles, -1); // Counts gb->instructions
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double seconds = (double) (end.tv_sec - start.tv_sec) +
+                     (double) (end.tv_nsec - start.tv_nsec) / 1e9;
+    printf("    %ld frames in %.4f seconds, %.0f instr/sec\n", frames, seconds,
+           (double) gb->instructions / seconds);
+    print_core_stats(gb);
+
+    free_gb(gb);
+}        /* -----  end of function run_frames  ----- */
+
+int main(int argc, char **argv)
+{
+    long instructions = DEFAULT_INSTRUCTIONS;
+    char *env_instructions = getenv("BENCH_INSTRUCTIONS");
+    long frames = DEFAULT_FRAMES;
+    char *env_frames = getenv("BENCH_FRAMES");
+
+    if (env_instructions != NULL)
+    {
+        instructions = strtol(env_instructions, NULL, 0);
+    }
+    if (env_frames != NULL)
+    {
+        frames = strtol(env_frames, NULL, 0);
+    }
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s rom.gb [rom.gb ...]\n", argv[0]);
+        return 1;
+    }
+
+    init_opcode_tables();
+#ifdef THREADED_CORE
+    printf("core: threaded\n");
+#elif defined(JIT)
+    printf("core: jit\n");
+#elif defined(BLOCK_CACHE)
+    printf("core: block cache\n");
+#else
+    printf("core: table dispatch\n");
+#endif
+    printf("%-32s %14s %12s %10s\n", "rom", "instr/sec", "seconds", "checksum");
+    for (int rom = 1; rom < argc; rom++)
+    {
+        struct timespec start, end;
+
+        GB *gb = init_gb();
+
+        if (load_cartridge(gb, argv[rom]))
+        {
+            fprintf(stderr, "%s isn't a Game Boy rom\n", argv[rom]);
+            free_gb(gb);
+            continue;
+        }
+        init_memory(gb, NULL);
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        cpu_run(gb, (unsigned long) instructions, -1);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        double seconds = (double) (end.tv_sec - start.tv_sec) +
+                         (double) (end.tv_nsec - start.tv_nsec) / 1e9;
+        printf("%-32s %14.0f %12.4f   %08X\n", argv[rom],
+               (double) instructions / seconds, seconds, state_checksum(gb));
+        printf("    halts %lu, cycles skipped %lu of %lu\n", gb->halt_stats.halts,
+               gb->halt_stats.cycles_skipped, gb->clock.cycles);
+        print_idle_loops(gb);
+#ifdef LAZY_FLAGS
+        printf("    flags materialized %lu, materializations avoided %lu\n",
+               gb->lazy_flags_stats.materialized, gb->lazy_flags_stats.avoided);
+#endif
+        print_core_stats(gb);
+
+        free_gb(gb);
+        run_frames(argv[rom], frames);
+    }
+
+    return 0;
+}
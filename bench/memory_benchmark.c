@@ -0,0 +1,140 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  memory_benchmark.c
+ *
+ *    Description:  Compares the page table used by read_memory and write_memory
+ *                  against the branching decode_read and decode_write path it
+ *                  replaced, for sequential and random reads and writes. Writes
+ *                  stay in work RAM since other regions have side effects
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 19:05:31
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Matt Gercz (matt.gercz@icloud.com)
+ *
+ * =====================================================================================
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "global_declarations.h"
+#include "memory.h"
+
+#define DEFAULT_ACCESSES 0x4000000 // Accesses made by each pattern through each path
+#define RANDOM_ADDRESSES 0x10000
+
+static unsigned short random_addresses[RANDOM_ADDRESSES];
+static volatile unsigned char sink; // Keeps the reads from being optimized away
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  elapsed
+ *  Description:  Returns the seconds between two clock readings
+ * =====================================================================================
+ */
+    static double
+elapsed(const struct timespec *start, const struct timespec *end)
+{
+    return (double) (end->tv_sec - start->tv_sec) +
+           (double) (end->tv_nsec - start->tv_nsec) / 1e9;
+}        /* -----  end of function elapsed  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  run_pattern
+ *  Description:  Times one access pattern through the old path and the page table
+ *   Parameters:  gb is the instance whose memory is accessed
+ *                name is printed to identify the pattern
+ *                random is nonzero to use random_addresses, zero for sequential
+ *                write is nonzero to time writes, zero for reads
+ *                accesses is the number of accesses made through each path
+ * =====================================================================================
+ */
+    static void
+run_pattern(GB *gb, const char *name, int random, int write, long accesses)
+{
+    double seconds[0x2];
+
+    for (int path = 0; path < 0x2; path++)
+    {
+        struct timespec start, end;
+        unsigned char total = 0;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (long i = 0; i < accesses; i++)
+        {
+            unsigned short addr = random ? random_addresses[i & (RANDOM_ADDRESSES - 0x1)]
+                                         : (unsigned short) i;
+
+            if (write)
+            {
+                addr = (unsigned short) (0xC000 + (addr & 0x1FFFu));
+                if (path)
+                {
+                    write_memory(gb, addr, (unsigned char) i);
+                }
+                else
+                {
+                    decode_write(gb, addr, (unsigned char) i);
+                }
+            }
+            else
+            {
+                total += path ? read_memory(gb, addr) : *decode_read(gb, addr);
+            }
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        sink = total;
+        seconds[path] = elapsed(&start, &end);
+    }
+
+    printf("%-20s %14.2f %14.2f %9.2fx\n", name, seconds[0] * 1e9 / (double) accesses,
+           seconds[1] * 1e9 / (double) accesses, seconds[0] / seconds[1]);
+}        /* -----  end of function run_pattern  ----- */
+
+int main(int argc, char **argv)
+{
+    long accesses = DEFAULT_ACCESSES;
+    char *env_accesses = getenv("BENCH_ACCESSES");
+    unsigned int seed = 0x2545F491u;
+
+    if (env_accesses != NULL)
+    {
+        accesses = strtol(env_accesses, NULL, 0);
+    }
+    if (argc != 2)
+    {
+        fprintf(stderr, "usage: %s rom.gb\n", argv[0]);
+        return 1;
+    }
+
+    // xorshift32 so every run uses the same addresses
+    for (int i = 0; i < RANDOM_ADDRESSES; i++)
+    {
+        seed ^= seed << 0xDu;
+        seed ^= seed >> 0x11u;
+        seed ^= seed << 0x5u;
+        random_addresses[i] = (unsigned short) seed;
+    }
+
+    GB *gb = init_gb();
+    if (load_cartridge(gb, argv[1]))
+    {
+        fprintf(stderr, "%s isn't a Game Boy rom\n", argv[1]);
+        free_gb(gb);
+        return 1;
+    }
+    init_memory(gb, NULL);
+
+    printf("%-20s %14s %14s %10s\n", "pattern", "old ns/access", "new ns/access", "speedup");
+    run_pattern(gb, "sequential reads", 0, 0, accesses);
+    run_pattern(gb, "random reads", 1, 0, accesses);
+    run_pattern(gb, "sequential writes", 0, 1, accesses);
+    run_pattern(gb, "random writes", 1, 1, accesses);
+
+    free_gb(gb);
+    return 0;
+}
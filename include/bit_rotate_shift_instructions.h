@@ -18,16 +18,6 @@
 
 #ifndef BITROTATESHIFTINSTRUCTIONS
 #define BITROTATESHIFTINSTRUCTIONS
-void rr (unsigned char *reg);
-void rrc (unsigned char *reg);
-void rl (unsigned char *reg);
-void rlc (unsigned char *reg);
-void sla (unsigned char *reg);
-void sra (unsigned char *reg);
-void swap (unsigned char *reg);
-void srl (unsigned char *reg);
-void bit (unsigned char opcode, const unsigned char *reg);
-void res (unsigned char opcode, unsigned char *reg);
-void set (unsigned char opcode, unsigned char *reg);
-unsigned char bit_rotate_shift (unsigned char opcode);
+#include "cpu_emulator.h"
+void register_bit_rotate_shift_instructions(Opcode *table, opcode_handler *cb_table);
 #endif
@@ -0,0 +1,37 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  block_cache.h
+ *
+ *    Description:  Header for the cache of pre-decoded basic blocks
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 15:42:07
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Matt Gercz (matt.gercz@icloud.com)
+ *
+ * =====================================================================================
+ */
+
+#ifndef MATTYGBOY_BLOCK_CACHE_H
+#define MATTYGBOY_BLOCK_CACHE_H
+
+typedef struct GB GB;
+
+// Decoded blocks of one instance, allocated the first time it runs a block
+typedef struct Block_Cache Block_Cache;
+
+typedef struct Block_Cache_Stats
+{
+	unsigned long hits; // Blocks replayed from the cache
+	unsigned long misses; // Blocks decoded on first execution
+	unsigned long instructions_replayed;
+	unsigned long invalidations; // Blocks dropped because their RAM was written
+} Block_Cache_Stats;
+
+unsigned int block_cache_execute(GB *gb, unsigned long max_instructions, int stop_pc);
+void block_cache_invalidate(GB *gb, unsigned short addr);
+void block_cache_flush(GB *gb);
+#endif
@@ -0,0 +1,46 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  cartridge.h
+ *
+ *    Description:  Header for cartridge roms, which are read only and shared by every
+ *                  instance running the same file
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026 00:26:37
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Matt Gercz (matt.gercz@icloud.com)
+ *
+ * =====================================================================================
+ */
+
+#ifndef MATTYGBOY_CARTRIDGE_H
+#define MATTYGBOY_CARTRIDGE_H
+
+#include <sys/types.h>
+#include <time.h>
+
+#define CARTRIDGE_HEADER_END 0x150
+
+typedef struct Cartridge
+{
+	unsigned char *rom; // Read only, mapped without write access when it came from a file
+	unsigned long size; // From the ROM size byte of the header, a power of two
+	unsigned int rom_banks; // 16 KiB banks, bank numbers wrap around at this
+	unsigned int references; // Instances using the cartridge
+	int mapped; // Nonzero for a file mapping, 0 for a heap copy
+	dev_t device; // Identify the file a mapping came from
+	ino_t inode;
+	off_t file_size;
+	struct timespec modified;
+	struct Cartridge *next; // Further mappings that are open
+} Cartridge;
+
+unsigned long cartridge_rom_size(const unsigned char *header, unsigned long size);
+Cartridge* open_cartridge(const char *file);
+Cartridge* copy_cartridge(const unsigned char *data, unsigned long size);
+void release_cartridge(Cartridge *cartridge);
+Cartridge* share_cartridge(Cartridge *cartridge);
+#endif
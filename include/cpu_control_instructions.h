@@ -17,12 +17,6 @@
  */
 #ifndef CPUCONTROLINSTRUCTIONS
 #define CPUCONTROLINSTRUCTIONS
-unsigned char halt();
-unsigned char stop();
-unsigned char push(unsigned char opcode);
-unsigned char pop(unsigned char opcode);
-unsigned char ei();
-unsigned char di();
-unsigned char ccf();
-unsigned char scf();
+#include "cpu_emulator.h"
+void register_cpu_control_instructions(Opcode *table);
 #endif
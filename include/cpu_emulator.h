@@ -17,8 +17,90 @@
 
 #ifndef CPUEMULATOR
 #define CPUEMULATOR
-void eight_bit_update_flags(unsigned char value1, unsigned char value2);
-void sixteen_bit_update_flags(unsigned short value1, unsigned short value2);
-void request_interrupt (unsigned char bitSetter);
-void cpu_execution ();
+
+typedef struct GB GB;
+
+// Every opcode is emulated by its own handler, which receives any immediate operand
+// already fetched (little-endian for 16-bit immediates) and returns the clock cycles used
+typedef unsigned char (*opcode_handler)(GB *gb, unsigned short operand);
+
+typedef struct Opcode
+{
+	opcode_handler execute;
+	unsigned char length; // Number of immediate bytes following the opcode
+} Opcode;
+
+// Generates the handlers for an instruction whose 8-bit operand comes from B, C, D, E,
+// H, L, memory[HL], A, or an immediate, named handler_b ... handler_a and handler_imm
+#define EIGHT_BIT_OPERAND_HANDLERS(handler, instruction) \
+	static unsigned char handler##_b(GB *gb, unsigned short operand) \
+	{ instruction(gb, gb->regs.B); return 0x4; } \
+	static unsigned char handler##_c(GB *gb, unsigned short operand) \
+	{ instruction(gb, gb->regs.C); return 0x4; } \
+	static unsigned char handler##_d(GB *gb, unsigned short operand) \
+	{ instruction(gb, gb->regs.D); return 0x4; } \
+	static unsigned char handler##_e(GB *gb, unsigned short operand) \
+	{ instruction(gb, gb->regs.E); return 0x4; } \
+	static unsigned char handler##_h(GB *gb, unsigned short operand) \
+	{ instruction(gb, gb->regs.H); return 0x4; } \
+	static unsigned char handler##_l(GB *gb, unsigned short operand) \
+	{ instruction(gb, gb->regs.L); return 0x4; } \
+	static unsigned char handler##_hl(GB *gb, unsigned short operand) \
+	{ instruction(gb, read_memory(gb, gb->regs.HL)); return 0x8; } \
+	static unsigned char handler##_a(GB *gb, unsigned short operand) \
+	{ instruction(gb, gb->regs.A); return 0x4; } \
+	static unsigned char handler##_imm(GB *gb, unsigned short operand) \
+	{ instruction(gb, (unsigned char) operand); return 0x8; }
+
+// Places the handlers above in the table, register forms at opcode ... opcode + 7
+#define REGISTER_EIGHT_BIT_OPERAND_HANDLERS(table, opcode, imm_opcode, handler) \
+	table[(opcode) + 0x0] = (Opcode) {handler##_b, 0x0}; \
+	table[(opcode) + 0x1] = (Opcode) {handler##_c, 0x0}; \
+	table[(opcode) + 0x2] = (Opcode) {handler##_d, 0x0}; \
+	table[(opcode) + 0x3] = (Opcode) {handler##_e, 0x0}; \
+	table[(opcode) + 0x4] = (Opcode) {handler##_h, 0x0}; \
+	table[(opcode) + 0x5] = (Opcode) {handler##_l, 0x0}; \
+	table[(opcode) + 0x6] = (Opcode) {handler##_hl, 0x0}; \
+	table[(opcode) + 0x7] = (Opcode) {handler##_a, 0x0}; \
+	table[(imm_opcode)] = (Opcode) {handler##_imm, 0x1}
+
+typedef struct Halt_Stats
+{
+	unsigned long halts; // HALT instructions executed, including ones still asleep
+	unsigned long cycles_skipped; // Cycles jumped over instead of emulated while halted
+} Halt_Stats;
+
+#ifdef LAZY_FLAGS
+// The last arithmetic op whose Z, H, and C flags haven't been worked out yet
+typedef struct Lazy_Flags
+{
+	unsigned char pending; // Flags still to be computed, 0 if none
+	unsigned char sixteen_bit;
+	unsigned char subtract; // State of N when the op ran
+	unsigned short value1, value2;
+} Lazy_Flags;
+
+typedef struct Lazy_Flags_Stats
+{
+	unsigned long materialized; // Pending flags worked out because they were read
+	unsigned long avoided; // Pending flags overwritten before anything read them
+} Lazy_Flags_Stats;
+
+void sync_flags(GB *gb, unsigned char overwritten);
+#else
+#define sync_flags(gb, overwritten) ((void) 0)
+#endif
+
+extern Opcode opcode_table[0x100];
+extern opcode_handler cb_opcode_table[0x100];
+
+void init_opcode_tables();
+int opcode_is_illegal(unsigned char opcode);
+int opcode_ends_block(unsigned char opcode);
+void eight_bit_update_flags(GB *gb, unsigned char value1, unsigned char value2, unsigned char mask);
+void sixteen_bit_update_flags(GB *gb, unsigned short value1, unsigned short value2, unsigned char mask);
+void request_interrupt (GB *gb, unsigned char bitSetter);
+void cpu_execution (GB *gb);
+unsigned long cpu_run(GB *gb, unsigned long max_instructions, int stop_pc);
+unsigned long cpu_run_cycles(GB *gb, unsigned long cycles, int stop_pc);
 #endif
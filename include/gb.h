@@ -0,0 +1,100 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  gb.h
+ *
+ *    Description:  Header for the emulator instance, every piece of state one Game Boy
+ *                  needs lives in a single GB struct so many can run in one process
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 20:52:13
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Matt Gercz (matt.gercz@icloud.com)
+ *
+ * =====================================================================================
+ */
+
+#ifndef MATTYGBOY_GB_H
+#define MATTYGBOY_GB_H
+
+#include "register_structures.h"
+#include "memory.h"
+#include "cartridge.h"
+#include "cpu_emulator.h"
+#include "scheduler.h"
+#include "timers.h"
+#include "graphics.h"
+#include "idle_loop.h"
+#include "serial.h"
+#include "joypad.h"
+#ifdef JIT
+#include "jit.h"
+#elif defined(BLOCK_CACHE)
+#include "block_cache.h"
+#endif
+
+struct GB
+{
+	Registers regs; // First, translated code reaches the instance through rbx
+	Machine_Clock clock;
+	Scheduler scheduler;
+	Timers timers;
+	LCD lcd;
+#ifdef LAZY_FLAGS
+	Lazy_Flags lazy;
+	Lazy_Flags_Stats lazy_flags_stats;
+#endif
+	Halt_Stats halt_stats;
+	Idle_Loops idle_loops;
+	Idle_Loop_Stats idle_loop_stats;
+
+	// One entry per 256 byte page, NULL write pages go through decode_write
+	unsigned char *read_pages[0x100];
+	unsigned char *write_pages[0x100];
+
+	// Track ROM and RAM banking
+	Cartridge *cartridge; // Shared by the instances running the same rom file
+	unsigned char *ext_ram_bank; // Points at ext_ram when the cartridge has RAM
+	MBC_Registers *mbc; // Points at mbc_registers when the cartridge has an MBC
+	MBC_Registers mbc_registers;
+	unsigned char banking_mode;
+	unsigned char boot_up; // Set while the boot ROM is mapped in
+	unsigned char rom_write; // Target of read-modify-write instructions on ROM
+
+	unsigned char buttons; // Held by the host, directions in the low nibble
+	int breakpoint; // PC runs started through the library stop at, -1 for none
+	unsigned long instructions; // Executed by runs started through the library
+	unsigned char locked_up; // Set by an opcode the cpu doesn't have, runs stop there
+
+#ifdef JIT
+	JIT_Cache *jit; // Allocated the first time a block is translated
+	unsigned char jit_unavailable; // Set when no executable memory could be had
+	JIT_Stats jit_stats;
+	unsigned char code_lines[0x1000]; // Nonzero for every 16-byte line of RAM with cached code
+#elif defined(BLOCK_CACHE)
+	Block_Cache *block_cache; // Allocated the first time a block is decoded
+	Block_Cache_Stats block_cache_stats;
+	unsigned char code_lines[0x1000]; // Nonzero for every 16-byte line of RAM with cached code
+#endif
+
+	unsigned char memory[0x10000];
+	unsigned char boot_rom[0x100];
+	unsigned char disabled_ram[0x100]; // Read in place of external RAM when disabled
+	unsigned char ext_ram[0x20000]; // Single array to virtualize all RAM banks
+	unsigned char framebuffer[SCREEN_WIDTH * SCREEN_HEIGHT]; // Shade 0-3 of each pixel
+	unsigned char pixel_indices[SCREEN_WIDTH * SCREEN_HEIGHT]; // Colour 0-3 of each pixel before its palette
+	Tile_Cache tile_cache;
+	Line_Cache line_cache;
+	Serial serial;
+};
+
+typedef struct Snapshot Snapshot;
+
+GB* init_gb();
+void free_gb(GB *gb);
+Snapshot* take_snapshot(GB *gb);
+GB* fork_snapshot(Snapshot *snapshot);
+void free_snapshot(Snapshot *snapshot);
+#endif
@@ -18,14 +18,11 @@
 #include "register_structures.h"
 #include "helper_functions.h"
 #include "memory.h"
+#include "gb.h"
 
 #ifndef GLOBALDECLARATIONS
 #define GLOBALDECLARATIONS
 
 extern unsigned char error_value;
-extern unsigned char boot_up;
-extern Registers *regs; // Pointer to the general registers
-extern Pointers *ptrs; // Pointer to stack pointer and program counter
-extern CPU_Flags *flags; // Pointer to the cpu flags
 
 #endif
@@ -18,5 +18,46 @@
 
 #ifndef MATTYGBOY_GRAPHICS_H
 #define MATTYGBOY_GRAPHICS_H
-void update_graphics(unsigned char cycles);
+
+typedef struct GB GB;
+
+#define SCREEN_WIDTH 0xA0
+#define SCREEN_HEIGHT 0x90
+
+#define VRAM_TILES 0x180 // 0x8000-0x97FF
+#define TILE_PIXELS 0x40
+
+// Tiles decoded to one byte per pixel, so lines are drawn by copying
+typedef struct Tile_Cache
+{
+	unsigned char pixels[VRAM_TILES][TILE_PIXELS];
+	unsigned char valid[VRAM_TILES]; // Cleared by writes to the tile
+} Tile_Cache;
+
+// LCDC, SCY, SCX, BGP, OBP0, OBP1, WY and WX, bit n stands for 0xFF40 + n
+#define LCD_VISIBLE_REGISTERS 0xF8Du
+
+// What each line was last drawn from, lines nothing was written under since are kept
+typedef struct Line_Cache
+{
+	unsigned long writes; // Counts writes that changed VRAM, OAM or a visible lcd register
+	unsigned long line_writes[SCREEN_HEIGHT]; // writes when each line was drawn
+	unsigned char line_window[SCREEN_HEIGHT]; // Window line each line was drawn with
+	unsigned char frame_drawn; // Set once a line of the frame being drawn changes
+	unsigned char frame_unchanged; // Set when the last finished frame matched the one before
+} Line_Cache;
+
+typedef struct LCD
+{
+	unsigned char on;
+	unsigned char mode; // Kept here since programs may write over STAT
+	unsigned char window_line; // Line of the window drawn next, it only moves while shown
+} LCD;
+
+int is_lcd_enabled(GB *gb);
+void init_graphics(GB *gb);
+void invalidate_graphics(GB *gb);
+void lcd_control_changed(GB *gb);
+void lcd_event(GB *gb, unsigned long due);
+unsigned long next_vblank(GB *gb);
 #endif
\ No newline at end of file
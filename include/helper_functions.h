@@ -17,8 +17,11 @@
 
 #ifndef HELPERFUNCTIONS
 #define HELPERFUNCTIONS
+
+typedef struct GB GB;
+
 unsigned short combine_bytes(unsigned char byte1, unsigned char byte2);
 void split_bytes(unsigned short value, unsigned char *addr1, unsigned char *addr2);
-void dump_registers();
-void dump_memory(unsigned short start, unsigned short end);
+void dump_registers(GB *gb);
+void dump_memory(GB *gb, unsigned short start, unsigned short end);
 #endif
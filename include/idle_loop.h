@@ -0,0 +1,64 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  idle_loop.h
+ *
+ *    Description:  Header for the detection of loops that busy-wait on i/o registers
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 18:31:44
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Matt Gercz (matt.gercz@icloud.com)
+ *
+ * =====================================================================================
+ */
+
+#ifndef MATTYGBOY_IDLE_LOOP_H
+#define MATTYGBOY_IDLE_LOOP_H
+
+#define LOOP_BUCKETS 0x400
+#define MAX_REPORTED 0x40
+
+typedef struct GB GB;
+
+typedef struct Idle_Loop
+{
+	unsigned int key; // ROM bank in the upper half, address in the lower
+	unsigned short end; // One past the branch back to the start
+	unsigned char checked;
+	unsigned char iteration_cycles; // 0 when the loop isn't idle
+	int report; // Index into reported, -1 if the loop isn't listed
+} Idle_Loop;
+
+typedef struct Idle_Loop_Report
+{
+	unsigned int key;
+	unsigned char iteration_cycles;
+	unsigned long skips; // Times the loop was fast-forwarded
+	unsigned long cycles_skipped;
+} Idle_Loop_Report;
+
+typedef struct Idle_Loops
+{
+	Idle_Loop loops[LOOP_BUCKETS];
+	Idle_Loop_Report reported[MAX_REPORTED];
+	unsigned int reported_count;
+	// The loop whose last iteration may have run without an event, and the event then due
+	unsigned int confirming_key;
+	unsigned long confirming_event;
+} Idle_Loops;
+
+typedef struct Idle_Loop_Stats
+{
+	unsigned long loops_detected; // Distinct loops found to only poll i/o registers
+	unsigned long iterations_skipped;
+	unsigned long cycles_skipped; // Cycles jumped over instead of emulated
+} Idle_Loop_Stats;
+
+void init_idle_loops(GB *gb);
+int is_idle_loop(GB *gb, unsigned short start, unsigned short end);
+void idle_loop_branch(GB *gb, unsigned short start, unsigned short end);
+void print_idle_loops(GB *gb);
+#endif
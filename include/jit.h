@@ -0,0 +1,38 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  jit.h
+ *
+ *    Description:  Header for the x86-64 dynamic recompiler of hot basic blocks
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 13:20:51
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Matt Gercz (matt.gercz@icloud.com)
+ *
+ * =====================================================================================
+ */
+
+#ifndef MATTYGBOY_JIT_H
+#define MATTYGBOY_JIT_H
+
+typedef struct GB GB;
+
+// Translated blocks of one instance, allocated the first time it runs a block
+typedef struct JIT_Cache JIT_Cache;
+
+typedef struct JIT_Stats
+{
+	unsigned long blocks_compiled;
+	unsigned long blocks_executed;
+	unsigned long instructions_executed; // Instructions run as native code
+	unsigned long invalidations; // Blocks dropped because their RAM was written
+} JIT_Stats;
+
+unsigned int jit_execute(GB *gb, unsigned long max_instructions, int stop_pc);
+void jit_invalidate(GB *gb, unsigned short addr);
+void jit_flush(GB *gb);
+void jit_free(GB *gb);
+#endif
@@ -0,0 +1,27 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  joypad.h
+ *
+ *    Description:  Header for the joypad, the buttons the host holds down as seen
+ *                  through P1
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026 02:05:31
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Matt Gercz (matt.gercz@icloud.com)
+ *
+ * =====================================================================================
+ */
+
+#ifndef MATTYGBOY_JOYPAD_H
+#define MATTYGBOY_JOYPAD_H
+
+typedef struct GB GB;
+
+unsigned char read_joypad(GB *gb);
+void write_joypad(GB *gb, unsigned char data);
+void set_buttons(GB *gb, unsigned char buttons);
+#endif
@@ -18,9 +18,6 @@
 
 #ifndef LOGICALINSTRUCTIONS
 #define LOGICALINSTRUCTIONS
-unsigned char and(unsigned char opcode);
-unsigned char or(unsigned char opcode);
-unsigned char xor(unsigned char opcode);
-unsigned char daa();
-unsigned char cpl();
+#include "cpu_emulator.h"
+void register_logical_instructions(Opcode *table);
 #endif
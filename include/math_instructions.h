@@ -17,13 +17,6 @@
 
 #ifndef MATHINSTRUCTIONS
 #define MATHINSTRUCTIONS
-unsigned char eight_bit_add(unsigned char opcode);
-unsigned char sixteen_bit_add(unsigned char opcode);
-unsigned char adc(unsigned char opcode);
-unsigned char sub(unsigned char opcode);
-unsigned char sbc(unsigned char opcode);
-unsigned char eight_bit_inc(unsigned char opcode);
-unsigned char sixteen_bit_inc(unsigned char opcode);
-unsigned char eight_bit_dec(unsigned char opcode);
-unsigned char sixteen_bit_dec(unsigned char opcode);
+#include "cpu_emulator.h"
+void register_math_instructions(Opcode *table);
 #endif
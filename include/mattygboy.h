@@ -0,0 +1,87 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  mattygboy.h
+ *
+ *    Description:  Public interface of the MattyGBoy library, for programs that embed
+ *                  emulators. Every function works on its own instance, so instances
+ *                  may be run from different threads
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 21:37:05
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Matt Gercz (matt.gercz@icloud.com)
+ *
+ * =====================================================================================
+ */
+
+#ifndef MATTYGBOY_H
+#define MATTYGBOY_H
+
+typedef struct GB GB;
+typedef struct Snapshot Snapshot;
+typedef struct Rewind Rewind;
+typedef struct Movie Movie;
+
+#define MATTYGBOY_SCREEN_WIDTH 0xA0
+#define MATTYGBOY_SCREEN_HEIGHT 0x90
+
+// Buttons for mattygboy_set_buttons, set bits are held down
+#define MATTYGBOY_BUTTON_RIGHT 0x01u
+#define MATTYGBOY_BUTTON_LEFT 0x02u
+#define MATTYGBOY_BUTTON_UP 0x04u
+#define MATTYGBOY_BUTTON_DOWN 0x08u
+#define MATTYGBOY_BUTTON_A 0x10u
+#define MATTYGBOY_BUTTON_B 0x20u
+#define MATTYGBOY_BUTTON_SELECT 0x40u
+#define MATTYGBOY_BUTTON_START 0x80u
+
+// CPU registers copied out by mattygboy_get_registers, the flags are the upper nibble of AF
+typedef struct Register_Values
+{
+	unsigned short AF, BC, DE, HL, SP, PC;
+	unsigned char IME;
+} Register_Values;
+
+// Gets each byte sent over the serial cable, see mattygboy_set_serial_callback
+typedef void (*mattygboy_serial_callback)(void *context, unsigned char data);
+
+GB* mattygboy_create(const unsigned char *rom, unsigned long size);
+GB* mattygboy_open(const char *file);
+int mattygboy_reset(GB *gb, const char *boot_rom_file);
+void mattygboy_destroy(GB *gb);
+Snapshot* mattygboy_snapshot(GB *gb);
+GB* mattygboy_fork(Snapshot *snapshot);
+void mattygboy_free_snapshot(Snapshot *snapshot);
+unsigned long mattygboy_run_cycles(GB *gb, unsigned long cycles);
+unsigned long mattygboy_run_frame(GB *gb);
+unsigned long mattygboy_cycles_to_frame(GB *gb);
+void mattygboy_set_breakpoint(GB *gb, int pc);
+int mattygboy_at_breakpoint(GB *gb);
+int mattygboy_is_stuck(GB *gb);
+int mattygboy_is_locked_up(GB *gb);
+unsigned long mattygboy_get_cycles(GB *gb);
+unsigned long mattygboy_get_instructions(GB *gb);
+void mattygboy_get_registers(GB *gb, Register_Values *values);
+const unsigned char* mattygboy_get_framebuffer(GB *gb);
+const unsigned char* mattygboy_get_pixel_indices(GB *gb);
+int mattygboy_frame_unchanged(GB *gb);
+unsigned long mattygboy_drain_serial(GB *gb, unsigned char *buffer, unsigned long size);
+void mattygboy_set_serial_callback(GB *gb, mattygboy_serial_callback callback, void *context);
+void mattygboy_set_buttons(GB *gb, unsigned char buttons);
+unsigned long mattygboy_save_state(GB *gb, unsigned char *buffer, unsigned long size);
+int mattygboy_load_state(GB *gb, const unsigned char *buffer, unsigned long size);
+Rewind* mattygboy_rewind_create(unsigned long buffer_size, unsigned int frames_per_entry);
+void mattygboy_rewind_free(Rewind *rewind);
+int mattygboy_rewind_record(Rewind *rewind, GB *gb);
+long mattygboy_rewind(Rewind *rewind, GB *gb, unsigned long frames);
+Movie* mattygboy_movie_record(GB *gb, unsigned int hash_interval);
+int mattygboy_movie_input(Movie *movie, GB *gb, unsigned char buttons);
+int mattygboy_movie_frame(Movie *movie, GB *gb);
+unsigned long mattygboy_movie_save(Movie *movie, unsigned char *buffer, unsigned long size);
+Movie* mattygboy_movie_load(const unsigned char *buffer, unsigned long size);
+long mattygboy_movie_replay(Movie *movie, GB *gb);
+void mattygboy_movie_free(Movie *movie);
+#endif
@@ -18,6 +18,8 @@
 #ifndef MEMORY
 #define MEMORY
 
+typedef struct GB GB;
+
 typedef struct MBC_Registers
 {
 	unsigned char ram_enable; // Must be !0 in order to read/write external RAM
@@ -27,15 +29,17 @@ typedef struct MBC_Registers
 	unsigned char ram_rom_select; // Set to 1 if ROM mode, 0 for RAM
 } MBC_Registers;
 
-static unsigned char *memory;
-static unsigned char *cartridge;
-static unsigned char *boot_rom;
-MBC_Registers* init_mbc();
-void init_memory();
-void write_memory(unsigned short addr, unsigned char data);
-void increment_divider();
-void increment_scanline();
-unsigned char read_memory(unsigned short addr);
-unsigned char* read_memory_ptr(unsigned short addr);
-void load_cartridge(char *file);
+void init_mbc(GB *gb);
+void init_memory(GB *gb, const unsigned char *boot_rom);
+void write_memory(GB *gb, unsigned short addr, unsigned char data);
+void increment_scanline(GB *gb);
+unsigned char read_memory(GB *gb, unsigned short addr);
+unsigned char current_rom_bank(GB *gb);
+unsigned int code_region(GB *gb, unsigned short addr, unsigned int *key);
+unsigned char* read_memory_ptr(GB *gb, unsigned short addr);
+unsigned char* decode_read(GB *gb, unsigned short addr);
+void decode_write(GB *gb, unsigned short addr, unsigned char data);
+void update_memory_map(GB *gb);
+int load_cartridge(GB *gb, const char *file);
+int load_cartridge_data(GB *gb, const unsigned char *data, unsigned long size);
 #endif
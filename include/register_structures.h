@@ -19,27 +19,39 @@
 #ifndef REGISTERSTRUCTURES
 #define REGISTERSTRUCTURES
 
-typedef struct Registers 
-{
-	unsigned char A, B, C, D, E, H, L;
-} Registers;
+// Bits of the F register: zero, subtract, half-carry, and carry flags
+#define FLAG_Z 0x80u
+#define FLAG_N 0x40u
+#define FLAG_H 0x20u
+#define FLAG_C 0x10u
+
+// Names a 16-bit register pair and its two halves, which share the same storage
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define REGISTER_PAIR(pair, high, low) \
+	union { unsigned short pair; struct { unsigned char high, low; }; }
+#else
+#define REGISTER_PAIR(pair, high, low) \
+	union { unsigned short pair; struct { unsigned char low, high; }; }
+#endif
 
-typedef struct Pointers 
+typedef struct Registers 
 {
+	// Every register fits in a single cache line, pairs can be used as one value
+	_Alignas(0x40) REGISTER_PAIR(AF, A, F);
+	REGISTER_PAIR(BC, B, C);
+	REGISTER_PAIR(DE, D, E);
+	REGISTER_PAIR(HL, H, L);
 	// Two 16-bit registers are used for stack pointer and program counter
 	unsigned short SP, PC;
-} Pointers;
-
-typedef struct CPU_Flags 
-{
-	// Z, N, H, and C are the zero, subtract, half-carry, carry flags respectively
 	// IME is the interrupt master enable
-	// jumped set when an instruction sets the PC and cleared after each cycle
-	unsigned char Z, N, H, C, IME;
-} CPU_Flags;
+	unsigned char IME;
+} Registers;
+
+// Reads and writes single flags in F, value is treated as true or false
+#define get_flag(flag) ((gb->regs.F & (flag)) != 0x0)
+#define set_flag(flag, value) \
+	(gb->regs.F = (unsigned char) ((value) ? gb->regs.F | (flag) : gb->regs.F & ~(flag)))
 
-Registers* init_registers();
-CPU_Flags* init_flags();
-Pointers* init_pointers();
+void init_registers(Registers *r);
 
 #endif
@@ -0,0 +1,64 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  runner.h
+ *
+ *    Description:  Header for running a rom without a screen until a stop condition
+ *                  is met, shared by MattyGBoy and the test rom runner
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 23:04:19
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Matt Gercz (matt.gercz@icloud.com)
+ *
+ * =====================================================================================
+ */
+
+#ifndef MATTYGBOY_RUNNER_H
+#define MATTYGBOY_RUNNER_H
+
+#include <stdio.h>
+
+#define SERIAL_LOG_LIMIT 0x10000 // Bytes of serial output a result keeps, the newest win
+
+typedef struct GB GB;
+
+// Why a run stopped, doubling as the exit code. EXIT_FAILURE is kept for bad
+// arguments and roms
+typedef enum
+{
+	RUN_PASSED = 0x0, // Reached the PC breakpoint or printed the pass string
+	RUN_FAILED = 0x2, // Printed the fail string
+	RUN_LIMIT = 0x3, // Ran out of cycles or frames
+	RUN_STUCK = 0x4, // Entered a loop it can never leave
+	RUN_LOCKED_UP = 0x5 // Ran an opcode the cpu doesn't have
+} Run_Outcome;
+
+typedef struct Run_Options
+{
+	unsigned long max_cycles; // ULONG_MAX for no limit
+	unsigned long max_frames;
+	int stop_pc; // -1 for none
+	const char *pass_string; // NULL for none
+	const char *fail_string;
+	int stop_when_stuck;
+} Run_Options;
+
+typedef struct Run_Result
+{
+	Run_Outcome outcome;
+	unsigned long cycles;
+	unsigned long frames;
+	double seconds; // Wall time
+	unsigned char *serial; // Output sent over the serial cable, freed by free_run_result
+	unsigned long serial_length;
+} Run_Result;
+
+Run_Result run_headless(GB *gb, const Run_Options *options);
+void free_run_result(Run_Result *result);
+const char* run_outcome_name(Run_Outcome outcome);
+void print_json_bytes(FILE *out, const unsigned char *data, unsigned long length);
+void print_run_json(FILE *out, const char *rom, GB *gb, const Run_Result *result);
+#endif
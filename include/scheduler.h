@@ -0,0 +1,72 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  scheduler.h
+ *
+ *    Description:  Header for the event scheduler that drives the timers and the lcd
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 19:41:26
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Matt Gercz (matt.gercz@icloud.com)
+ *
+ * =====================================================================================
+ */
+
+#ifndef MATTYGBOY_SCHEDULER_H
+#define MATTYGBOY_SCHEDULER_H
+
+typedef struct GB GB;
+
+// Every kind of future event, at most one of each is scheduled at a time
+typedef enum Event_Type
+{
+	EVENT_TIMER, // TIMA overflows and reloads from TMA
+	EVENT_LCD, // The lcd changes mode, LY increments at the end of a line
+	EVENT_SERIAL, // A serial transfer finishes
+	EVENT_COUNT
+} Event_Type;
+
+// Handlers get the cycle the event was due on, which may be before the current cycle
+typedef void (*event_handler)(GB *gb, unsigned long due);
+
+typedef struct Machine_Clock
+{
+	unsigned long cycles; // Clock cycles since the machine was reset
+	unsigned long next_event; // Cycle the earliest scheduled event is due on
+	unsigned long run_until; // HALT and idle loops don't skip past the end of a run
+} Machine_Clock;
+
+typedef struct Event
+{
+	unsigned long due;
+	Event_Type type;
+} Event;
+
+// Min-heap of scheduled events ordered by due cycle
+typedef struct Scheduler
+{
+	Event heap[EVENT_COUNT];
+	unsigned int heap_size;
+	int heap_index[EVENT_COUNT]; // Position of each type in the heap, -1 if not there
+} Scheduler;
+
+// Called after every instruction, only does work once the next event is due
+#define advance_clock(elapsed) \
+	do { \
+		gb->clock.cycles += (elapsed); \
+		if (gb->clock.cycles >= gb->clock.next_event) \
+		{ \
+			run_events(gb); \
+		} \
+	} while (0)
+
+void init_scheduler(GB *gb);
+void schedule_event(GB *gb, Event_Type type, unsigned long due);
+void cancel_event(GB *gb, Event_Type type);
+unsigned long event_due(GB *gb, Event_Type type);
+void run_events(GB *gb);
+unsigned long skip_to_next_event(GB *gb, unsigned long limit);
+#endif
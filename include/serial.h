@@ -0,0 +1,43 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  serial.h
+ *
+ *    Description:  Header for the serial port, bytes sent over the link cable are
+ *                  kept in a ring buffer for the host to drain
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 23:41:50
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Matt Gercz (matt.gercz@icloud.com)
+ *
+ * =====================================================================================
+ */
+
+#ifndef MATTYGBOY_SERIAL_H
+#define MATTYGBOY_SERIAL_H
+
+#define SERIAL_BUFFER_SIZE 0x1000 // Power of two
+#define SERIAL_TRANSFER_CYCLES 0x1000 // 8 bits at 8192 Hz
+
+typedef struct GB GB;
+
+typedef void (*serial_callback)(void *context, unsigned char data);
+
+typedef struct Serial
+{
+	unsigned long sent; // Bytes sent since the instance was made, the ring index is this mod the size
+	unsigned long drained; // Bytes the host has taken, the oldest are dropped once the ring is full
+	unsigned char sending; // SB when the transfer in flight started
+	serial_callback callback; // Called with each byte as it's sent, NULL for none
+	void *context;
+	unsigned char buffer[SERIAL_BUFFER_SIZE];
+} Serial;
+
+void init_serial(GB *gb);
+void write_serial_control(GB *gb, unsigned char data);
+void serial_event(GB *gb, unsigned long due);
+unsigned long drain_serial(GB *gb, unsigned char *buffer, unsigned long size);
+#endif
@@ -0,0 +1,25 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  state.h
+ *
+ *    Description:  Header for saving and restoring the state of an emulator instance
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 21:37:05
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Matt Gercz (matt.gercz@icloud.com)
+ *
+ * =====================================================================================
+ */
+
+#ifndef MATTYGBOY_STATE_H
+#define MATTYGBOY_STATE_H
+
+typedef struct GB GB;
+
+unsigned long save_state(GB *gb, unsigned char *buffer, unsigned long size);
+int load_state(GB *gb, const unsigned char *buffer, unsigned long size);
+#endif
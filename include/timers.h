@@ -18,6 +18,23 @@
 
 #ifndef MATTYGBOY_TIMERS_H
 #define MATTYGBOY_TIMERS_H
-void update_timers(unsigned char cycles);
-void increment_timer();
+
+typedef struct GB GB;
+
+// DIV is the upper byte of a counter that starts at divider_base, TIMA increments
+// whenever that counter passes a multiple of the TAC period
+typedef struct Timers
+{
+	unsigned long divider_base;
+	unsigned long timer_base; // Cycle TIMA last held timer_value
+	unsigned char timer_value;
+	unsigned char timer_control; // Copies of TAC and TMA
+	unsigned char timer_modulo;
+} Timers;
+
+void init_timers(GB *gb);
+unsigned char read_divider(GB *gb);
+unsigned char read_timer_counter(GB *gb);
+void write_timer_register(GB *gb, unsigned short addr, unsigned char data);
+void timer_event(GB *gb, unsigned long due);
 #endif
@@ -18,6 +18,7 @@
 #include <math.h>
 #include "global_declarations.h"
 #include "helper_functions.h"
+#include "bit_rotate_shift_instructions.h"
 
 /*
  * ===  FUNCTION  ======================================================================
@@ -26,18 +27,19 @@
  *   Parameters:  reg is a pointer to the register to be rotated
  * =====================================================================================
  */
-        void
-rlc (unsigned char *reg)
+        static void
+rlc (GB *gb, unsigned char *reg)
 {
 	// Clears N and H flags
-	flags->N = 0x0; flags->H = 0x0;
+	sync_flags(gb, FLAG_Z | FLAG_H | FLAG_C);
+	gb->regs.F &= ~(FLAG_N | FLAG_H);
 
 	// Each bit of A shifts left one with bit 7 shifting
 	// into C AND bit 0
-	flags->C = *reg >> 0x7u;
+	set_flag(FLAG_C, *reg >> 0x7u);
 	*reg <<= 0x1u;
-	*reg |= flags->C; // Bit 0 is 0, since it's been filled in for the shift
-	flags->Z = (unsigned char) (*reg == 0x0 ? 0x1 : 0x0);
+	*reg |= get_flag(FLAG_C); // Bit 0 is 0, since it's been filled in for the shift
+	set_flag(FLAG_Z, *reg == 0x0);
 }               /* -----  end of function rlc  ----- */
 
 /*
@@ -47,18 +49,19 @@ rlc (unsigned char *reg)
  *   Parameters:  reg is a pointer to the register to be rotated
  * =====================================================================================
  */
-        void
-rl (unsigned char *reg)
+        static void
+rl (GB *gb, unsigned char *reg)
 {
-	// Clears N and H flags
-	flags->N = 0; flags->H = 0;
+	// Clears N and H flags, C is shifted in
+	sync_flags(gb, 0x0);
+	gb->regs.F &= ~(FLAG_N | FLAG_H);
 	// Each bit of register shifts left one with bit 0 shifting
 	// into C and C going into bit 7
-	unsigned char initial_c = flags->C;
-	flags->C = *reg >> 0x7u;
+	unsigned char initial_c = get_flag(FLAG_C);
+	set_flag(FLAG_C, *reg >> 0x7u);
 	*reg <<= 0x1u;
 	*reg |= initial_c;
-	flags->Z = (unsigned char) ((*reg == 0) ? 1 : 0);
+	set_flag(FLAG_Z, *reg == 0x0);
 }               /* -----  end of function rl  ----- */
 
 /*
@@ -68,19 +71,20 @@ rl (unsigned char *reg)
  *   Parameters:  reg is a pointer to the register to be rotated
  * =====================================================================================
  */
-        void
-rr (unsigned char *reg)
+        static void
+rr (GB *gb, unsigned char *reg)
 {
-	// Clears N and H flags
-	flags->N = 0; flags->H = 0;
+	// Clears N and H flags, C is shifted in
+	sync_flags(gb, 0x0);
+	gb->regs.F &= ~(FLAG_N | FLAG_H);
 
 	// Each bit of register shifts right one with bit 0 shifting
 	// into C and C goes into bit 7
-	unsigned char initial_c = flags->C;
-	flags->C = (unsigned char) (*reg & 0x1u);
+	unsigned char initial_c = get_flag(FLAG_C);
+	set_flag(FLAG_C, (unsigned char) (*reg & 0x1u));
 	*reg >>= 0x1u;
 	*reg |= (unsigned char)(initial_c << 0x7u);
-	flags->Z = (unsigned char) ((*reg == 0) ? 1 : 0);
+	set_flag(FLAG_Z, *reg == 0x0);
 }               /* -----  end of function rr  ----- */
 
 /* 
@@ -90,18 +94,19 @@ rr (unsigned char *reg)
  *   Parameters:  reg is a pointer to the register or memory location to be rotated
  * =====================================================================================
  */
-	void
-rrc (unsigned char *reg)
+	static void
+rrc (GB *gb, unsigned char *reg)
 {
 	// Clears N and H flags
-	flags->N = 0; flags->H = 0;
+	sync_flags(gb, FLAG_Z | FLAG_H | FLAG_C);
+	gb->regs.F &= ~(FLAG_N | FLAG_H);
 
 	// Each bit of register shifts right one with bit 0 shifting
 	// into C AND bit 7
-	flags->C = (unsigned char) (*reg & 0x1u);
+	set_flag(FLAG_C, (unsigned char) (*reg & 0x1u));
 	*reg >>= 0x1u;
-	*reg |= (unsigned char)(flags->C << 0x7u);
-	flags->Z = (unsigned char) ((*reg == 0) ? 1 : 0);
+	*reg |= (unsigned char)(get_flag(FLAG_C) << 0x7u);
+	set_flag(FLAG_Z, *reg == 0x0);
 }		/* -----  end of function rrc  ----- */
 
 
@@ -112,16 +117,17 @@ rrc (unsigned char *reg)
  *   Parameters:  reg is a pointer to the register/memory location to be shifted
  * =====================================================================================
  */
-	void
-sla (unsigned char *reg)
+	static void
+sla (GB *gb, unsigned char *reg)
 {
 	// N and H are cleared, C and Z set by result
-	flags->N = 0; flags->H = 0;
-	flags->C = (unsigned char) ((unsigned short) *reg << 0x1u > 0xFF ? 0x1 : 0x0);
+	sync_flags(gb, FLAG_Z | FLAG_H | FLAG_C);
+	gb->regs.F &= ~(FLAG_N | FLAG_H);
+	set_flag(FLAG_C, (unsigned char) ((unsigned short) *reg << 0x1u > 0xFF ? 0x1 : 0x0));
 
 	*reg <<= 0x1u;
 
-	flags->Z = (unsigned char) ((*reg) ? 0 : 1);
+	set_flag(FLAG_Z, *reg == 0x0);
 }		/* -----  end of function sla  ----- */
 
 /*
@@ -131,19 +137,20 @@ sla (unsigned char *reg)
  *   Parameters:  reg is a pointer to the register/memory location to be shifted
  * =====================================================================================
  */
-        void
-sra (unsigned char *reg)
+        static void
+sra (GB *gb, unsigned char *reg)
 {
 	// N and H are cleared, C and Z set by result
-    flags->N = 0; flags->H = 0;
-    flags->C = (unsigned char) ((unsigned short) *reg >> 0x1u > 0xFF ? 0x1 : 0x0);
+    sync_flags(gb, FLAG_Z | FLAG_H | FLAG_C);
+    gb->regs.F &= ~(FLAG_N | FLAG_H);
+    set_flag(FLAG_C, (unsigned char) ((unsigned short) *reg >> 0x1u > 0xFF ? 0x1 : 0x0));
 
 	// Need to convert the register to signed value so it will shift arithmetically
 	char reg_value = (char)(*reg);
 	reg_value >>= 1; // NOLINT
 	*reg = (unsigned char) reg_value;
 
-	flags->Z = (unsigned char) ((*reg) ? 0 : 1);
+	set_flag(FLAG_Z, *reg == 0x0);
 }               /* -----  end of function sra  ----- */
 
 /* 
@@ -153,8 +160,8 @@ sra (unsigned char *reg)
  *   Parameters:  reg is a pointer to the register/memory location to be swapped
  * =====================================================================================
  */
-        void
-swap (unsigned char *reg)
+        static void
+swap (GB *gb, unsigned char *reg)
 {
 	unsigned char low_nibble = (unsigned char) (*reg & 0xFu);
 	
@@ -171,16 +178,17 @@ swap (unsigned char *reg)
  *   Parameters:  reg is a pointer to the register/memory location to be shifted
  * =====================================================================================
  */
-        void
-srl (unsigned char *reg)
+        static void
+srl (GB *gb, unsigned char *reg)
 {
 	// N and H are cleared, C and Z set by result
-    flags->N = 0x0u; flags->H = 0x0u;
-    flags->C = (unsigned char) ((unsigned short) (*reg) << 0x1u > 0xFF ? 0x1u : 0x0u);
+    sync_flags(gb, FLAG_Z | FLAG_H | FLAG_C);
+    gb->regs.F &= ~(FLAG_N | FLAG_H);
+    set_flag(FLAG_C, (unsigned char) ((unsigned short) (*reg) << 0x1u > 0xFF ? 0x1u : 0x0u));
 
 	*reg >>= 0x1u;
         
-	flags->Z = (unsigned char) ((*reg) ? 0x0 : 0x1);
+	set_flag(FLAG_Z, *reg == 0x0);
 }               /* -----  end of function srl  ----- */
 
 /* 
@@ -190,18 +198,19 @@ srl (unsigned char *reg)
  *   Parameters:  reg is a pointer to the register/memory location to be bit tested
  * =====================================================================================
  */
-        void
-bit (unsigned char opcode, const unsigned char *reg)
+        static void
+bit (GB *gb, unsigned char opcode, const unsigned char *reg)
 {
 	// Bit to test is a function of the opcode
 	unsigned char bitmask = (unsigned char) ((opcode - 0x40) / 0x8);
 	bitmask = (unsigned char)pow(2, bitmask);
 
 	// BIT sets N to 0, H to 1
-	flags->N = 0x0; flags->H = 0x1;
+	sync_flags(gb, FLAG_Z | FLAG_H);
+	gb->regs.F = (unsigned char) ((gb->regs.F & ~FLAG_N) | FLAG_H);
 
 	// Z is 0 if bit is not 0, else 1
-	flags->Z = (unsigned char) ((*reg & bitmask) ? 0x0 : 0x1);
+	set_flag(FLAG_Z, !(*reg & bitmask));
 }               /* -----  end of function bit  ----- */
 
 /*
@@ -211,8 +220,8 @@ bit (unsigned char opcode, const unsigned char *reg)
  *   Parameters:  reg is a pointer to the register/memory location to be bit reset
  * =====================================================================================
  */
-        void
-res (unsigned char opcode, unsigned char *reg)
+        static void
+res (GB *gb, unsigned char opcode, unsigned char *reg)
 {
 	unsigned char bitmask = (unsigned char) ((opcode - 0x40) / 0x8);
 	bitmask ^= 0xFFu;
@@ -228,8 +237,8 @@ res (unsigned char opcode, unsigned char *reg)
  *   Parameters:  reg is a pointer to the register/memory location to be bit set
  * =====================================================================================
  */
-        void
-set (unsigned char opcode, unsigned char *reg)
+        static void
+set (GB *gb, unsigned char opcode, unsigned char *reg)
 {
 	unsigned char bit = (unsigned char) ((opcode - 0x40) / 0x8);
 	
@@ -237,107 +246,122 @@ set (unsigned char opcode, unsigned char *reg)
 	*reg |= (unsigned char)pow(2, bit);
 }               /* -----  end of function set  ----- */
 
+// Rotates of register A, which always clear the Z flag
+#define ROTATE_A_HANDLER(instruction) \
+	static unsigned char instruction##a(GB *gb, unsigned short operand) \
+	{ instruction(gb, &gb->regs.A); gb->regs.F &= ~FLAG_Z; return 0x4; }
+
+ROTATE_A_HANDLER(rlc)
+ROTATE_A_HANDLER(rrc)
+ROTATE_A_HANDLER(rl)
+ROTATE_A_HANDLER(rr)
+
+#define CB_CALL(instruction, ...) instruction(gb, __VA_ARGS__)
+
+// The CB opcodes apply each instruction to B, C, D, E, H, L, memory[HL], A in turn,
+// bit/res/set get the opcode of their row so they know which bit to work on
+#define CB_HANDLERS(handler, ...) \
+	static unsigned char handler##_b(GB *gb, unsigned short operand) \
+	{ CB_CALL(__VA_ARGS__, &gb->regs.B); return 0x8; } \
+	static unsigned char handler##_c(GB *gb, unsigned short operand) \
+	{ CB_CALL(__VA_ARGS__, &gb->regs.C); return 0x8; } \
+	static unsigned char handler##_d(GB *gb, unsigned short operand) \
+	{ CB_CALL(__VA_ARGS__, &gb->regs.D); return 0x8; } \
+	static unsigned char handler##_e(GB *gb, unsigned short operand) \
+	{ CB_CALL(__VA_ARGS__, &gb->regs.E); return 0x8; } \
+	static unsigned char handler##_h(GB *gb, unsigned short operand) \
+	{ CB_CALL(__VA_ARGS__, &gb->regs.H); return 0x8; } \
+	static unsigned char handler##_l(GB *gb, unsigned short operand) \
+	{ CB_CALL(__VA_ARGS__, &gb->regs.L); return 0x8; } \
+	static unsigned char handler##_hl(GB *gb, unsigned short operand) \
+	{ CB_CALL(__VA_ARGS__, read_memory_ptr(gb, gb->regs.HL)); return 0x10; } \
+	static unsigned char handler##_a(GB *gb, unsigned short operand) \
+	{ CB_CALL(__VA_ARGS__, &gb->regs.A); return 0x8; }
+
+#define REGISTER_CB_HANDLERS(table, opcode, handler) \
+	table[(opcode) + 0x0] = handler##_b; \
+	table[(opcode) + 0x1] = handler##_c; \
+	table[(opcode) + 0x2] = handler##_d; \
+	table[(opcode) + 0x3] = handler##_e; \
+	table[(opcode) + 0x4] = handler##_h; \
+	table[(opcode) + 0x5] = handler##_l; \
+	table[(opcode) + 0x6] = handler##_hl; \
+	table[(opcode) + 0x7] = handler##_a
+
+#define CB_BIT_HANDLERS(bit_number) \
+	CB_HANDLERS(bit_##bit_number, bit, 0x40 + 0x8 * (bit_number)) \
+	CB_HANDLERS(res_##bit_number, res, 0x80 + 0x8 * (bit_number)) \
+	CB_HANDLERS(set_##bit_number, set, 0xC0 + 0x8 * (bit_number))
+
+#define REGISTER_CB_BIT_HANDLERS(table, bit_number) \
+	REGISTER_CB_HANDLERS(table, 0x40 + 0x8 * (bit_number), bit_##bit_number); \
+	REGISTER_CB_HANDLERS(table, 0x80 + 0x8 * (bit_number), res_##bit_number); \
+	REGISTER_CB_HANDLERS(table, 0xC0 + 0x8 * (bit_number), set_##bit_number)
+
+CB_HANDLERS(rlc, rlc)
+CB_HANDLERS(rrc, rrc)
+CB_HANDLERS(rl, rl)
+CB_HANDLERS(rr, rr)
+CB_HANDLERS(sla, sla)
+CB_HANDLERS(sra, sra)
+CB_HANDLERS(swap, swap)
+CB_HANDLERS(srl, srl)
+CB_BIT_HANDLERS(0)
+CB_BIT_HANDLERS(1)
+CB_BIT_HANDLERS(2)
+CB_BIT_HANDLERS(3)
+CB_BIT_HANDLERS(4)
+CB_BIT_HANDLERS(5)
+CB_BIT_HANDLERS(6)
+CB_BIT_HANDLERS(7)
+
 /* 
  * ===  FUNCTION  ======================================================================
- *         Name:  bit_rotate_shift
+ *         Name:  prefix_cb
  *  Description:  Translates the much-abused CB opcode into its appropriate intsruction
- *  		      and calls executing function
+ *  		      and calls its handler
+ *   Parameters:  operand is the byte following the CB prefix
  *       Return:  The number of clock cycles to execute this instruction
  * =====================================================================================
  */
-	unsigned char
-bit_rotate_shift (unsigned char opcode)
+	static unsigned char
+prefix_cb (GB *gb, unsigned short operand)
 {
-	unsigned char cycles;
-	// For ones where memory[HL] is needed
-    unsigned short reg_hl = combine_bytes(regs->H, regs->L);
-	
-	// The affected registers/memory depend on the 4 lsb of the opcode
-	unsigned char *argument;
-	unsigned char arg_nibble = (unsigned char) (opcode & 0xFu);
-
-	switch (arg_nibble)
-	{
-		case 0x00:
-		case 0x08:
-			argument = &regs->B;
-            cycles = 0x8;
-			break;
-		case 0x01:
-		case 0x09:
-			argument = &regs->C;
-            cycles = 0x8;
-			break;
-		case 0x02:
-		case 0x0A:
-			argument = &regs->D;
-            cycles = 0x8;
-			break;
-		case 0x03:
-		case 0x0B:
-			argument = &regs->E;
-            cycles = 0x8;
-			break;
-		case 0x04:
-		case 0x0C:
-			argument = &regs->H;
-            cycles = 0x8;
-			break;
-		case 0x05:
-		case 0x0D:
-			argument = &regs->L;
-            cycles = 0x8;
-			break;
-		case 0x06:
-		case 0x0E:
-			argument = read_memory_ptr(reg_hl);
-            cycles = 0x10;
-			break;
-		case 0x07:
-		case 0x0F:
-			argument = &regs->A;
-            cycles = 0x8;
-			break;
-        default:
-            return 0x0;
-	}
-
-	switch (opcode)
-	{
-		case 0x00 ... 0x07:
-			rlc(argument);
-			return cycles;
-		case 0x08 ... 0x0F:
-			rrc(argument);
-			return cycles;
-		case 0x10 ... 0x17:
-			rl(argument);
-			return cycles;
-		case 0x18 ... 0x1F:
-			rr(argument);
-			return cycles;
-		case 0x20 ... 0x27:
-			sla(argument);
-			return cycles;
-		case 0x28 ... 0x2F:
-			sra(argument);
-			return cycles;
-		case 0x30 ... 0x37:
-			swap(argument);
-			return cycles;
-		case 0x38 ... 0x3F:
-			srl(argument);
-			return cycles;
-		case 0x40 ... 0x7F:
-			bit(opcode, argument);
-			return cycles;
-		case 0x80 ... 0xBF:
-			res(opcode, argument);
-			return cycles;
-		case 0xC0 ... 0xFF:
-			set(opcode, argument);
-			return cycles;
-		default:
-			return 0x0 ;
-	}
-}		/* -----  end of function bit_rotate_shift  ----- */
+	return cb_opcode_table[operand](gb, operand);
+}		/* -----  end of function prefix_cb  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  register_bit_rotate_shift_instructions
+ *  Description:  Places the handlers for the rotate A opcodes and the CB prefix in the
+ *                opcode table, and the handlers for every CB opcode in the CB table
+ *   Parameters:  table is the 256 entry opcode table to fill in
+ *                cb_table is the 256 entry table of CB prefixed opcodes to fill in
+ * =====================================================================================
+ */
+	void
+register_bit_rotate_shift_instructions (Opcode *table, opcode_handler *cb_table)
+{
+	table[0x07] = (Opcode) {rlca, 0x0};
+	table[0x0F] = (Opcode) {rrca, 0x0};
+	table[0x17] = (Opcode) {rla, 0x0};
+	table[0x1F] = (Opcode) {rra, 0x0};
+	table[0xCB] = (Opcode) {prefix_cb, 0x1};
+
+	REGISTER_CB_HANDLERS(cb_table, 0x00, rlc);
+	REGISTER_CB_HANDLERS(cb_table, 0x08, rrc);
+	REGISTER_CB_HANDLERS(cb_table, 0x10, rl);
+	REGISTER_CB_HANDLERS(cb_table, 0x18, rr);
+	REGISTER_CB_HANDLERS(cb_table, 0x20, sla);
+	REGISTER_CB_HANDLERS(cb_table, 0x28, sra);
+	REGISTER_CB_HANDLERS(cb_table, 0x30, swap);
+	REGISTER_CB_HANDLERS(cb_table, 0x38, srl);
+	REGISTER_CB_BIT_HANDLERS(cb_table, 0);
+	REGISTER_CB_BIT_HANDLERS(cb_table, 1);
+	REGISTER_CB_BIT_HANDLERS(cb_table, 2);
+	REGISTER_CB_BIT_HANDLERS(cb_table, 3);
+	REGISTER_CB_BIT_HANDLERS(cb_table, 4);
+	REGISTER_CB_BIT_HANDLERS(cb_table, 5);
+	REGISTER_CB_BIT_HANDLERS(cb_table, 6);
+	REGISTER_CB_BIT_HANDLERS(cb_table, 7);
+}		/* -----  end of function register_bit_rotate_shift_instructions  ----- */
@@ -0,0 +1,312 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  block_cache.c
+ *
+ *    Description:  Cache of pre-decoded basic blocks. The first time a block runs
+ *                  its instructions are decoded into an array of handlers with their
+ *                  immediates already fetched, later runs replay the array without
+ *                  going through fetch, read_memory, or the opcode tables. Blocks
+ *                  are cached by ROM bank and address. Built when BLOCK_CACHE is
+ *                  defined
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 15:42:07
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Matt Gercz (matt.gercz@icloud.com)
+ *
+ * =====================================================================================
+ */
+#ifdef BLOCK_CACHE
+#include <stdlib.h>
+#include <string.h>
+#include "block_cache.h"
+#include "cpu_emulator.h"
+#include "global_declarations.h"
+#include "scheduler.h"
+
+#define MAX_BLOCK_INSTRUCTIONS 0x40
+#define MAX_DECODED 0x10000
+#define MAX_BLOCKS 0x4000
+#define HASH_BUCKETS 0x1000
+
+typedef struct Decoded_Instruction
+{
+	opcode_handler execute;
+	unsigned short operand; // Immediate already fetched
+	unsigned char length; // Size of the instruction including the opcode
+} Decoded_Instruction;
+
+typedef struct Decoded_Block
+{
+	unsigned int key; // ROM bank in the upper half, address in the lower
+	unsigned int end; // One past the last byte of the block
+	unsigned int instructions; // 0 when the first instruction is left to cpu_execution
+	Decoded_Instruction *decoded;
+	struct Decoded_Block *next; // Next block in the same hash bucket
+	struct Decoded_Block *next_ram; // Next block that lives in RAM
+} Decoded_Block;
+
+struct Block_Cache
+{
+	Decoded_Instruction decoded[MAX_DECODED];
+	unsigned int decoded_used;
+	Decoded_Block blocks[MAX_BLOCKS];
+	unsigned int blocks_used;
+	Decoded_Block *buckets[HASH_BUCKETS];
+	Decoded_Block *ram_blocks;
+	int decoded_stop_pc;
+
+	// Set by block_cache_invalidate so replay stops after the current instruction
+	unsigned char exit_requested;
+};
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  mark_lines
+ *  Description:  Sets or clears the code line flags covering a block in RAM
+ * =====================================================================================
+ */
+	static void
+mark_lines (GB *gb, const Decoded_Block *block, unsigned char value)
+{
+	unsigned int start = block->key & 0xFFFFu;
+
+	for (unsigned int line = start >> 0x4u; line <= (block->end - 1) >> 0x4u; line++)
+	{
+		gb->code_lines[line] = value;
+	}
+}		/* -----  end of function mark_lines  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  decode_block
+ *  Description:  Decodes the basic block starting at the address in key
+ *   Parameters:  key is the cache key of the block
+ *                region_end is one past the last address the block may use
+ *                stop_pc ends the block before the breakpoint, -1 for none
+ *       Return:  The new block
+ * =====================================================================================
+ */
+	static Decoded_Block*
+decode_block (GB *gb, unsigned int key, unsigned int region_end, int stop_pc)
+{
+	Block_Cache *cache = gb->block_cache;
+	unsigned int pc = key & 0xFFFFu;
+	Decoded_Block *block = &cache->blocks[cache->blocks_used++];
+
+	block->key = key;
+	block->decoded = &cache->decoded[cache->decoded_used];
+	block->instructions = 0;
+
+	while (block->instructions < MAX_BLOCK_INSTRUCTIONS && (int) pc != stop_pc)
+	{
+		unsigned char opcode = read_memory(gb, (unsigned short) pc);
+		const Opcode *instruction = &opcode_table[opcode];
+		Decoded_Instruction *entry = &block->decoded[block->instructions];
+
+		if (opcode_is_illegal(opcode) || pc + 0x1 + instruction->length > region_end)
+		{
+			break;
+		}
+
+		entry->execute = instruction->execute;
+		entry->length = (unsigned char) (instruction->length + 0x1);
+		entry->operand = 0;
+		if (instruction->length)
+		{
+			entry->operand = read_memory(gb, (unsigned short) (pc + 0x1));
+			if (instruction->length == 0x2)
+			{
+				entry->operand = combine_bytes(read_memory(gb, (unsigned short) (pc + 0x2)),
+				                               (unsigned char) entry->operand);
+			}
+		}
+		block->instructions++;
+		pc += entry->length;
+
+		if (opcode_ends_block(opcode))
+		{
+			break;
+		}
+	}
+
+	block->end = block->instructions ? pc : (key & 0xFFFFu) + 0x1;
+	cache->decoded_used += block->instructions;
+	return block;
+}		/* -----  end of function decode_block  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  block_cache_flush
+ *  Description:  Drops every decoded block, needed when a new cartridge is loaded
+ * =====================================================================================
+ */
+void block_cache_flush(GB *gb)
+{
+	Block_Cache *cache = gb->block_cache;
+
+	memset(gb->code_lines, 0, sizeof(gb->code_lines));
+	if (cache == NULL) // Nothing decoded yet
+	{
+		return;
+	}
+	memset(cache->buckets, 0, sizeof(cache->buckets));
+	cache->ram_blocks = NULL;
+	cache->blocks_used = 0;
+	cache->decoded_used = 0;
+}		/* -----  end of function block_cache_flush  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  block_cache_invalidate
+ *  Description:  Called by write_memory for writes to the MBC registers or to RAM
+ *                holding decoded code. Stops the block being replayed after the
+ *                current instruction and drops every block in RAM that covers the
+ *                address
+ *   Parameters:  addr is the address written
+ * =====================================================================================
+ */
+void block_cache_invalidate(GB *gb, unsigned short addr)
+{
+	Block_Cache *cache = gb->block_cache;
+	Decoded_Block **link;
+
+	if (cache == NULL)
+	{
+		return;
+	}
+	cache->exit_requested = 0x1;
+	link = &cache->ram_blocks;
+	if (addr < 0x8000) // Bank switch, blocks are keyed by bank so stay valid
+	{
+		return;
+	}
+
+	while (*link != NULL)
+	{
+		Decoded_Block *block = *link;
+
+		if (addr >= (block->key & 0xFFFFu) && addr < block->end)
+		{
+			Decoded_Block **bucket = &cache->buckets[block->key % HASH_BUCKETS];
+
+			while (*bucket != block)
+			{
+				bucket = &(*bucket)->next;
+			}
+			*bucket = block->next;
+			*link = block->next_ram;
+			mark_lines(gb, block, 0x0);
+			gb->block_cache_stats.invalidations++;
+		}
+		else
+		{
+			link = &block->next_ram;
+		}
+	}
+
+	// Lines may be shared with blocks that survived
+	for (Decoded_Block *block = cache->ram_blocks; block != NULL; block = block->next_ram)
+	{
+		mark_lines(gb, block, 0x1);
+	}
+}		/* -----  end of function block_cache_invalidate  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  block_cache_execute
+ *  Description:  Replays the decoded block at PC, decoding it first if needed
+ *   Parameters:  max_instructions is the most instructions the block may execute,
+ *                only the start of a longer block is replayed
+ *                stop_pc is the breakpoint blocks must end before, -1 for none
+ *       Return:  The number of instructions executed, 0 when cpu_execution must
+ *                execute the next instruction instead
+ * =====================================================================================
+ */
+unsigned int block_cache_execute(GB *gb, unsigned long max_instructions, int stop_pc)
+{
+	Block_Cache *cache = gb->block_cache;
+	unsigned int key;
+	unsigned int region_end = code_region(gb, gb->regs.PC, &key);
+	unsigned int executed = 0;
+	unsigned int limit;
+	Decoded_Block *block;
+
+	if (!region_end)
+	{
+		return 0x0;
+	}
+	if (cache == NULL) // First block this instance runs
+	{
+		cache = gb->block_cache = malloc(sizeof(*cache));
+		if (cache == NULL)
+		{
+			return 0x0;
+		}
+		block_cache_flush(gb);
+		cache->decoded_stop_pc = stop_pc;
+	}
+	if (stop_pc != cache->decoded_stop_pc) // Blocks were decoded around another breakpoint
+	{
+		block_cache_flush(gb);
+		cache->decoded_stop_pc = stop_pc;
+	}
+
+	for (block = cache->buckets[key % HASH_BUCKETS]; block != NULL; block = block->next)
+	{
+		if (block->key == key)
+		{
+			break;
+		}
+	}
+
+	if (block == NULL)
+	{
+		if (cache->blocks_used == MAX_BLOCKS || cache->decoded_used + MAX_BLOCK_INSTRUCTIONS > MAX_DECODED)
+		{
+			block_cache_flush(gb);
+		}
+		block = decode_block(gb, key, region_end, stop_pc);
+		block->next = cache->buckets[key % HASH_BUCKETS];
+		cache->buckets[key % HASH_BUCKETS] = block;
+		if (block->instructions && (key & 0xFFFFu) >= 0x8000)
+		{
+			block->next_ram = cache->ram_blocks;
+			cache->ram_blocks = block;
+			mark_lines(gb, block, 0x1);
+		}
+		gb->block_cache_stats.misses++;
+	}
+	else
+	{
+		gb->block_cache_stats.hits++;
+	}
+
+	if (!block->instructions || !max_instructions)
+	{
+		return 0x0;
+	}
+
+	// Only the last instruction can branch, so a block cut short still leaves PC right.
+	// Stepping the rest would decode overlapping blocks at every PC it stops on
+	limit = block->instructions < max_instructions ? block->instructions : (unsigned int) max_instructions;
+
+	// Same as cpu_execution, minus the fetch and decode
+	cache->exit_requested = 0x0;
+	do
+	{
+		const Decoded_Instruction *entry = &block->decoded[executed++];
+		unsigned char cycles;
+
+		gb->regs.PC += entry->length;
+		cycles = entry->execute(gb, entry->operand);
+		advance_clock(cycles);
+	} while (executed < limit && !cache->exit_requested);
+
+	gb->block_cache_stats.instructions_replayed += executed;
+	return executed;
+}		/* -----  end of function block_cache_execute  ----- */
+#endif
@@ -0,0 +1,246 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  cartridge.c
+ *
+ *    Description:  Loads cartridge roms. A rom file is mapped read only and sized
+ *                  from its header, and every instance that opens the same file gets
+ *                  the same mapping, so many instances of one game share a single
+ *                  copy of the rom in the page cache
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026 00:26:37
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Matt Gercz (matt.gercz@icloud.com)
+ *
+ * =====================================================================================
+ */
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "cartridge.h"
+
+// Mappings shared between instances, looked up by file
+static Cartridge *open_mappings = NULL;
+static pthread_mutex_t mappings_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  cartridge_rom_size
+ *  Description:  Checks a cartridge header and works out the size of the rom from
+ *                  its ROM size byte, 32 KiB shifted left by the value
+ *   Parameters:  header is the start of the rom and size is how many bytes of it
+ *                  there are
+ *       Return:  The size of the rom, 0 if the header checksum doesn't match, the
+ *                  size byte is unknown, or the rom is shorter than the header says
+ * =====================================================================================
+ */
+	unsigned long
+cartridge_rom_size(const unsigned char *header, unsigned long size)
+{
+	unsigned char checksum = 0x0;
+	unsigned long rom_size;
+
+	if (size < CARTRIDGE_HEADER_END || header[0x148] > 0x8)
+	{
+		return 0x0;
+	}
+	for (unsigned int addr = 0x134; addr < 0x14D; addr++)
+	{
+		checksum = (unsigned char) (checksum - header[addr] - 0x1);
+	}
+	rom_size = 0x8000ul << header[0x148];
+	return checksum == header[0x14D] && size >= rom_size ? rom_size : 0x0;
+}		/* -----  end of function cartridge_rom_size  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  new_cartridge
+ *  Description:  Allocates a cartridge for a rom of a known size
+ * =====================================================================================
+ */
+	static Cartridge*
+new_cartridge(unsigned char *rom, unsigned long size, int mapped)
+{
+	Cartridge *cartridge = calloc(0x1, sizeof(*cartridge));
+
+	if (cartridge == NULL)
+	{
+		return NULL;
+	}
+	cartridge->rom = rom;
+	cartridge->size = size;
+	cartridge->rom_banks = (unsigned int) (size / 0x4000);
+	cartridge->references = 0x1;
+	cartridge->mapped = mapped;
+	return cartridge;
+}		/* -----  end of function new_cartridge  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  open_cartridge
+ *  Description:  Maps a rom file read only, or takes another reference to the
+ *                  mapping if an instance already has the file open. A file
+ *                  changed since it was mapped gets a new mapping
+ *   Parameters:  file is the path of the rom
+ *       Return:  The cartridge, NULL if the file can't be read or isn't a rom
+ * =====================================================================================
+ */
+	Cartridge*
+open_cartridge(const char *file)
+{
+	int fd = open(file, O_RDONLY);
+	unsigned char header[CARTRIDGE_HEADER_END];
+	Cartridge *cartridge = NULL;
+	unsigned long rom_size;
+	struct stat info;
+	void *rom;
+
+	if (fd < 0)
+	{
+		return NULL;
+	}
+	if (fstat(fd, &info) || pread(fd, header, sizeof(header), 0x0) != sizeof(header) ||
+	    (rom_size = cartridge_rom_size(header, (unsigned long) info.st_size)) == 0x0)
+	{
+		close(fd);
+		return NULL;
+	}
+
+	pthread_mutex_lock(&mappings_lock);
+	for (cartridge = open_mappings; cartridge != NULL; cartridge = cartridge->next)
+	{
+		if (cartridge->device == info.st_dev && cartridge->inode == info.st_ino &&
+		    cartridge->file_size == info.st_size &&
+		    cartridge->modified.tv_sec == info.st_mtim.tv_sec &&
+		    cartridge->modified.tv_nsec == info.st_mtim.tv_nsec)
+		{
+			cartridge->references++;
+			break;
+		}
+	}
+	if (cartridge != NULL)
+	{
+		pthread_mutex_unlock(&mappings_lock);
+		close(fd);
+		return cartridge;
+	}
+
+	rom = mmap(NULL, rom_size, PROT_READ, MAP_SHARED, fd, 0x0); // Anything past the rom is left out
+	close(fd);
+	if (rom == MAP_FAILED)
+	{
+		pthread_mutex_unlock(&mappings_lock);
+		return NULL;
+	}
+	if ((cartridge = new_cartridge(rom, rom_size, 0x1)) == NULL)
+	{
+		munmap(rom, rom_size);
+		pthread_mutex_unlock(&mappings_lock);
+		return NULL;
+	}
+	cartridge->device = info.st_dev;
+	cartridge->inode = info.st_ino;
+	cartridge->file_size = info.st_size;
+	cartridge->modified = info.st_mtim;
+	cartridge->next = open_mappings;
+	open_mappings = cartridge;
+	pthread_mutex_unlock(&mappings_lock);
+	return cartridge;
+}		/* -----  end of function open_cartridge  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  copy_cartridge
+ *  Description:  Makes a cartridge from a rom already in memory, only the bytes the
+ *                  header says the rom holds are copied. Copies aren't shared
+ *   Parameters:  data is the rom image and size its length in bytes
+ *       Return:  The cartridge, NULL if the data isn't a rom or out of memory
+ * =====================================================================================
+ */
+	Cartridge*
+copy_cartridge(const unsigned char *data, unsigned long size)
+{
+	unsigned long rom_size = data != NULL ? cartridge_rom_size(data, size) : 0x0;
+	unsigned char *rom = rom_size ? malloc(rom_size) : NULL;
+	Cartridge *cartridge;
+
+	if (rom == NULL)
+	{
+		return NULL;
+	}
+	memcpy(rom, data, rom_size);
+	cartridge = new_cartridge(rom, rom_size, 0x0);
+	if (cartridge == NULL)
+	{
+		free(rom);
+	}
+	return cartridge;
+}		/* -----  end of function copy_cartridge  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  release_cartridge
+ *  Description:  Drops an instance's reference to a cartridge, the last one unmaps
+ *                  or frees it
+ * =====================================================================================
+ */
+	void
+release_cartridge(Cartridge *cartridge)
+{
+	if (cartridge == NULL)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&mappings_lock);
+	if (--cartridge->references)
+	{
+		pthread_mutex_unlock(&mappings_lock);
+		return;
+	}
+	for (Cartridge **link = &open_mappings; *link != NULL; link = &(*link)->next)
+	{
+		if (*link == cartridge)
+		{
+			*link = cartridge->next;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&mappings_lock);
+	if (cartridge->mapped)
+	{
+		munmap(cartridge->rom, cartridge->size);
+	}
+	else
+	{
+		free(cartridge->rom);
+	}
+	free(cartridge);
+}		/* -----  end of function release_cartridge  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  share_cartridge
+ *  Description:  Takes another reference to a cartridge for an instance forked from
+ *                  one using it
+ *       Return:  The cartridge, NULL if cartridge is NULL
+ * =====================================================================================
+ */
+	Cartridge*
+share_cartridge(Cartridge *cartridge)
+{
+	if (cartridge != NULL)
+	{
+		pthread_mutex_lock(&mappings_lock);
+		cartridge->references++;
+		pthread_mutex_unlock(&mappings_lock);
+	}
+	return cartridge;
+}		/* -----  end of function share_cartridge  ----- */
@@ -18,391 +18,158 @@
  */
 #include "global_declarations.h"
 #include "cpu_emulator.h"
+#include "control_instructions.h"
 #include "helper_functions.h"
+#include "idle_loop.h"
 
 /*
  * ===  FUNCTION  ======================================================================
  *         Name:  cp
- *  Description:  Handles opcodes translating to CP instructions
- *       Return:  The number of clock cycles to execute this instruction
+ *  Description:  Emulates CP instructions, comparing the operand against A
+ *   Parameters:  operand is the value to compare A against
  * =====================================================================================
  */
-    unsigned char
-cp (unsigned char opcode)
+    static void
+cp (GB *gb, unsigned char operand)
 {
-    unsigned char cycles;
-	flags->N = 1; // CP sets the N flag
-
-	unsigned short reg_hl = combine_bytes(regs->H, regs->L);
-	unsigned char operand;
-
-	switch (opcode) {
-		case 0xFE:
-		    operand = read_memory(ptrs->PC);
-			ptrs->PC++;
-			cycles = 0x8;
-			break;
-		case 0xBE:
-			operand = read_memory(reg_hl);
-            cycles = 0x8;
-			break;
-		case 0xBF:
-			operand = regs->A;
-            cycles = 0x4;
-			break;
-		case 0xB8:
-			operand = regs->B;
-            cycles = 0x4;
-			break;
-		case 0xB9:
-			operand = regs->C;
-            cycles = 0x4;
-			break;
-		case 0xBA:
-			operand = regs->D;
-            cycles = 0x4;
-			break;
-		case 0xBB:
-			operand = regs->E;
-            cycles = 0x4;
-			break;
-		case 0xBC:
-			operand = regs->H;
-            cycles = 0x4;
-			break;
-		case 0xBD:
-			operand = regs->L;
-            cycles = 0x4;
-			break;
-		default:
-		    operand = 0x0;
-		    cycles = 0x0;
-			break;
-	}
+	set_flag(FLAG_N, 1); // CP sets the N flag
 
 	// A's state is unchanged, only the flags are affected
-	eight_bit_update_flags(regs->A, operand);
-	return cycles;
+	eight_bit_update_flags(gb, gb->regs.A, operand, FLAG_Z | FLAG_H | FLAG_C);
 }		/* -----  end of function cp  ----- */
 
 /*
  * ===  FUNCTION  ======================================================================
  *         Name:  jp
- *  Description:  Handles opcodes translating to JP instructions
+ *  Description:  Emulates JP instructions to a 16-bit immediate target
+ *   Parameters:  condition is nonzero if the jump should be taken
+ *                target is the address to jump to
  *       Return:  The number of clock cycles to execute this instruction
  * =====================================================================================
  */
-    unsigned char
-jp (unsigned char opcode)
+    static unsigned char
+jp (GB *gb, unsigned char condition, unsigned short target)
 {
-    unsigned char cycles;
-
-	// Grab 16-bit immediate for the target
-	unsigned char target_lo = read_memory(ptrs->PC);
-	ptrs->PC++;
-	unsigned char target_hi = read_memory(ptrs->PC);
-	ptrs->PC++;
-	unsigned short target = combine_bytes(target_hi, target_lo);
-
-	unsigned short reg_hl = combine_bytes(regs->H, regs->L);
-
-	switch (opcode)
+	if (condition)
+	{
+		gb->regs.PC = target;
+		return 0x10;
+	}
+	else
 	{
-		case 0xC3:
-			ptrs->PC = target;
-            cycles = 0x10;
-			return cycles;
-		case 0xE9:
-			target = reg_hl;
-			ptrs->PC = target;
-            cycles = 0x4;
-			return cycles;
-		case 0xDA:
-			if (flags->C)
-			{
-				ptrs->PC = target;
-				cycles = 0x10;
-			}
-			else
-            {
-                cycles = 0xC;
-            }
-			return cycles;
-		case 0xD2:
-            if (!flags->C)
-			{
-				ptrs->PC = target;
-				cycles = 0x10;
-			}
-            else
-            {
-                cycles = 0xC;
-            }
-			return cycles;
-		case 0xC2:
-            if (!flags->Z)
-			{
-				ptrs->PC = target;
-				cycles = 0x10;
-			}
-            else
-            {
-                cycles = 0xC;
-            }
-			return cycles;
-		case 0xCA:
-            if (flags->Z)
-			{
-				ptrs->PC = target;
-				cycles = 0x10;
-			}
-            else
-            {
-                cycles = 0xC;
-            }
-			return cycles;
-		default:
-			return 0x0;
+		return 0xC;
 	}
 }		/* -----  end of function jp  ----- */
 
 /*
  * ===  FUNCTION  ======================================================================
  *         Name:  jr
- *  Description:  Handles opcodes translating to JR instructions
+ *  Description:  Emulates JR instructions, all ops use a 1-byte signed immediate
+ *   Parameters:  condition is nonzero if the jump should be taken
+ *                offset is the immediate to add to PC
  *       Return:  The number of clock cycles to execute this instruction
  * =====================================================================================
  */
-        unsigned char
-jr (unsigned char opcode)
+        static unsigned char
+jr (GB *gb, unsigned char condition, unsigned short offset)
 {
-    unsigned char cycles;
-	// All ops use a 1-byte immediate
-	char offset = read_memory(ptrs->PC); // NOLINT
-	ptrs->PC++;
-
-	switch (opcode)
+	if (condition)
+	{
+		if ((char) offset < 0) // NOLINT
+		{
+			idle_loop_branch(gb, (unsigned short) (gb->regs.PC + (char) offset), gb->regs.PC); // NOLINT
+		}
+		gb->regs.PC += (char) offset; // NOLINT
+		return 0xC;
+	}
+	else
 	{
-		case 0x18:
-			ptrs->PC += offset;
-			cycles = 0xC;
-			return cycles;
-		case 0x38:
-            if (flags->C)
-			{
-				ptrs->PC += offset;
-				cycles = 0xC;
-			}
-            else
-            {
-                cycles = 0x8;
-            }
-			return cycles;
-		case 0x30:
-            if (!flags->C)
-			{
-				ptrs->PC += offset;
-				cycles = 0xC;
-			}
-            else
-            {
-                cycles = 0x8;
-            }
-			return cycles;
-		case 0x20:
-            if (!flags->Z)
-			{
-				ptrs->PC += offset;
-				cycles = 0xC;
-			}
-            else
-            {
-                cycles = 0x8;
-            }
-			return cycles;
-		case 0x28:
-            if (flags->Z)
-			{
-				ptrs->PC += offset;
-				cycles = 0xC;
-			}
-            else
-            {
-                cycles = 0x8;
-            }
-			return cycles;
-		default:
-			return 0x0;
+		return 0x8;
 	}
 }               /* -----  end of function jr  ----- */
 
 /*
  * ===  FUNCTION  ======================================================================
- *         Name:  call
- *  Description:  Handles opcodes translating to CALL instructions
- *       Return:  The number of clock cycles to execute this instruction
+ *         Name:  push_pc
+ *  Description:  Allocates space on the stack and stores PC there
  * =====================================================================================
  */
-        unsigned char
-call (unsigned char opcode)
+        static void
+push_pc (GB *gb)
 {
-    unsigned char cycles;
-
-    // Grab 16-bit immediate for the target
-    unsigned char target_lo = read_memory(ptrs->PC);
-    ptrs->PC++;
-    unsigned char target_hi = read_memory(ptrs->PC);
-    ptrs->PC++;
-    unsigned short target = combine_bytes(target_hi, target_lo);
-
 	// Grab both bytes of PC to store on the stack
-	unsigned char pc_high = (unsigned char)(ptrs->PC >> 0x08u);
-	unsigned char pc_low = (unsigned char) (ptrs->PC & 0xFFu);
+	unsigned char pc_high = (unsigned char)(gb->regs.PC >> 0x08u);
+	unsigned char pc_low = (unsigned char) (gb->regs.PC & 0xFFu);
 
-	switch (opcode)
-	{
-		case 0xCD:
-			// Allocate space on stack and store PC there
-			ptrs->SP--;
-			write_memory(ptrs->SP, pc_high);
-			ptrs->SP--;
-			write_memory(ptrs->SP, pc_low);
+	gb->regs.SP--;
+	write_memory(gb, gb->regs.SP, pc_high);
+	gb->regs.SP--;
+	write_memory(gb, gb->regs.SP, pc_low);
+}               /* -----  end of function push_pc  ----- */
 
- 			ptrs->PC = target;
- 			cycles = 0x18;
-			return cycles;
-		case 0xDC:
-            if (flags->C)
-			{
-				ptrs->SP--;
-				write_memory(ptrs->SP, pc_high);
-				ptrs->SP--;
-				write_memory(ptrs->SP, pc_low);
-
-	 			ptrs->PC = target;
-	 			cycles = 0x18;
-			}
-            else
-            {
-                cycles = 0xC;
-            }
-			return cycles;
-		case 0xD4:
-            if (!flags->C)
-			{
-				ptrs->SP--;
-				write_memory(ptrs->SP, pc_high);
-				ptrs->SP--;
-				write_memory(ptrs->SP, pc_low);
-
-	 			ptrs->PC = target;
-	 			cycles = 0x18;
-			}
-            else
-            {
-                cycles = 0xC;
-            }
-			return cycles;
-		case 0xC4:
-            if (!flags->Z)
-			{
-				ptrs->SP--;
-				write_memory(ptrs->SP, pc_high);
-				ptrs->SP--;
-				write_memory(ptrs->SP, pc_low);
-
- 				ptrs->PC = target;
- 				cycles = 0x18;
-			}
-            else
-            {
-                cycles = 0xC;
-            }
-			return cycles;
-		case 0xCC:
-            if (flags->Z)
-			{
-				ptrs->SP--;
-				write_memory(ptrs->SP, pc_high);
-				ptrs->SP--;
-				write_memory(ptrs->SP, pc_low);
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  pop_return_address
+ *  Description:  Grabs a return address off the stack
+ *       Return:  The address popped
+ * =====================================================================================
+ */
+        static unsigned short
+pop_return_address (GB *gb)
+{
+    unsigned char return_lo = read_memory(gb, gb->regs.SP);
+    gb->regs.SP++;
+    unsigned char return_hi = read_memory(gb, gb->regs.SP);
+    gb->regs.SP++;
+    return combine_bytes(return_hi, return_lo);
+}               /* -----  end of function pop_return_address  ----- */
 
- 				ptrs->PC = target;
- 				cycles = 0x18;
-			}
-            else
-            {
-                cycles = 0xC;
-            }
-			return cycles;
-		default:
-			return 0x0;
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  call
+ *  Description:  Emulates CALL instructions to a 16-bit immediate target
+ *   Parameters:  condition is nonzero if the call should be taken
+ *                target is the address to call
+ *       Return:  The number of clock cycles to execute this instruction
+ * =====================================================================================
+ */
+        static unsigned char
+call (GB *gb, unsigned char condition, unsigned short target)
+{
+	if (condition)
+	{
+		push_pc(gb);
+		gb->regs.PC = target;
+		return 0x18;
+	}
+	else
+	{
+		return 0xC;
 	}
 }               /* -----  end of function call  ----- */
 
 /*
  * ===  FUNCTION  ======================================================================
  *         Name:  ret
- *  Description:  Handles opcodes translating to RET instructions
+ *  Description:  Emulates the conditional RET instructions
+ *   Parameters:  condition is nonzero if the return should be taken
  *       Return:  The number of clock cycles to execute this instruction
  * =====================================================================================
  */
-        unsigned char
-ret (unsigned char opcode)
+        static unsigned char
+ret (GB *gb, unsigned char condition)
 {
     // Grab return address off the stack
-    unsigned char return_lo = read_memory(ptrs->SP);
-    ptrs->SP++;
-    unsigned char return_hi = read_memory(ptrs->SP);
-    ptrs->SP++;
-    unsigned short return_address = combine_bytes(return_hi, return_lo);
-	switch (opcode)
+    unsigned short return_address = pop_return_address(gb);
+
+	if (condition)
+	{
+		gb->regs.PC = return_address;
+		return 0x14;
+	}
+	else
 	{
-		case 0xC9:
-			ptrs->PC = return_address;
-			return 0x10;
-		case 0xD8:
-            if (flags->C)
-			{
-				ptrs->PC = return_address;
-				return 0x14;
-			}
-            else
-            {
-				return 0x8;
-            }
-		case 0xD0:
-            if (!flags->C)
-			{
-				ptrs->PC = return_address;
-				return 0x14;
-			}
-            else
-            {
-                return 0x8;
-            }
-		case 0xC0:
-            if (!flags->Z)
-			{
-				ptrs->PC = return_address;
-				return 0x14;
-			}
-            else
-            {
-				return 0x8;
-            }
-		case 0xC8:
-            if (flags->Z)
-			{
-				ptrs->PC = return_address;
-				return 0x14;
-			}
-            else
-            {
-				return 0x8;
-            }
-		default:
-			return 0x0;
+		return 0x8;
 	}
 }               /* -----  end of function ret  ----- */
 
@@ -413,19 +180,12 @@ ret (unsigned char opcode)
  *       Return:  The number of clock cycles to execute this instruction
  * =====================================================================================
  */
-        unsigned char
-reti ()
+        static unsigned char
+reti (GB *gb, unsigned short operand)
 {
-    // Get return address off the stack
-    unsigned char return_lo = read_memory(ptrs->SP);
-    ptrs->SP++;
-    unsigned char return_hi = read_memory(ptrs->SP);
-    ptrs->SP++;
-    unsigned short return_address = combine_bytes(return_hi, return_lo);
-
     // Unconditional return
-	ptrs->PC = return_address;
-	flags->IME = 0x1; // Enable interrupts
+	gb->regs.PC = pop_return_address(gb);
+	gb->regs.IME = 0x1; // Enable interrupts
 
     return 0x10;
 }               /* -----  end of function reti  ----- */
@@ -433,54 +193,126 @@ reti ()
 /*
  * ===  FUNCTION  ======================================================================
  *         Name:  rst
- *  Description:  Handles opcodes translating to RST instructions
+ *  Description:  Emulates RST instructions
+ *   Parameters:  target is the restart vector to call
  *       Return:  The number of clock cycles to execute this instruction
  * =====================================================================================
  */
-        unsigned char
-rst (unsigned char opcode)
+        static unsigned char
+rst (GB *gb, unsigned char target)
 {
-	unsigned char target = 0;
+	push_pc(gb);
+	gb->regs.PC = target;
+	return 0x10;
+}               /* -----  end of function rst  ----- */
 
-	switch (opcode)
-	{
-		case 0xC7:
-			target = 0x00;
-			break;
-		case 0xCF:
-			target = 0x08;
-			break;
-		case 0xD7:
-			target = 0x10;
-			break;
-		case 0xDF:
-			target = 0x18;
-			break;
-		case 0xE7:
-			target = 0x20;
-			break;
-		case 0xEF:
-			target = 0x28;
-			break;
-		case 0xF7:
-			target = 0x30;
-			break;
-		case 0xFF:
-			target = 0x38;
-			break;
-		default:
-			return 0x0;
-	}
+EIGHT_BIT_OPERAND_HANDLERS(cp_a, cp)
+
+// Conditional jumps, calls, and returns, one handler per condition
+#define CONDITIONAL_HANDLERS(cond_name, condition) \
+	static unsigned char jp_##cond_name(GB *gb, unsigned short operand) \
+	{ sync_flags(gb, 0x0); return jp(gb, condition, operand); } \
+	static unsigned char jr_##cond_name(GB *gb, unsigned short operand) \
+	{ sync_flags(gb, 0x0); return jr(gb, condition, operand); } \
+	static unsigned char call_##cond_name(GB *gb, unsigned short operand) \
+	{ sync_flags(gb, 0x0); return call(gb, condition, operand); } \
+	static unsigned char ret_##cond_name(GB *gb, unsigned short operand) \
+	{ sync_flags(gb, 0x0); return ret(gb, condition); }
+
+CONDITIONAL_HANDLERS(nz, !get_flag(FLAG_Z))
+CONDITIONAL_HANDLERS(z, get_flag(FLAG_Z))
+CONDITIONAL_HANDLERS(nc, !get_flag(FLAG_C))
+CONDITIONAL_HANDLERS(c, get_flag(FLAG_C))
+
+	static unsigned char
+jp_imm (GB *gb, unsigned short operand)
+{
+	return jp(gb, 0x1, operand);
+}
 
-    // Grab both bytes of PC to store on the stack
-    unsigned char pc_high = (unsigned char)(ptrs->PC >> 0x08u);
-    unsigned char pc_low = (unsigned char) (ptrs->PC & 0xFFu);
+	static unsigned char
+jp_hl (GB *gb, unsigned short operand)
+{
+	gb->regs.PC = gb->regs.HL;
+	return 0x4;
+}
 
-    ptrs->SP--;
-    write_memory(ptrs->SP, pc_high);
-    ptrs->SP--;
-    write_memory(ptrs->SP, pc_low);
+	static unsigned char
+jr_imm (GB *gb, unsigned short operand)
+{
+	return jr(gb, 0x1, operand);
+}
 
-	ptrs->PC = target;
+	static unsigned char
+call_imm (GB *gb, unsigned short operand)
+{
+	return call(gb, 0x1, operand);
+}
+
+	static unsigned char
+ret_always (GB *gb, unsigned short operand)
+{
+	gb->regs.PC = pop_return_address(gb);
 	return 0x10;
-}               /* -----  end of function rst  ----- */
+}
+
+#define RST_HANDLER(vector) \
+	static unsigned char rst_##vector(GB *gb, unsigned short operand) \
+	{ return rst(gb, vector); }
+
+RST_HANDLER(0x00)
+RST_HANDLER(0x08)
+RST_HANDLER(0x10)
+RST_HANDLER(0x18)
+RST_HANDLER(0x20)
+RST_HANDLER(0x28)
+RST_HANDLER(0x30)
+RST_HANDLER(0x38)
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  register_control_instructions
+ *  Description:  Places the handlers for every flow control opcode in the opcode table
+ *   Parameters:  table is the 256 entry opcode table to fill in
+ * =====================================================================================
+ */
+	void
+register_control_instructions (Opcode *table)
+{
+	REGISTER_EIGHT_BIT_OPERAND_HANDLERS(table, 0xB8, 0xFE, cp_a);
+
+	table[0xC3] = (Opcode) {jp_imm, 0x2};
+	table[0xE9] = (Opcode) {jp_hl, 0x0};
+	table[0xC2] = (Opcode) {jp_nz, 0x2};
+	table[0xCA] = (Opcode) {jp_z, 0x2};
+	table[0xD2] = (Opcode) {jp_nc, 0x2};
+	table[0xDA] = (Opcode) {jp_c, 0x2};
+
+	table[0x18] = (Opcode) {jr_imm, 0x1};
+	table[0x20] = (Opcode) {jr_nz, 0x1};
+	table[0x28] = (Opcode) {jr_z, 0x1};
+	table[0x30] = (Opcode) {jr_nc, 0x1};
+	table[0x38] = (Opcode) {jr_c, 0x1};
+
+	table[0xCD] = (Opcode) {call_imm, 0x2};
+	table[0xC4] = (Opcode) {call_nz, 0x2};
+	table[0xCC] = (Opcode) {call_z, 0x2};
+	table[0xD4] = (Opcode) {call_nc, 0x2};
+	table[0xDC] = (Opcode) {call_c, 0x2};
+
+	table[0xC9] = (Opcode) {ret_always, 0x0};
+	table[0xC0] = (Opcode) {ret_nz, 0x0};
+	table[0xC8] = (Opcode) {ret_z, 0x0};
+	table[0xD0] = (Opcode) {ret_nc, 0x0};
+	table[0xD8] = (Opcode) {ret_c, 0x0};
+	table[0xD9] = (Opcode) {reti, 0x0};
+
+	table[0xC7] = (Opcode) {rst_0x00, 0x0};
+	table[0xCF] = (Opcode) {rst_0x08, 0x0};
+	table[0xD7] = (Opcode) {rst_0x10, 0x0};
+	table[0xDF] = (Opcode) {rst_0x18, 0x0};
+	table[0xE7] = (Opcode) {rst_0x20, 0x0};
+	table[0xEF] = (Opcode) {rst_0x28, 0x0};
+	table[0xF7] = (Opcode) {rst_0x30, 0x0};
+	table[0xFF] = (Opcode) {rst_0x38, 0x0};
+}		/* -----  end of function register_control_instructions  ----- */
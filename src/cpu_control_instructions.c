@@ -15,57 +15,59 @@
  * =====================================================================================
  */
 #include "global_declarations.h"
+#include "cpu_control_instructions.h"
+#include "scheduler.h"
+
+// Most cycles one HALT sleeps for before returning to the core, a frame's worth
+#define HALT_LIMIT 0x11250
 
 /* 
  * ===  FUNCTION  ======================================================================
  *         Name:  pop
- *  Description:  Handles instructions to pop data off of the stack
- *       Return:  The number of clock cycles to execute this instruction
+ *  Description:  Pops a 16-bit value off of the stack
+ *       Return:  The value popped
  * =====================================================================================
  */
-	unsigned char
-pop (unsigned char opcode)
+	static unsigned short
+pop (GB *gb)
 {
-    unsigned char reg_f;
-    switch (opcode)
-    {
-        case 0xC1:
-            regs->C = read_memory(ptrs->SP);
-            ptrs->SP++;
-            regs->B = read_memory(ptrs->SP);
-            ptrs->SP++;
-            return 0xC;
-        case 0xD1:
-            regs->E = read_memory(ptrs->SP);
-            ptrs->SP++;
-            regs->D = read_memory(ptrs->SP);
-            ptrs->SP++;
-            return 0xC;
-        case 0xE1:
-            regs->L = read_memory(ptrs->SP);
-            ptrs->SP++;
-            regs->H = read_memory(ptrs->SP);
-            ptrs->SP++;
-            return 0xC;
-        case 0xF1:
-            reg_f = read_memory(ptrs->SP);
-            // Need to reassemble since storing F flags discretely
-            flags->Z = reg_f >> 0x7u;
-            flags->N = reg_f >> 0x6u;
-            flags->N &= 0x1u;
-            flags->H = reg_f >> 0x5u;
-            flags->H &= 0x1u;
-            flags->C = reg_f >> 0x4u;
-            flags->C &= 0x1u;
-            ptrs->SP++;
-            regs->A = read_memory(ptrs->SP);
-            ptrs->SP++;
-            return 0xC;
-        default:
-            return 0x0;
-    }
+    unsigned char lo = read_memory(gb, gb->regs.SP);
+    gb->regs.SP++;
+    unsigned char hi = read_memory(gb, gb->regs.SP);
+    gb->regs.SP++;
+    return combine_bytes(hi, lo);
 }		/* -----  end of function pop  ----- */
 
+	static unsigned char
+pop_bc (GB *gb, unsigned short operand)
+{
+	gb->regs.BC = pop(gb);
+	return 0xC;
+}
+
+	static unsigned char
+pop_de (GB *gb, unsigned short operand)
+{
+	gb->regs.DE = pop(gb);
+	return 0xC;
+}
+
+	static unsigned char
+pop_hl (GB *gb, unsigned short operand)
+{
+	gb->regs.HL = pop(gb);
+	return 0xC;
+}
+
+	static unsigned char
+pop_af (GB *gb, unsigned short operand)
+{
+    // Every flag is replaced, the low nibble of F always reads as 0
+    sync_flags(gb, FLAG_Z | FLAG_H | FLAG_C);
+    gb->regs.AF = (unsigned short) (pop(gb) & 0xFFF0u);
+    return 0xC;
+}
+
 /*
  * ===  FUNCTION  ======================================================================
  *         Name:  ccf
@@ -73,12 +75,12 @@ pop (unsigned char opcode)
  *       Return:  The number of clock cycles to execute this instruction
  * =====================================================================================
  */
-	unsigned char
-ccf ()
+	static unsigned char
+ccf (GB *gb, unsigned short operand)
 {
-    flags->H = 0x0;
-    flags->N = 0x0;
-    flags->C ^= 0x1u;
+    sync_flags(gb, 0x0);
+    gb->regs.F &= ~(FLAG_N | FLAG_H);
+    gb->regs.F ^= FLAG_C;
     return 0x4;
 }		/* -----  end of function ccf  ----- */
 
@@ -89,72 +91,109 @@ ccf ()
  *       Return:  The number of clock cycles to execute this instruction
  * =====================================================================================
  */
-	unsigned char
-scf ()
+	static unsigned char
+scf (GB *gb, unsigned short operand)
 {
-    flags->C = 0x1;
-    flags->N = 0x0;
-    flags->H = 0x0;
+    sync_flags(gb, FLAG_H | FLAG_C);
+    gb->regs.F &= ~(FLAG_N | FLAG_H);
+    gb->regs.F |= FLAG_C;
     return 0x4;
 }		/* -----  end of function scf  ----- */
 
 /* 
  * ===  FUNCTION  ======================================================================
  *         Name:  push
- *  Description:  Handles instructions to push data onto the stack
- *       Return:  The number of clock cycles to execute this instruction
+ *  Description:  Pushes a 16-bit value onto the stack
+ *   Parameters:  value is the register pair to push, high byte first
  * =====================================================================================
  */
-	unsigned char
-push (unsigned char opcode)
-{
-	unsigned char f_reg = 0;
-	switch (opcode)
-	{
-		case 0xF5:
-			ptrs->SP--;
-			write_memory(ptrs->SP, regs->A);
-			ptrs->SP--;
-			// F flags are stored discretely so need to get them and assemble
-			f_reg += (flags->Z << 0x7u);
-			f_reg += (flags->N << 0x6u);
-			f_reg += (flags->H << 0x5u);
-			f_reg += (flags->C << 0x4u);
-			write_memory(ptrs->SP, f_reg);
-			return 0x10;
-	    case 0xC5:
-	        ptrs->SP--;
-	        write_memory(ptrs->SP, regs->B);
-	        ptrs->SP--;
-	        write_memory(ptrs->SP, regs->C);
-	        return 0x10;
-	    case 0xD5:
-            ptrs->SP--;
-            write_memory(ptrs->SP, regs->D);
-            ptrs->SP--;
-            write_memory(ptrs->SP, regs->E);
-	        return 0x10;
-	    case 0xE5:
-            ptrs->SP--;
-            write_memory(ptrs->SP, regs->H);
-            ptrs->SP--;
-            write_memory(ptrs->SP, regs->L);
-	        return 0x10;
-        default:
-            return 0x10;
-    }
+	static void
+push (GB *gb, unsigned short value)
+{
+	gb->regs.SP--;
+	write_memory(gb, gb->regs.SP, (unsigned char) (value >> 0x8u));
+	gb->regs.SP--;
+	write_memory(gb, gb->regs.SP, (unsigned char) value);
 }		/* -----  end of function push  ----- */
 
+	static unsigned char
+push_bc (GB *gb, unsigned short operand)
+{
+	push(gb, gb->regs.BC);
+	return 0x10;
+}
+
+	static unsigned char
+push_de (GB *gb, unsigned short operand)
+{
+	push(gb, gb->regs.DE);
+	return 0x10;
+}
+
+	static unsigned char
+push_hl (GB *gb, unsigned short operand)
+{
+	push(gb, gb->regs.HL);
+	return 0x10;
+}
+
+	static unsigned char
+push_af (GB *gb, unsigned short operand)
+{
+	sync_flags(gb, 0x0);
+	push(gb, gb->regs.AF);
+	return 0x10;
+}
+
+/* 
+ * ===  FUNCTION  ======================================================================
+ *         Name:  nop
+ *  Description:  Handles the NOP instruction, which does nothing
+ *       Return:  The number of clock cycles to execute this instruction
+ * =====================================================================================
+ */
+	static unsigned char
+nop (GB *gb, unsigned short operand)
+{
+    return 0x4;
+}		/* -----  end of function nop  ----- */
+
 /* 
  * ===  FUNCTION  ======================================================================
  *         Name:  halt
- *  Description:  Handles opcodes that direct the CPU to halt
+ *  Description:  Handles opcodes that direct the CPU to halt. The cpu sleeps until
+ *                  an enabled interrupt is requested, and only events can request
+ *                  one, so the clock jumps from event to event instead of running
+ *                  instructions. After HALT_LIMIT cycles, or at the end of the run,
+ *                  PC is left on the HALT so the core gets control back and runs
+ *                  it again. A HALT at the end of the run takes no time, so the
+ *                  clock stops exactly there
  *       Return:  The number of clock cycles to execute this instruction
  * =====================================================================================
  */
-	unsigned char
-halt ()
+	static unsigned char
+halt (GB *gb, unsigned short operand)
 {
+    unsigned long limit = gb->clock.cycles + HALT_LIMIT;
+
+    if (gb->clock.run_until < limit)
+    {
+        limit = gb->clock.run_until;
+    }
+    gb->halt_stats.halts++;
+    while (!(read_memory(gb, 0xFFFF) & read_memory(gb, 0xFF0F) & 0x1Fu))
+    {
+        if (gb->clock.cycles >= limit) // Still asleep
+        {
+            gb->regs.PC--;
+            if (gb->clock.cycles >= gb->clock.run_until)
+            {
+                return 0x0; // The time asleep was already counted
+            }
+            break;
+        }
+        gb->halt_stats.cycles_skipped += skip_to_next_event(gb, limit);
+    }
     return 0x4;
 }		/* -----  end of function halt  ----- */
 
@@ -165,10 +204,10 @@ halt ()
  *       Return:  The number of clock cycles to execute this instruction
  * =====================================================================================
  */
-	unsigned char
-ei ()
+	static unsigned char
+ei (GB *gb, unsigned short operand)
 {
-	flags->IME = 0x1;
+	gb->regs.IME = 0x1;
     return 0x4;
 }		/* -----  end of function ei  ----- */
 
@@ -179,10 +218,10 @@ ei ()
  *       Return:  The number of clock cycles to execute this instruction
  * =====================================================================================
  */
-	unsigned char
-di ()
+	static unsigned char
+di (GB *gb, unsigned short operand)
 {
-	flags->IME = 0x0;
+	gb->regs.IME = 0x0;
 	return 0x4;
 }		/* -----  end of function di  ----- */
 
@@ -193,8 +232,35 @@ di ()
  *       Return:  The number of clock cycles to execute this instruction
  * =====================================================================================
  */
-	unsigned char
-stop ()
+	static unsigned char
+stop (GB *gb, unsigned short operand)
 {
 	return 0x4;
 }		/* -----  end of function stop  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  register_cpu_control_instructions
+ *  Description:  Places the handlers for every cpu control opcode in the opcode table
+ *   Parameters:  table is the 256 entry opcode table to fill in
+ * =====================================================================================
+ */
+	void
+register_cpu_control_instructions (Opcode *table)
+{
+	table[0x00] = (Opcode) {nop, 0x0};
+	table[0x76] = (Opcode) {halt, 0x0};
+	table[0x10] = (Opcode) {stop, 0x0};
+	table[0xF3] = (Opcode) {di, 0x0};
+	table[0xFB] = (Opcode) {ei, 0x0};
+	table[0x3F] = (Opcode) {ccf, 0x0};
+	table[0x37] = (Opcode) {scf, 0x0};
+	table[0xC1] = (Opcode) {pop_bc, 0x0};
+	table[0xD1] = (Opcode) {pop_de, 0x0};
+	table[0xE1] = (Opcode) {pop_hl, 0x0};
+	table[0xF1] = (Opcode) {pop_af, 0x0};
+	table[0xC5] = (Opcode) {push_bc, 0x0};
+	table[0xD5] = (Opcode) {push_de, 0x0};
+	table[0xE5] = (Opcode) {push_hl, 0x0};
+	table[0xF5] = (Opcode) {push_af, 0x0};
+}		/* -----  end of function register_cpu_control_instructions  ----- */
@@ -14,7 +14,9 @@
  *
  * =====================================================================================
  */
+#include <limits.h>
 #include <stdlib.h>
+#include "cpu_emulator.h"
 #include "math_instructions.h"
 #include "global_declarations.h"
 #include "logical_instructions.h"
@@ -22,26 +24,39 @@
 #include "control_instructions.h"
 #include "load_instructions.h"
 #include "cpu_control_instructions.h"
-#include "graphics.h"
-#include "timers.h"
+#include "scheduler.h"
+#ifdef JIT
+#include "jit.h"
+#elif defined(BLOCK_CACHE)
+#include "block_cache.h"
+#endif
+
+#define LONGEST_INSTRUCTION_CYCLES 0x18 // CALL
+
+// Decode tables indexed by opcode, filled in by init_opcode_tables
+Opcode opcode_table[0x100];
+opcode_handler cb_opcode_table[0x100];
 
 /*
  * ===  FUNCTION  ======================================================================
- *         Name:  eight_bit_update_flags
- *  Description:  Handles updates to the Z, H, and C flags in the F register 
- *  		  after an eight-bit instruction executes. Assumes N flag has
- *  		  been set or cleared before this function is called
- *  		  
+ *         Name:  eight_bit_flags
+ *  Description:  Computes the Z, H, and C flags of an eight-bit arithmetic instruction
+ *
  *   Parameters:  value1 is the first operand of an arithmetic instruction
  *   		  value2 is the second operand in an arithmetic instruction
+ *   		  subtract is the state of the N flag when the instruction ran
+ *   		  mask selects which of FLAG_Z, FLAG_H, and FLAG_C in F are written
  * =====================================================================================
  */
-void eight_bit_update_flags(unsigned char value1, unsigned char value2)
+static void
+eight_bit_flags(GB *gb, unsigned char value1, unsigned char value2, unsigned char subtract,
+                unsigned char mask)
 {
 	int carry_test;			 // An int is needed for the algorithm to check for carry
 	unsigned char zero_test; // Need 1 byte data to check zero because of overflow
+	unsigned char half_carry;
 
-	if (!flags->N) // Checks that last op was addition
+	if (!subtract) // Checks that last op was addition
 	{
 		carry_test = value1 + value2;
 		zero_test = (unsigned char)value1 + (unsigned char)value2;
@@ -50,24 +65,8 @@ void eight_bit_update_flags(unsigned char value1, unsigned char value2)
 		 * https://stackoverflow.com/questions/8868396/gbz80-what-constitutes
 		 * -a-half-carry/
 		 */
-		if ((((value1 & 0xF) + (value2 & 0xF)) & 0x10) == 0x10)
-		{
-			flags->H = 1;
-		}
-		else
-		{
-			flags->H = 0;
-		}
-
-		// Carry Flag - addition
-		if (carry_test > 0xFF)
-		{
-			flags->C = 1;
-		}
-		else
-		{
-			flags->C = 0;
-		}
+		half_carry = (((value1 & 0xF) + (value2 & 0xF)) & 0x10) == 0x10;
+		carry_test = carry_test > 0xFF; // Carry Flag - addition
 	}
 	// Otherwise it was a subtraction
 	else
@@ -76,76 +75,43 @@ void eight_bit_update_flags(unsigned char value1, unsigned char value2)
 		zero_test = (unsigned char)value1 - (unsigned char)value2;
 
 		// Half Carry Flag - subtraction TODO: something is still broken here
-		if (((value1 & 0xF) - (value2 & 0xF)) < 0)
-		{
-			flags->H = 1;
-		}
-		else
-		{
-			flags->H = 0;
-		}
-		// Carry Flag - subtraction
-		if (carry_test < 0)
-		{
-			flags->C = 1;
-		}
-		else
-		{
-			flags->C = 0;
-		}
+		half_carry = ((value1 & 0xF) - (value2 & 0xF)) < 0;
+		carry_test = carry_test < 0; // Carry Flag - subtraction
 	}
 
-	// Zero Flag
-	if (!zero_test)
-	{
-		flags->Z = 1;
-	}
-	else
-	{
-		flags->Z &= 0; // Otherwise clear it
-	}
-} /* -----  end of function eight_bit_update_flags  ----- */
+	unsigned char computed = (unsigned char) ((zero_test ? 0x0 : FLAG_Z) |
+	                                          (half_carry ? FLAG_H : 0x0) |
+	                                          (carry_test ? FLAG_C : 0x0));
+	gb->regs.F = (unsigned char) ((gb->regs.F & ~mask) | (computed & mask));
+} /* -----  end of function eight_bit_flags  ----- */
 
 /*
  * ===  FUNCTION  ======================================================================
- *         Name:  sixteen_bit_update_flags
- *  Description:  Handles updates to the Z, H, and C flags
- *                after a sixteen-bit instruction executes. Assumes N flag has
- *                been set or cleared before this function is called
+ *         Name:  sixteen_bit_flags
+ *  Description:  Computes the Z, H, and C flags of a sixteen-bit arithmetic instruction
  *
  *   Parameters:  value1 is the first operand of an arithmetic instruction
  *                value2 is the second operand in an arithmetic instruction
+ *                subtract is the state of the N flag when the instruction ran
+ *                mask selects which of FLAG_Z, FLAG_H, and FLAG_C in F are written
  * =====================================================================================
  */
-void sixteen_bit_update_flags(unsigned short value1, unsigned short value2)
+static void
+sixteen_bit_flags(GB *gb, unsigned short value1, unsigned short value2, unsigned char subtract,
+                  unsigned char mask)
 {
 	int carry_test;
 	unsigned short zero_test;
+	unsigned char half_carry;
 
-	if (!flags->N) // If last op was addition
+	if (!subtract) // If last op was addition
 	{
 		carry_test = value1 + value2;
 		zero_test = (unsigned short)value1 + (unsigned short)value2;
 
 		// Half-Carry - addition
-		if ((((value1 & 0xFF) + (value2 & 0xFF)) & 0x100) == 0x100)
-		{
-			flags->H = 1;
-		}
-		else
-		{
-			flags->H = 0;
-		}
-
-		// Carry Flag - addition
-		if (carry_test > 0xFFFF)
-		{
-			flags->C = 1;
-		}
-		else
-		{
-			flags->C = 0;
-		}
+		half_carry = (((value1 & 0xFF) + (value2 & 0xFF)) & 0x100) == 0x100;
+		carry_test = carry_test > 0xFFFF; // Carry Flag - addition
 	}
 	// Otherwise subtraction
 	else
@@ -154,34 +120,111 @@ void sixteen_bit_update_flags(unsigned short value1, unsigned short value2)
 		zero_test = (unsigned short)value1 - (unsigned short)value2;
 
 		// Half Carry Flag - subtraction
-		if (((value1 & 0xFF) - (value2 & 0xFF)) < 0) // NOLINT
-		{
-			flags->H = 1;
-		}
-		else
-		{
-			flags->H = 0;
-		}
-		// Carry Flag - subtraction
-		if (carry_test < 0)
-		{
-			flags->C = 1;
-		}
-		else
-		{
-			flags->C = 0;
-		}
+		half_carry = ((value1 & 0xFF) - (value2 & 0xFF)) < 0; // NOLINT
+		carry_test = carry_test < 0; // Carry Flag - subtraction
 	}
 
-	// Zero Flag
-	if (!zero_test)
+	unsigned char computed = (unsigned char) ((zero_test ? 0x0 : FLAG_Z) |
+	                                          (half_carry ? FLAG_H : 0x0) |
+	                                          (carry_test ? FLAG_C : 0x0));
+	gb->regs.F = (unsigned char) ((gb->regs.F & ~mask) | (computed & mask));
+} /* -----  end of function sixteen_bit_flags  ----- */
+
+#ifdef LAZY_FLAGS
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  sync_flags
+ *  Description:  Brings the Z, H, and C flags up to date before they are read or
+ *                written directly. A pending op whose flags are all about to be
+ *                overwritten is dropped without computing them
+ *   Parameters:  overwritten is the FLAG_ mask of flags the caller will write
+ *                before reading any, 0 to materialize everything pending
+ * =====================================================================================
+ */
+void sync_flags(GB *gb, unsigned char overwritten)
+{
+	if (!gb->lazy.pending)
+	{
+		return;
+	}
+
+	if ((gb->lazy.pending & overwritten) == gb->lazy.pending)
 	{
-		flags->Z = 1;
+		gb->lazy_flags_stats.avoided++;
+	}
+	else if (gb->lazy.sixteen_bit)
+	{
+		sixteen_bit_flags(gb, gb->lazy.value1, gb->lazy.value2, gb->lazy.subtract, gb->lazy.pending);
+		gb->lazy_flags_stats.materialized++;
 	}
 	else
 	{
-		flags->Z = 0; // Otherwise clear it
+		eight_bit_flags(gb, (unsigned char) gb->lazy.value1, (unsigned char) gb->lazy.value2,
+		                gb->lazy.subtract, gb->lazy.pending);
+		gb->lazy_flags_stats.materialized++;
 	}
+	gb->lazy.pending = 0x0;
+} /* -----  end of function sync_flags  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  defer_flags
+ *  Description:  Records an arithmetic op so its flags can be worked out later
+ * =====================================================================================
+ */
+static void
+defer_flags(GB *gb, unsigned char sixteen_bit, unsigned short value1, unsigned short value2,
+            unsigned char mask)
+{
+	sync_flags(gb, mask); // Flags this op doesn't set may still be owed by the last one
+	gb->lazy.pending = mask;
+	gb->lazy.sixteen_bit = sixteen_bit;
+	gb->lazy.subtract = get_flag(FLAG_N);
+	gb->lazy.value1 = value1;
+	gb->lazy.value2 = value2;
+} /* -----  end of function defer_flags  ----- */
+#endif
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  eight_bit_update_flags
+ *  Description:  Handles updates to the Z, H, and C flags in the F register 
+ *  		  after an eight-bit instruction executes. Assumes N flag has
+ *  		  been set or cleared before this function is called
+ *  		  
+ *   Parameters:  value1 is the first operand of an arithmetic instruction
+ *   		  value2 is the second operand in an arithmetic instruction
+ *   		  mask selects which of FLAG_Z, FLAG_H, and FLAG_C the instruction sets
+ * =====================================================================================
+ */
+void eight_bit_update_flags(GB *gb, unsigned char value1, unsigned char value2, unsigned char mask)
+{
+#ifdef LAZY_FLAGS
+	defer_flags(gb, 0x0, value1, value2, mask);
+#else
+	eight_bit_flags(gb, value1, value2, get_flag(FLAG_N), mask);
+#endif
+} /* -----  end of function eight_bit_update_flags  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  sixteen_bit_update_flags
+ *  Description:  Handles updates to the Z, H, and C flags
+ *                after a sixteen-bit instruction executes. Assumes N flag has
+ *                been set or cleared before this function is called
+ *
+ *   Parameters:  value1 is the first operand of an arithmetic instruction
+ *                value2 is the second operand in an arithmetic instruction
+ *                mask selects which of FLAG_Z, FLAG_H, and FLAG_C the instruction sets
+ * =====================================================================================
+ */
+void sixteen_bit_update_flags(GB *gb, unsigned short value1, unsigned short value2, unsigned char mask)
+{
+#ifdef LAZY_FLAGS
+	defer_flags(gb, 0x1, value1, value2, mask);
+#else
+	sixteen_bit_flags(gb, value1, value2, get_flag(FLAG_N), mask);
+#endif
 } /* -----  end of function sixteen_bit_update_flags  ----- */
 
 /* 
@@ -191,10 +234,10 @@ void sixteen_bit_update_flags(unsigned short value1, unsigned short value2)
  * =====================================================================================
  */
 static unsigned char
-fetch()
+fetch(GB *gb)
 {
-	unsigned char opcode = read_memory(ptrs->PC);
-	ptrs->PC++;
+	unsigned char opcode = read_memory(gb, gb->regs.PC);
+	gb->regs.PC++;
 	return opcode;
 } /* -----  end of function fetch  ----- */
 
@@ -208,249 +251,191 @@ fetch()
  *                  the interrupt being requested
  * =====================================================================================
  */
-void request_interrupt(unsigned char bitSetter)
+void request_interrupt(GB *gb, unsigned char bitSetter)
 {
-	unsigned char req_reg = read_memory(0xFF0F);
+	unsigned char req_reg = read_memory(gb, 0xFF0F);
 	req_reg |= bitSetter;
-	write_memory(0xFF0F, req_reg);
+	write_memory(gb, 0xFF0F, req_reg);
 } /* -----  end of function request_interrupt  ----- */
 
 /*
  * ===  FUNCTION  ======================================================================
- *         Name:  decode
- *  Description:  Takes the current opcode pointed to by PC and determines 
- *  		  its generalized instruction (e.g. this is a 'load' instruction), 
- *  		  then calls the appropriate method to further decode and emulate it
- *   Parameters:  opcode is the opcode as an unsigned char to decode and execute
- *       Return:  The number of clock cycles used to execute the instruction
+ *         Name:  illegal_opcode
+ *  Description:  Handles the opcodes that don't exist on the gameboy cpu. The
+ *                  hardware locks up, so the instance stops with PC on the opcode
+ *                  and runs return at once until it's reset or a state is loaded
  * =====================================================================================
  */
 static unsigned char
-decode(unsigned char opcode)
+illegal_opcode(GB *gb, unsigned short operand)
+{
+	gb->regs.PC--;
+	gb->locked_up = 0x1;
+	return 0x4;
+} /* -----  end of function illegal_opcode  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  opcode_is_illegal
+ *  Description:  Checks for the opcodes that don't exist on the gameboy cpu
+ * =====================================================================================
+ */
+int opcode_is_illegal(unsigned char opcode)
+{
+	return opcode_table[opcode].execute == illegal_opcode;
+} /* -----  end of function opcode_is_illegal  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  opcode_ends_block
+ *  Description:  Checks for the opcodes that may change PC, which end a basic block
+ * =====================================================================================
+ */
+int opcode_ends_block(unsigned char opcode)
 {
 	switch (opcode)
 	{
-	case 0x00: // NOP
-		return 0x4;
-		// Rotate A instructions, Z flag always cleared
-	case 0x0F:
-		rrc(&regs->A);
-		flags->Z = 0;
-		return 0x4;
-	case 0x1F:
-		rr(&regs->A);
-		flags->Z = 0;
-		return 0x4;
-	case 0x07:
-		rlc(&regs->A);
-		flags->Z = 0;
-		return 0x4;
-	case 0x17:
-		rl(&regs->A);
-		flags->Z = 0;
-		return 0x4;
-		// Bit test, rotate, and shift instructions
-	case 0xCB:
-		opcode = fetch();
-		return bit_rotate_shift(opcode);
-		// Add instructions
-		// 8-bit
-	case 0xC6:
-	case 0xE8:
-	case 0x80 ... 0x87:
-		return eight_bit_add(opcode);
-		// 16-bit
-	case 0x09:
-	case 0x19:
-	case 0x29:
-	case 0x39:
-		return sixteen_bit_add(opcode);
-		// ADC instructions
-	case 0xCE:
-	case 0x88 ... 0x8F:
-		return adc(opcode);
-		// AND instructions
-	case 0xE6:
-	case 0xA0 ... 0xA7:
-		return and(opcode);
-		// SUB instructions
-	case 0xD6:
-	case 0x90 ... 0x97:
-		return sub(opcode);
-		// SBC instructions
-	case 0xDE:
-	case 0x98 ... 0x9F:
-		return sbc(opcode);
-		// 8-bit INC instructions
-	case 0x34:
-	case 0x3C:
-	case 0x04:
-	case 0x0C:
-	case 0x14:
-	case 0x1C:
-	case 0x24:
-	case 0x2C:
-		return eight_bit_inc(opcode);
-		// 16-bit INC instructions
-	case 0x03:
-	case 0x13:
-	case 0x23:
-	case 0x33:
-		return sixteen_bit_inc(opcode);
-		// 8-bit DEC instructions
-	case 0x35:
-	case 0x3D:
-	case 0x05:
-	case 0x0D:
-	case 0x15:
-	case 0x1D:
-	case 0x25:
-	case 0x2D:
-		return eight_bit_dec(opcode);
-		// 16-bit DEC instructions
-	case 0x0B:
-	case 0x1B:
-	case 0x2B:
-	case 0x3B:
-		return sixteen_bit_dec(opcode);
-		// OR instructions
-	case 0xF6:
-	case 0xB0 ... 0xB7:
-		return or (opcode);
-		// XOR instructions
-	case 0xEE:
-	case 0xA8 ... 0xAF:
-		return xor(opcode);
-		// DAA
-	case 0x27:
-		return daa();
-		// CPL
-	case 0x2F:
-		return cpl();
-		// CP instructions
-	case 0xFE:
-	case 0xB9 ... 0xBF:
-		return cp(opcode);
-		// Jump instructions
-	case 0xC3:
-	case 0xE9:
-	case 0xDA:
-	case 0xD2:
-	case 0xC2:
-	case 0xCA:
-		return jp(opcode);
-	case 0x18:
-	case 0x38:
-	case 0x30:
-	case 0x20:
-	case 0x28:
-		return jr(opcode);
-		// Call and return instructions
-	case 0xCD:
-	case 0xDC:
-	case 0xD4:
-	case 0xC4:
-	case 0xCC:
-		return call(opcode);
-	case 0xC8:
-	case 0xC9:
-	case 0xD8:
-	case 0xD0:
-	case 0xC0:
-		return ret(opcode);
-	case 0xD9:
-		return reti();
-	case 0xC7:
-	case 0xCF:
-	case 0xD7:
-	case 0xDF:
-	case 0xE7:
-	case 0xEF:
-	case 0xF7:
-	case 0xFF:
-		return rst(opcode);
-		// Load instructions
-	case 0x40 ... 0x75:
-	case 0x77 ... 0x7F:
-		return basic_ld(opcode);
-	case 0xF8:
-	case 0xF9:
-		return ld_hl_sp(opcode);
-	case 0x22:
-	case 0x2A:
-	case 0x32:
-	case 0x3A:
-		return load_hl(opcode);
-	case 0x06:
-	case 0x0E:
-	case 0x16:
-	case 0x1E:
-	case 0x26:
-	case 0x2E:
-	case 0x36:
-	case 0x3E:
-		return load_one_byte_imm(opcode);
-	case 0x0A:
-	case 0x1A:
-	case 0xFA:
-	case 0x02:
-	case 0x12:
-	case 0xEA:
-		return load_from_to_mem(opcode);
-	case 0x01:
-	case 0x08:
-	case 0x11:
-	case 0x21:
-	case 0x31:
-		return sixteen_bit_load(opcode);
-	case 0xF0:
-	case 0xE0:
-	case 0xF2:
-	case 0xE2:
-		return read_write_io(opcode);
-	case 0x76:
-		return halt();
-	case 0xF3:
-		return di();
-	case 0xFB:
-		return ei();
-	case 0x10:
-		return stop();
-	case 0xF1:
-	case 0xC1:
-	case 0xD1:
-	case 0xE1:
-		return pop(opcode);
-	case 0xC5:
-	case 0xD5:
-	case 0xE5:
-	case 0xF5:
-		return push(opcode);
-	case 0x3F:
-		return ccf();
-	case 0x37:
-		return scf();
-	default:
-		exit(1);
+		case 0x18: case 0x20: case 0x28: case 0x30: case 0x38: // JR
+		case 0xC3: case 0xC2: case 0xCA: case 0xD2: case 0xDA: case 0xE9: // JP
+		case 0xCD: case 0xC4: case 0xCC: case 0xD4: case 0xDC: // CALL
+		case 0xC9: case 0xC0: case 0xC8: case 0xD0: case 0xD8: case 0xD9: // RET, RETI
+		case 0xC7: case 0xCF: case 0xD7: case 0xDF: // RST
+		case 0xE7: case 0xEF: case 0xF7: case 0xFF:
+		case 0x76: case 0x10: // HALT, STOP
+			return 1;
+		default:
+			return 0;
+	}
+} /* -----  end of function opcode_ends_block  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  init_opcode_tables
+ *  Description:  Builds the tables used to decode opcodes, each instruction family
+ *                places the handlers for the opcodes it emulates
+ * =====================================================================================
+ */
+void init_opcode_tables()
+{
+	for (int i = 0; i < 0x100; i++)
+	{
+		opcode_table[i] = (Opcode) {illegal_opcode, 0x0};
+		cb_opcode_table[i] = illegal_opcode;
 	}
-} /* -----  end of function decode  ----- */
+
+	register_math_instructions(opcode_table);
+	register_logical_instructions(opcode_table);
+	register_control_instructions(opcode_table);
+	register_load_instructions(opcode_table);
+	register_cpu_control_instructions(opcode_table);
+	register_bit_rotate_shift_instructions(opcode_table, cb_opcode_table);
+} /* -----  end of function init_opcode_tables  ----- */
 
 /*
  * ===  FUNCTION  ======================================================================
  *         Name:  cpu_execution
  *  Description:  Emulates the three primary functions of the CPU using associated
  *                functions: fetch an opcode, decode it, execute it's instruction
- *   Parameters:  mem is a pointer to the virtual memory
  * =====================================================================================
  */
-void cpu_execution()
+void cpu_execution(GB *gb)
 {
 	unsigned char cycles;
+	unsigned short operand = 0;
 
-	unsigned char opcode = fetch();
+	unsigned char opcode = fetch(gb);
+	const Opcode *instruction = &opcode_table[opcode];
 
-	cycles = decode(opcode);
+	// Immediates are fetched here so handlers never need to touch PC to get them
+	if (instruction->length)
+	{
+		operand = fetch(gb);
+		if (instruction->length == 0x2)
+		{
+			operand = combine_bytes(fetch(gb), (unsigned char) operand);
+		}
+	}
 
-	update_timers(cycles);
-	update_graphics(cycles);
+	cycles = instruction->execute(gb, operand);
+
+	advance_clock(cycles);
 } /* -----  end of function cpu_execution  ----- */
+
+#ifndef THREADED_CORE
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  cpu_run
+ *  Description:  Executes instructions until a limit, a PC breakpoint or the end of a cycle run
+ *   Parameters:  max_instructions is the most instructions to execute
+ *                stop_pc stops execution when PC reaches it, pass -1 for no breakpoint
+ *       Return:  The number of instructions executed
+ * =====================================================================================
+ */
+unsigned long cpu_run(GB *gb, unsigned long max_instructions, int stop_pc)
+{
+	unsigned long executed = 0;
+
+	// Skipping HALTs and idle loops jumps the clock, so the end of a run is checked too
+	while (executed < max_instructions && gb->regs.PC != stop_pc &&
+	       gb->clock.cycles < gb->clock.run_until && !gb->locked_up)
+	{
+#if defined(JIT) || defined(BLOCK_CACHE)
+		// Blocks run whole, so one may only start if it surely ends by the end of the run
+		unsigned long block_budget = (gb->clock.run_until - gb->clock.cycles) / LONGEST_INSTRUCTION_CYCLES;
+
+		if (block_budget > max_instructions - executed)
+		{
+			block_budget = max_instructions - executed;
+		}
+#endif
+#ifdef JIT
+		unsigned int translated = jit_execute(gb, block_budget, stop_pc);
+		if (translated)
+		{
+			executed += translated;
+			continue;
+		}
+#elif defined(BLOCK_CACHE)
+		unsigned int replayed = block_cache_execute(gb, block_budget, stop_pc);
+		if (replayed)
+		{
+			executed += replayed;
+			continue;
+		}
+#endif
+		cpu_execution(gb);
+		executed++;
+	}
+
+	sync_flags(gb, 0x0); // Leave the flags readable by the caller
+	return executed;
+} /* -----  end of function cpu_run  ----- */
+#endif
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  cpu_run_cycles
+ *  Description:  Executes instructions until the clock has advanced by a number of
+ *                cycles, a PC breakpoint is reached, or the cpu locks up. The cores count instructions,
+ *                so they're given as many as surely fit in the cycles left until
+ *                fewer than one instruction's worth remain
+ *   Parameters:  cycles is the number of clock cycles to run for
+ *                stop_pc stops execution when PC reaches it, pass -1 for no breakpoint
+ *       Return:  The number of cycles run, which may pass the request by less than
+ *                one instruction
+ * =====================================================================================
+ */
+unsigned long cpu_run_cycles(GB *gb, unsigned long cycles, int stop_pc)
+{
+	unsigned long start = gb->clock.cycles;
+	unsigned long target = start + cycles;
+
+	gb->clock.run_until = target;
+	while (gb->clock.cycles < target && gb->regs.PC != stop_pc && !gb->locked_up)
+	{
+		gb->instructions += cpu_run(gb, (target - gb->clock.cycles) / LONGEST_INSTRUCTION_CYCLES + 0x1,
+		                            stop_pc);
+	}
+	gb->clock.run_until = ULONG_MAX;
+	return gb->clock.cycles - start;
+} /* -----  end of function cpu_run_cycles  ----- */
@@ -0,0 +1,181 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  gb.c
+ *
+ *    Description:  Creation and destruction of emulator instances. An instance is a
+ *                  single mapping holding the registers, memory, and every other
+ *                  piece of state, only the cartridge and the code caches live
+ *                  outside of it. Instances forked from a snapshot map its image
+ *                  privately, so the kernel copies a page only once a fork writes it
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 20:52:13
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Matt Gercz (matt.gercz@icloud.com)
+ *
+ * =====================================================================================
+ */
+#define _GNU_SOURCE // memfd_create
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "gb.h"
+
+#define PAGE_SIZE 0x1000
+
+struct Snapshot
+{
+	int image; // File holding the instance as it was, never written after it's made
+	Cartridge *cartridge; // Reference kept for the forks
+};
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  init_gb
+ *  Description:  Allocates an emulator instance with its registers in their state
+ *                  after the boot ROM. load_cartridge and init_memory must run
+ *                  before it executes anything
+ *       Return:  Pointer to the new instance, NULL if out of memory
+ * =====================================================================================
+ */
+	GB*
+init_gb()
+{
+	// Page aligned, which keeps the register file in one cache line, and zeroed
+	// pages that are never touched, like unused external RAM, cost nothing
+	GB *gb = mmap(NULL, sizeof(*gb), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0x0);
+	if (gb == MAP_FAILED)
+	{
+		return NULL;
+	}
+
+	init_registers(&gb->regs);
+	gb->breakpoint = -1;
+	return gb;
+}		/* -----  end of function init_gb  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  free_gb
+ *  Description:  Releases an instance along with its cartridge and code caches
+ * =====================================================================================
+ */
+	void
+free_gb(GB *gb)
+{
+	if (gb == NULL)
+	{
+		return;
+	}
+#ifdef JIT
+	jit_free(gb);
+#elif defined(BLOCK_CACHE)
+	free(gb->block_cache);
+#endif
+	release_cartridge(gb->cartridge);
+	munmap(gb, sizeof(*gb));
+}		/* -----  end of function free_gb  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  take_snapshot
+ *  Description:  Freezes the state of an instance so it can be forked any number of
+ *                  times, the instance itself keeps running unaffected. Pages that
+ *                  are all zero are left as holes in the image
+ *       Return:  The snapshot, NULL if it can't be made
+ * =====================================================================================
+ */
+	Snapshot*
+take_snapshot(GB *gb)
+{
+	static const unsigned char zero_page[PAGE_SIZE];
+	Snapshot *snapshot = malloc(sizeof(*snapshot));
+	const unsigned char *bytes = (const unsigned char *) gb;
+	int failed;
+
+	if (snapshot == NULL)
+	{
+		return NULL;
+	}
+	snapshot->image = memfd_create("mattygboy-snapshot", MFD_CLOEXEC);
+	failed = snapshot->image < 0 || ftruncate(snapshot->image, sizeof(*gb));
+	for (unsigned long offset = 0x0; !failed && offset < sizeof(*gb); offset += PAGE_SIZE)
+	{
+		unsigned long length = sizeof(*gb) - offset < PAGE_SIZE ? sizeof(*gb) - offset : PAGE_SIZE;
+
+		if (memcmp(bytes + offset, zero_page, length))
+		{
+			failed = pwrite(snapshot->image, bytes + offset, length, (off_t) offset) != (ssize_t) length;
+		}
+	}
+
+	if (failed)
+	{
+		if (snapshot->image >= 0)
+		{
+			close(snapshot->image);
+		}
+		free(snapshot);
+		return NULL;
+	}
+	snapshot->cartridge = share_cartridge(gb->cartridge);
+	return snapshot;
+}		/* -----  end of function take_snapshot  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  fork_snapshot
+ *  Description:  Makes an instance that carries on from a snapshot. Its pages are
+ *                  shared with the snapshot and every other fork until it writes
+ *                  them, the rom is shared read only
+ *       Return:  The new instance, NULL if it can't be mapped
+ * =====================================================================================
+ */
+	GB*
+fork_snapshot(Snapshot *snapshot)
+{
+	GB *gb = mmap(NULL, sizeof(*gb), PROT_READ | PROT_WRITE, MAP_PRIVATE, snapshot->image, 0x0);
+
+	if (gb == MAP_FAILED)
+	{
+		return NULL;
+	}
+
+	// Pointers into the instance moved along with it
+	gb->cartridge = share_cartridge(snapshot->cartridge);
+	gb->mbc = gb->mbc != NULL ? &gb->mbc_registers : NULL;
+	gb->ext_ram_bank = gb->ext_ram_bank != NULL ? gb->ext_ram : NULL;
+	update_memory_map(gb);
+
+	// Forks build their own code caches, the parent's belongs to the parent
+#ifdef JIT
+	gb->jit = NULL;
+	memset(gb->code_lines, 0x0, sizeof(gb->code_lines));
+#elif defined(BLOCK_CACHE)
+	gb->block_cache = NULL;
+	memset(gb->code_lines, 0x0, sizeof(gb->code_lines));
+#endif
+	return gb;
+}		/* -----  end of function fork_snapshot  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  free_snapshot
+ *  Description:  Releases a snapshot, forks made from it carry on
+ * =====================================================================================
+ */
+	void
+free_snapshot(Snapshot *snapshot)
+{
+	if (snapshot == NULL)
+	{
+		return;
+	}
+	close(snapshot->image);
+	release_cartridge(snapshot->cartridge);
+	free(snapshot);
+}		/* -----  end of function free_snapshot  ----- */
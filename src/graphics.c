@@ -16,12 +16,29 @@
  *
  * =====================================================================================
  */
+#include <limits.h>
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 #include "global_declarations.h"
 #include "cpu_emulator.h"
 #include "memory.h"
+#include "scheduler.h"
 
-// Used to track, based on cpu cycles, when the scanline register should be incremented
-static unsigned short scanline_counter = 0x0;
+// Clock cycles spent in each mode of a visible line, every line takes 0x1C8
+#define OAM_SEARCH_CYCLES 0x50
+#define TRANSFER_CYCLES 0xAC
+#define HBLANK_CYCLES 0xCC
+#define LINE_CYCLES 0x1C8
+#define FRAME_CYCLES 0x11250 // 0x90 visible lines and 0xA lines of V-Blank
+
+#define OAM_ENTRIES 0x28
+#define LINE_SPRITES 0xA // Most sprites shown on one line
+
+// Flags beside the colour of a sprite pixel waiting to be mixed with the background
+#define SPRITE_OBP1 0x4u
+#define SPRITE_BEHIND 0x8u
 
 /*
  * ===  FUNCTION  ======================================================================
@@ -31,125 +48,520 @@ static unsigned short scanline_counter = 0x0;
  * =====================================================================================
  */
     int
-is_lcd_enabled()
+is_lcd_enabled(GB *gb)
 {
-    unsigned char lcd_enable = read_memory(0xFF40);
+    unsigned char lcd_enable = read_memory(gb, 0xFF40);
 
     return (lcd_enable & 0x80u) == 0x80u;
 }        /* -----  end of function is_lcd_enabled  ----- */
 
 /*
  * ===  FUNCTION  ======================================================================
- *         Name:  set_lcd_status
- *  Description:  Handles updates to the lcd status register at mem addr 0xFF41
+ *         Name:  set_lcd_mode
+ *  Description:  Updates the mode in the lcd status register at mem addr 0xFF41 and
+ *                  requests the lcd interrupt if it's enabled for the new mode
+ *   Parameters:  mode is 0 for H-Blank, 1 for V-Blank, 2 for OAM search, and 3 for
+ *                  the transfer to the lcd
  * =====================================================================================
  */
-    void
-set_lcd_status()
+    static void
+set_lcd_mode(GB *gb, unsigned char mode)
 {
-    unsigned char status = read_memory(0xFF41);
+    // STAT bits 3, 4, and 5 enable the interrupt for modes 0, 1, and 2
+    static const unsigned char interrupt_enable[0x4] = {0x8u, 0x10u, 0x20u, 0x0u};
+    unsigned char status = read_memory(gb, 0xFF41);
 
-    if (!is_lcd_enabled()) {
-        // If lcd disabled reset scanline and counter, set mode 1 (VBlank)
-        scanline_counter = 0x0;
-        write_memory(0xFF44, 0x0); // All writes to this address set to 0
-        status |= 0x1u;
-        write_memory(0xFF41, status);
-        return;
+    gb->lcd.mode = mode;
+    status = (unsigned char) ((status & 0xFCu) | mode);
+    if (status & interrupt_enable[mode])
+    {
+        request_interrupt(gb, 0x2u);
     }
+    write_memory(gb, 0xFF41, status);
+}        /* -----  end of function set_lcd_mode  ----- */
 
-    unsigned char cur_line = read_memory(0xFF44);
-    unsigned char cur_mode = status & 0x3u;
-    unsigned char mode;
-    unsigned int req_int = 0x0; // interrupt request, default false
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  compare_line
+ *  Description:  Updates the coincidence flag after LY changes, requesting the lcd
+ *                  interrupt if it's enabled
+ * =====================================================================================
+ */
+    static void
+compare_line(GB *gb)
+{
+    unsigned char status = read_memory(gb, 0xFF41);
 
-    if (cur_line >= 0x90u)
+    if (read_memory(gb, 0xFF44) == read_memory(gb, 0xFF45))
     {
-        // V-Blank, mode 1
-        status &= 0xFDu;
-        status |= 0x1u;
-        mode = 0x1u;
-        req_int = status & 0x10u;
+        status |= 0x4u;
+        if (status & 0x40u)
+        {
+            request_interrupt(gb, 0x2u);
+        }
     }
     else
     {
-        // Set bounds to compare scanline counter against
-        int mode_two_bound = 0x50;
-        int mode_three_bound = mode_two_bound + 0xAC;
+        status &= 0xFBu;
+    }
+    write_memory(gb, 0xFF41, status);
+}        /* -----  end of function compare_line  ----- */
+
+#ifdef __SSE2__
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  spread_row
+ *  Description:  Turns one tile row, its low byte copied into lanes 0-7 and its high
+ *                  byte into lanes 8-15, into the colour of each pixel in lanes 0-7
+ * =====================================================================================
+ */
+    static inline __m128i
+spread_row(__m128i row)
+{
+    const __m128i bits = _mm_set_epi8(0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, (char) 0x80,
+                                      0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, (char) 0x80);
+    const __m128i weights = _mm_set_epi8(0x2, 0x2, 0x2, 0x2, 0x2, 0x2, 0x2, 0x2,
+                                         0x1, 0x1, 0x1, 0x1, 0x1, 0x1, 0x1, 0x1);
+    __m128i colour = _mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(row, bits), bits), weights);
+
+    return _mm_or_si128(colour, _mm_srli_si128(colour, 0x8));
+}        /* -----  end of function spread_row  ----- */
+#endif
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  decode_tile
+ *  Description:  Combines the two bytes of each row of a tile into the colour of its
+ *                  pixels, left to right and top to bottom
+ *   Parameters:  tile points at the 16 bytes of the tile, low byte of each row first
+ * =====================================================================================
+ */
+    static void
+decode_tile(const unsigned char *tile, unsigned char pixels[TILE_PIXELS])
+{
+#ifdef __SSE2__
+    __m128i data = _mm_loadu_si128((const __m128i *) tile);
+    __m128i doubled[0x2] = {_mm_unpacklo_epi8(data, data), _mm_unpackhi_epi8(data, data)};
+
+    // Each doubling step spreads the bytes wider until one row fills a register
+    for (unsigned int half = 0x0; half < 0x2u; half++)
+    {
+        __m128i pairs[0x2] = {_mm_unpacklo_epi16(doubled[half], doubled[half]),
+                              _mm_unpackhi_epi16(doubled[half], doubled[half])};
 
-        if (scanline_counter <= mode_two_bound)
+        for (unsigned int pair = 0x0; pair < 0x2u; pair++)
         {
-            status &= 0xFEu;
-            status |= 0x2u;
-            mode = 0x2u;
-            req_int = status & 0x20u;
+            __m128i first = spread_row(_mm_unpacklo_epi32(pairs[pair], pairs[pair]));
+            __m128i second = spread_row(_mm_unpackhi_epi32(pairs[pair], pairs[pair]));
+
+            _mm_storeu_si128((__m128i *) &pixels[(half * 0x2u + pair) * 0x10u], _mm_unpacklo_epi64(first, second));
         }
-        else if (scanline_counter <= mode_three_bound)
+    }
+#else
+    for (unsigned int i = 0x0; i < TILE_PIXELS; i++)
+    {
+        unsigned int bit = 0x7u - (i & 0x7u);
+        const unsigned char *row = &tile[(i / 0x8u) * 0x2u];
+
+        pixels[i] = (unsigned char) (((row[0x0] >> bit) & 0x1u) | (((row[0x1] >> bit) & 0x1u) << 0x1u));
+    }
+#endif
+}        /* -----  end of function decode_tile  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  decoded_tile
+ *  Description:  Returns the pixels of a tile in VRAM, decoding it again only after a
+ *                  write to it
+ *   Parameters:  index is the tile's position from 0x8000, 0 to VRAM_TILES - 1
+ * =====================================================================================
+ */
+    static const unsigned char*
+decoded_tile(GB *gb, unsigned int index)
+{
+    Tile_Cache *cache = &gb->tile_cache;
+
+    if (!cache->valid[index])
+    {
+        decode_tile(&gb->memory[0x8000 + index * 0x10u], cache->pixels[index]);
+        cache->valid[index] = 0x1;
+    }
+    return cache->pixels[index];
+}        /* -----  end of function decoded_tile  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  invalidate_graphics
+ *  Description:  Forgets every decoded tile and drawn line, for when VRAM, OAM or the
+ *                  lcd registers change without going through write_memory
+ * =====================================================================================
+ */
+    void
+invalidate_graphics(GB *gb)
+{
+    memset(gb->tile_cache.valid, 0x0, sizeof(gb->tile_cache.valid));
+    gb->line_cache.writes++;
+    gb->line_cache.frame_unchanged = 0x0;
+}        /* -----  end of function invalidate_graphics  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  map_tile
+ *  Description:  Finds a background or window tile, LCDC bit 4 picks unsigned numbers
+ *                  from 0x8000 or signed numbers around 0x9000
+ *       Return:  The tile's position from 0x8000
+ * =====================================================================================
+ */
+    static unsigned int
+map_tile(GB *gb, unsigned char tile)
+{
+    if (gb->memory[0xFF40] & 0x10u)
+    {
+        return tile;
+    }
+    return (unsigned int) (0x100 + (signed char) tile);
+}        /* -----  end of function map_tile  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  draw_tiles
+ *  Description:  Copies one row of a tile map into a line, wrapping around its right
+ *                  edge
+ *   Parameters:  map is the address of the tile map
+ *                map_x and map_y are the pixel of the map the line starts on
+ *                indices receives the colour of count pixels
+ * =====================================================================================
+ */
+    static void
+draw_tiles(GB *gb, unsigned short map, unsigned int map_x, unsigned int map_y,
+           unsigned char *indices, unsigned int count)
+{
+    const unsigned char *tiles = &gb->memory[map + (map_y / 0x8u) * 0x20u];
+    unsigned int row = (map_y & 0x7u) * 0x8u;
+
+    for (unsigned int x = 0x0; x < count;)
+    {
+        unsigned int span = 0x8u - (map_x & 0x7u);
+
+        if (span > count - x)
         {
-            status |= 0x3u;
-            mode = 0x3;
+            span = count - x;
         }
-        else
+        memcpy(&indices[x], decoded_tile(gb, map_tile(gb, tiles[map_x / 0x8u])) + row + (map_x & 0x7u), span);
+        x += span;
+        map_x = (map_x + span) & 0xFFu;
+    }
+}        /* -----  end of function draw_tiles  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  draw_sprites
+ *  Description:  Draws the first LINE_SPRITES sprites in OAM that cover a line. Where
+ *                  they overlap the one further left wins, then the one earlier in OAM
+ *   Parameters:  sprites receives each pixel's colour and SPRITE_ flags, 0 where no
+ *                  sprite shows
+ * =====================================================================================
+ */
+    static void
+draw_sprites(GB *gb, unsigned char line, unsigned char sprites[SCREEN_WIDTH])
+{
+    unsigned int height = (gb->memory[0xFF40] & 0x4u) ? 0x10u : 0x8u;
+    const unsigned char *shown[LINE_SPRITES];
+    unsigned int count = 0x0;
+
+    memset(sprites, 0x0, SCREEN_WIDTH);
+    for (unsigned int i = 0x0; i < OAM_ENTRIES && count < LINE_SPRITES; i++)
+    {
+        const unsigned char *sprite = &gb->memory[0xFE00 + i * 0x4u];
+        unsigned int row = line + 0x10u - sprite[0x0];
+
+        if (row < height)
         {
-            status &= 0xFCu;
-            mode = 0x0u;
-            req_int = status & 0x4u;
+            // Sorted by x, sprites with the same x stay in OAM order
+            unsigned int slot = count++;
+
+            for (; slot && shown[slot - 0x1u][0x1] > sprite[0x1]; slot--)
+            {
+                shown[slot] = shown[slot - 0x1u];
+            }
+            shown[slot] = sprite;
         }
     }
 
-    // Check if we should trigger lcd interrupt
-    if (req_int && (mode != cur_mode))
+    // Lowest priority first so the winners draw over it
+    while (count--)
     {
-        request_interrupt(0x2u);
+        const unsigned char *sprite = shown[count];
+        unsigned char attributes = sprite[0x3];
+        unsigned int row = line + 0x10u - sprite[0x0];
+        unsigned char tile = sprite[0x2];
+        const unsigned char *pixels;
+        unsigned char flags = (unsigned char) (((attributes & 0x10u) ? SPRITE_OBP1 : 0x0u) |
+                                               ((attributes & 0x80u) ? SPRITE_BEHIND : 0x0u));
+
+        if (attributes & 0x40u) // Y flip
+        {
+            row = height - 0x1u - row;
+        }
+        if (height == 0x10u)
+        {
+            tile &= 0xFEu;
+        }
+        pixels = decoded_tile(gb, tile + (row >> 0x3u)) + (row & 0x7u) * 0x8u; // 8x16 sprites span two tiles
+
+        for (unsigned int x = 0x0; x < 0x8u; x++)
+        {
+            unsigned int screen_x = sprite[0x1] + x - 0x8u;
+            unsigned char colour = pixels[(attributes & 0x20u) ? 0x7u - x : x];
+
+            if (screen_x < SCREEN_WIDTH && colour)
+            {
+                sprites[screen_x] = colour | flags;
+            }
+        }
     }
+}        /* -----  end of function draw_sprites  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  render_line
+ *  Description:  Draws one line of the background, window and sprites into the
+ *                  framebuffer
+ *   Parameters:  window_start is the first pixel the window covers, SCREEN_WIDTH if
+ *                  it isn't shown on this line
+ *                window_line is the line of the window shown there
+ * =====================================================================================
+ */
+    static void
+render_line(GB *gb, unsigned char line, unsigned int window_start, unsigned char window_line)
+{
+    unsigned char control = gb->memory[0xFF40];
+    unsigned char *indices = &gb->pixel_indices[line * SCREEN_WIDTH];
+    unsigned char *shades = &gb->framebuffer[line * SCREEN_WIDTH];
+    unsigned char sprites[SCREEN_WIDTH];
 
-    // ...and the coincidence flag
-    if (read_memory(0xFF44) == read_memory(0xFF45))
+    if (!(control & 0x1u)) // Background and window off, only sprites show
     {
-        status |= 0x4u;
-        if (status & 0x40u)
+        memset(indices, 0x0, SCREEN_WIDTH);
+    }
+    else
+    {
+        draw_tiles(gb, (control & 0x8u) ? 0x9C00 : 0x9800, gb->memory[0xFF43],
+                   (line + gb->memory[0xFF42]) & 0xFFu, indices, window_start);
+        if (window_start < SCREEN_WIDTH)
         {
-            request_interrupt(0x2u);
+            draw_tiles(gb, (control & 0x40u) ? 0x9C00 : 0x9800, window_start + 0x7u - gb->memory[0xFF4B],
+                       window_line, &indices[window_start], SCREEN_WIDTH - window_start);
         }
     }
-    else
+
+    for (unsigned int x = 0x0; x < SCREEN_WIDTH; x++)
     {
-        status &= 0xFBu;
+        shades[x] = (control & 0x1u) ? (gb->memory[0xFF47] >> (indices[x] * 0x2u)) & 0x3u : 0x0;
+    }
+
+    if (!(control & 0x2u))
+    {
+        return;
+    }
+    draw_sprites(gb, line, sprites);
+    for (unsigned int x = 0x0; x < SCREEN_WIDTH; x++)
+    {
+        unsigned char sprite = sprites[x];
+
+        if (sprite && (!(sprite & SPRITE_BEHIND) || !indices[x]))
+        {
+            unsigned char palette = gb->memory[(sprite & SPRITE_OBP1) ? 0xFF49 : 0xFF48];
+
+            indices[x] = sprite & 0x3u;
+            shades[x] = (palette >> ((sprite & 0x3u) * 0x2u)) & 0x3u;
+        }
     }
+}        /* -----  end of function render_line  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  draw_line
+ *  Description:  Draws the line in LY into the framebuffer once its transfer to the
+ *                  lcd is over. A line keeps what it had last frame when nothing it's
+ *                  drawn from was written since then
+ * =====================================================================================
+ */
+    static void
+draw_line(GB *gb)
+{
+    Line_Cache *cache = &gb->line_cache;
+    unsigned char control = gb->memory[0xFF40];
+    unsigned char line = gb->memory[0xFF44];
+    unsigned int window_x = gb->memory[0xFF4B]; // The window's left edge is at WX - 7
+    unsigned int window_start = SCREEN_WIDTH;
+    unsigned char window_line;
 
-    // write status back to status register
-    write_memory(0xFF41, status);
-}        /* -----  end of function set_lcd_status  ----- */
+    if (line == 0x0)
+    {
+        gb->lcd.window_line = 0x0;
+        cache->frame_drawn = 0x0;
+    }
+
+    // The window's line only moves on lines it shows on, kept lines included
+    window_line = gb->lcd.window_line;
+    if ((control & 0x21u) == 0x21u && line >= gb->memory[0xFF4A] && window_x < SCREEN_WIDTH + 0x7u)
+    {
+        window_start = window_x < 0x7u ? 0x0 : window_x - 0x7u;
+        gb->lcd.window_line++;
+    }
+
+    if (cache->line_writes[line] != cache->writes || cache->line_window[line] != window_line)
+    {
+        render_line(gb, line, window_start, window_line);
+        cache->line_writes[line] = cache->writes;
+        cache->line_window[line] = window_line;
+        cache->frame_drawn = 0x1;
+    }
+
+    if (line == SCREEN_HEIGHT - 0x1u)
+    {
+        cache->frame_unchanged = (unsigned char) !cache->frame_drawn;
+    }
+}        /* -----  end of function draw_line  ----- */
 
 /*
  * ===  FUNCTION  ======================================================================
- *         Name:  update_graphics
- *  Description:  Handles updates to the graphics registers
- *   Parameters:  mem is a pointer to the virtual memory
- *                cycles is the number of cpu cycles this execution
+ *         Name:  start_lcd
+ *  Description:  Starts drawing a frame from line 0 when the lcd is turned on
+ * =====================================================================================
+ */
+    static void
+start_lcd(GB *gb)
+{
+    write_memory(gb, 0xFF44, 0x0); // All writes to this address set to 0
+    compare_line(gb);
+    set_lcd_mode(gb, 0x2u);
+    schedule_event(gb, EVENT_LCD, gb->clock.cycles + OAM_SEARCH_CYCLES);
+}        /* -----  end of function start_lcd  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  init_graphics
+ *  Description:  Schedules the first lcd event after a reset
  * =====================================================================================
  */
     void
-update_graphics(unsigned char cycles)
+init_graphics(GB *gb)
 {
-    set_lcd_status();
+    invalidate_graphics(gb);
+    gb->lcd.on = (unsigned char) is_lcd_enabled(gb);
+    if (gb->lcd.on)
+    {
+        start_lcd(gb);
+    }
+}        /* -----  end of function init_graphics  ----- */
 
-    if (is_lcd_enabled())
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  lcd_control_changed
+ *  Description:  Starts or stops the lcd after a write to mem addr 0xFF40
+ * =====================================================================================
+ */
+    void
+lcd_control_changed(GB *gb)
+{
+    if (is_lcd_enabled(gb) == gb->lcd.on)
     {
-        for (int i = 0x0; i < cycles; i++)
-        {
-            scanline_counter++;
-            if (scanline_counter == 0x1C8)
-            {
-                scanline_counter = 0x0;
-                increment_scanline();
-            }
-        }
+        return;
     }
-    else
+
+    gb->lcd.on = (unsigned char) !gb->lcd.on;
+    if (gb->lcd.on)
     {
+        start_lcd(gb);
         return;
     }
 
-}        /* -----  end of function update_graphics  ----- */
+    // A disabled lcd sits on line 0 in H-Blank without raising interrupts, showing nothing
+    cancel_event(gb, EVENT_LCD);
+    memset(gb->framebuffer, 0x0, sizeof(gb->framebuffer));
+    memset(gb->pixel_indices, 0x0, sizeof(gb->pixel_indices));
+    gb->line_cache.frame_unchanged = 0x0;
+    write_memory(gb, 0xFF44, 0x0);
+    gb->lcd.mode = 0x0;
+    write_memory(gb, 0xFF41, (unsigned char) (read_memory(gb, 0xFF41) & 0xFCu));
+}        /* -----  end of function lcd_control_changed  ----- */
 
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  lcd_event
+ *  Description:  Moves the lcd to its next mode, and to the next line at the end of
+ *                  H-Blank or of each V-Blank line
+ *   Parameters:  due is the cycle the change was scheduled for
+ * =====================================================================================
+ */
+    void
+lcd_event(GB *gb, unsigned long due)
+{
+    switch (gb->lcd.mode)
+    {
+        case 0x2: // OAM search done, start the transfer to the lcd
+            set_lcd_mode(gb, 0x3u);
+            schedule_event(gb, EVENT_LCD, due + TRANSFER_CYCLES);
+            break;
+        case 0x3:
+            draw_line(gb);
+            set_lcd_mode(gb, 0x0u);
+            schedule_event(gb, EVENT_LCD, due + HBLANK_CYCLES);
+            break;
+        default: // End of a line
+            increment_scanline(gb);
+            compare_line(gb);
+            if (read_memory(gb, 0xFF44) < 0x90u)
+            {
+                set_lcd_mode(gb, 0x2u);
+                schedule_event(gb, EVENT_LCD, due + OAM_SEARCH_CYCLES);
+            }
+            else
+            {
+                if (gb->lcd.mode != 0x1u)
+                {
+                    set_lcd_mode(gb, 0x1u);
+                }
+                schedule_event(gb, EVENT_LCD, due + LINE_CYCLES);
+            }
+            break;
+    }
+}        /* -----  end of function lcd_event  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  next_vblank
+ *  Description:  Works out the cycle the next frame is finished on, when LY becomes
+ *                  0x90 and V-Blank starts. A disabled lcd finishes a frame every
+ *                  FRAME_CYCLES so hosts still see time pass
+ *       Return:  The cycle V-Blank starts on, always after the current cycle
+ * =====================================================================================
+ */
+    unsigned long
+next_vblank(GB *gb)
+{
+    unsigned long line_end = event_due(gb, EVENT_LCD); // Cycle LY next increments
+    unsigned long line = gb->memory[0xFF44];
+
+    if (!gb->lcd.on || line_end == ULONG_MAX)
+    {
+        return gb->clock.cycles + FRAME_CYCLES;
+    }
+    if (gb->lcd.mode == 0x2u)
+    {
+        line_end += TRANSFER_CYCLES + HBLANK_CYCLES;
+    }
+    else if (gb->lcd.mode == 0x3u)
+    {
+        line_end += HBLANK_CYCLES;
+    }
+
+    if (line < 0x90u)
+    {
+        return line_end + (0x8Fu - line) * LINE_CYCLES;
+    }
+    // Finish V-Blank, then draw the 0x90 visible lines of the next frame
+    return line_end + (0x99u - line + 0x90u) * LINE_CYCLES;
+}        /* -----  end of function next_vblank  ----- */
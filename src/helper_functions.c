@@ -19,6 +19,7 @@
 #include <stdio.h>
 #include "helper_functions.h"
 #include "global_declarations.h"
+#include "cpu_emulator.h"
 
 /* 
  * ===  FUNCTION  ======================================================================
@@ -44,20 +45,16 @@ delay (unsigned int mseconds)
  * =====================================================================================
  */
 	void
-dump_registers()
+dump_registers(GB *gb)
 {
-	unsigned short AF = regs->A << 0x8u;
-	AF += (flags->Z << 0x7u); AF += (flags->N << 0x6u);
-	AF += (flags->H << 0x5u); AF += (flags->C << 0x4u);
-	unsigned short BC = combine_bytes(regs->B, regs->C);
-	unsigned short DE = combine_bytes(regs->D, regs->E);
-	unsigned short HL = combine_bytes(regs->H, regs->L);
-
-	printf("Registers:\nAF: 0x%04X\nBC: 0x%04X\nDE: 0x%04X\nHL: 0x%04X\n", AF, BC, DE, HL);
+	sync_flags(gb, 0x0);
+	printf("Registers:\nAF: 0x%04X\nBC: 0x%04X\nDE: 0x%04X\nHL: 0x%04X\n",
+			gb->regs.AF, gb->regs.BC, gb->regs.DE, gb->regs.HL);
 	printf("Stack pointer: 0x%02X Program Counter: 0x%02X\n",
-			ptrs->SP, ptrs->PC);
+			gb->regs.SP, gb->regs.PC);
 	printf("Flags: Z: 0x%02X N: 0x%02X H: 0x%02X C: 0x%02X IME: 0x%02X\n\n",
-			flags->Z, flags->N, flags->H, flags->C, flags->IME);
+			get_flag(FLAG_Z), get_flag(FLAG_N), get_flag(FLAG_H), get_flag(FLAG_C),
+			gb->regs.IME);
 }		/* -----  end of function dump_registers  ----- */
 
 /*
@@ -67,14 +64,14 @@ dump_registers()
  * =====================================================================================
  */
     void
-dump_memory(unsigned short start, unsigned short end)
+dump_memory(GB *gb, unsigned short start, unsigned short end)
 {
     for (int i = start; i < end; i += 0x10)
     {
         printf("%02X |  ", i);
         for (int j = i; j < i + 0x10; j++)
         {
-            printf("%02X ", read_memory(j));
+            printf("%02X ", read_memory(gb, j));
         }
         printf("\n");
     }
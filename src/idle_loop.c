@@ -0,0 +1,353 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  idle_loop.c
+ *
+ *    Description:  Detects short loops that do nothing but poll i/o registers, like
+ *                  ldh a,(44); cp 90; jr nz, waiting for something to change. Those
+ *                  registers only change when an event runs, so once an iteration
+ *                  has run without one every iteration until the next event does
+ *                  the same, and the clock jumps over them
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 18:31:44
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Matt Gercz (matt.gercz@icloud.com)
+ *
+ * =====================================================================================
+ */
+#include <stdio.h>
+#include <string.h>
+#include "idle_loop.h"
+#include "global_declarations.h"
+#include "memory.h"
+#include "scheduler.h"
+
+#define MAX_LOOP_BYTES 0x20
+#define IDLE_LIMIT 0x11250 // Most cycles skipped at once, a frame's worth
+#define JR_TAKEN_CYCLES 0xC
+
+// What an instruction in the loop reads and writes, registers and flags separately
+// since BIT leaves C alone
+#define USES_A 0x1u
+#define USES_B 0x2u
+#define USES_C 0x4u
+#define USES_D 0x8u
+#define USES_E 0x10u
+#define USES_H 0x20u
+#define USES_L 0x40u
+#define USES_FLAG_Z 0x80u
+#define USES_FLAG_N 0x100u
+#define USES_FLAG_H 0x200u
+#define USES_FLAG_C 0x400u
+#define USES_FLAGS (USES_FLAG_Z | USES_FLAG_N | USES_FLAG_H | USES_FLAG_C)
+
+// Registers B, C, D, E, H, L, memory[HL], A in the order opcodes number them
+static const unsigned short register_uses[0x8] = {
+	USES_B, USES_C, USES_D, USES_E, USES_H, USES_L, 0x0, USES_A
+};
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  only_changed_by_events
+ *  Description:  Checks for the registers a polling loop may read, ones that only
+ *                  the lcd and timer events or the cpu itself change. DIV, TIMA,
+ *                  and the joypad change without an event so aren't included
+ * =====================================================================================
+ */
+	static int
+only_changed_by_events (unsigned short addr)
+{
+	switch (addr)
+	{
+		case 0xFF0F: // IF
+		case 0xFF40: case 0xFF41: // LCDC, STAT
+		case 0xFF44: case 0xFF45: // LY, LYC
+		case 0xFFFF: // IE
+			return 1;
+		default:
+			return 0;
+	}
+}		/* -----  end of function only_changed_by_events  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  check_loop
+ *  Description:  Decodes the loop and works out whether it's idle. Every instruction
+ *                  must be one that can't write memory, each i/o read must be of a
+ *                  register only events change, and every register or flag read must
+ *                  either be written earlier in the same iteration or never be
+ *                  written by the loop, so no iteration depends on the one before
+ *   Parameters:  start is the address the loop branches back to
+ *                end is one past the branch
+ *       Return:  The cycles one iteration takes, 0 if the loop isn't idle
+ * =====================================================================================
+ */
+	static unsigned char
+check_loop (GB *gb, unsigned short start, unsigned short end)
+{
+	unsigned int pc = start;
+	unsigned short written = 0x0;
+	unsigned short read_first = 0x0; // Read before this iteration wrote them
+	unsigned int cycles = 0;
+
+	while (pc < end)
+	{
+		unsigned char opcode = read_memory(gb, (unsigned short) pc);
+		unsigned char operand = read_memory(gb, (unsigned short) (pc + 0x1));
+		unsigned short reads = 0x0;
+		unsigned short writes = 0x0;
+		unsigned int length = 0x1;
+
+		switch (opcode)
+		{
+			case 0x00: // NOP
+				cycles += 0x4;
+				break;
+			case 0xF0: // LDH A,(n)
+				if (!only_changed_by_events((unsigned short) (0xFF00 + operand)))
+				{
+					return 0x0;
+				}
+				writes = USES_A;
+				length = 0x2;
+				cycles += 0xC;
+				break;
+			case 0xFA: // LD A,(nn)
+				if (!only_changed_by_events(combine_bytes(
+				        read_memory(gb, (unsigned short) (pc + 0x2)), operand)))
+				{
+					return 0x0;
+				}
+				writes = USES_A;
+				length = 0x3;
+				cycles += 0x10;
+				break;
+			case 0xE6: case 0xEE: case 0xF6: case 0xFE: // AND, XOR, OR, CP n
+				reads = USES_A;
+				writes = (unsigned short) (USES_FLAGS | (opcode == 0xFE ? 0x0 : USES_A));
+				length = 0x2;
+				cycles += 0x8;
+				break;
+			case 0xA0 ... 0xBF: // AND, XOR, OR, CP r
+				if ((opcode & 0x7u) == 0x6)
+				{
+					return 0x0;
+				}
+				reads = USES_A | register_uses[opcode & 0x7u];
+				writes = (unsigned short) (USES_FLAGS | (opcode >= 0xB8 ? 0x0 : USES_A));
+				cycles += 0x4;
+				break;
+			case 0xCB: // BIT b,r
+				if (operand < 0x40 || operand > 0x7F || (operand & 0x7u) == 0x6)
+				{
+					return 0x0;
+				}
+				reads = register_uses[operand & 0x7u];
+				writes = USES_FLAG_Z | USES_FLAG_N | USES_FLAG_H;
+				length = 0x2;
+				cycles += 0x8;
+				break;
+			case 0x18: case 0x20: case 0x28: case 0x30: case 0x38: // JR
+			{
+				unsigned int target = pc + 0x2 + (unsigned int) (signed char) operand;
+
+				if (opcode != 0x18)
+				{
+					reads = opcode & 0x10u ? USES_FLAG_C : USES_FLAG_Z;
+				}
+				length = 0x2;
+				if (pc + 0x2 == end) // The branch back to the start
+				{
+					if ((unsigned short) target != start)
+					{
+						return 0x0;
+					}
+					cycles += JR_TAKEN_CYCLES;
+				}
+				else if (opcode != 0x18 && (target < start || target >= end))
+				{
+					cycles += 0x8; // A way out, not taken while the loop idles
+				}
+				else
+				{
+					return 0x0;
+				}
+				break;
+			}
+			default:
+				return 0x0;
+		}
+
+		read_first |= (unsigned short) (reads & ~written);
+		written |= writes;
+		pc += length;
+	}
+
+	if (pc != end || (read_first & written))
+	{
+		return 0x0;
+	}
+	return (unsigned char) cycles;
+}		/* -----  end of function check_loop  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  find_loop
+ *  Description:  Looks up a loop, checking it the first time it's seen
+ *   Parameters:  start is the address the loop branches back to
+ *                end is one past the branch
+ *       Return:  The cache entry for the loop, NULL if code there isn't cached
+ * =====================================================================================
+ */
+	static Idle_Loop*
+find_loop (GB *gb, unsigned short start, unsigned short end)
+{
+	unsigned int key;
+	Idle_Loop *loop;
+
+	// Only ROM, loops in RAM could be written over
+	if (start >= 0x8000 || end - start > MAX_LOOP_BYTES || !code_region(gb, start, &key))
+	{
+		return NULL;
+	}
+
+	loop = &gb->idle_loops.loops[(key ^ (key >> 0x10u)) % LOOP_BUCKETS];
+	if (loop->checked && loop->key == key && loop->end == end)
+	{
+		return loop;
+	}
+
+	loop->key = key;
+	loop->end = end;
+	loop->checked = 0x1;
+	loop->iteration_cycles = check_loop(gb, start, end);
+	loop->report = -1;
+	if (loop->iteration_cycles)
+	{
+		// Look for an earlier entry that was pushed out of the cache
+		for (unsigned int i = 0; i < gb->idle_loops.reported_count; i++)
+		{
+			if (gb->idle_loops.reported[i].key == key)
+			{
+				loop->report = (int) i;
+				return loop;
+			}
+		}
+		gb->idle_loop_stats.loops_detected++;
+		if (gb->idle_loops.reported_count < MAX_REPORTED)
+		{
+			gb->idle_loops.reported[gb->idle_loops.reported_count] = (Idle_Loop_Report) {key, loop->iteration_cycles, 0, 0};
+			loop->report = (int) gb->idle_loops.reported_count++;
+		}
+	}
+	return loop;
+}		/* -----  end of function find_loop  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  init_idle_loops
+ *  Description:  Forgets every loop, needed when a new cartridge is loaded
+ * =====================================================================================
+ */
+void init_idle_loops(GB *gb)
+{
+	memset(gb->idle_loops.loops, 0, sizeof(gb->idle_loops.loops));
+	gb->idle_loops.reported_count = 0;
+	gb->idle_loops.confirming_key = 0xFFFFFFFFu;
+	gb->idle_loop_stats = (Idle_Loop_Stats) {0};
+}		/* -----  end of function init_idle_loops  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  is_idle_loop
+ *  Description:  Checks whether the code from start up to a branch back to it is an
+ *                  idle loop, lets the recompiler leave out idle_loop_branch calls
+ *   Parameters:  start is the address the loop branches back to
+ *                end is one past the branch
+ * =====================================================================================
+ */
+int is_idle_loop(GB *gb, unsigned short start, unsigned short end)
+{
+	Idle_Loop *loop = find_loop(gb, start, end);
+
+	return loop != NULL && loop->iteration_cycles;
+}		/* -----  end of function is_idle_loop  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  idle_loop_branch
+ *  Description:  Called by a JR taking a backward branch, before its cycles are added
+ *                  to the clock. When the loop is idle and its last iteration ran
+ *                  without an event, the clock skips every iteration that ends
+ *                  before the next event
+ *   Parameters:  start is the address the loop branches back to
+ *                end is one past the branch
+ * =====================================================================================
+ */
+void idle_loop_branch(GB *gb, unsigned short start, unsigned short end)
+{
+	Idle_Loop *loop = find_loop(gb, start, end);
+	unsigned long next_iteration = gb->clock.cycles + JR_TAKEN_CYCLES;
+	unsigned long until;
+	unsigned long iterations;
+
+	if (loop == NULL || !loop->iteration_cycles)
+	{
+		return;
+	}
+
+	// Events are the only thing that reschedule while an idle loop runs
+	if (loop->key != gb->idle_loops.confirming_key || gb->clock.next_event != gb->idle_loops.confirming_event)
+	{
+		gb->idle_loops.confirming_key = loop->key;
+		gb->idle_loops.confirming_event = gb->clock.next_event;
+		return;
+	}
+
+	until = next_iteration + IDLE_LIMIT;
+	if (gb->clock.next_event < until)
+	{
+		until = gb->clock.next_event;
+	}
+	if (gb->clock.run_until < until)
+	{
+		until = gb->clock.run_until;
+	}
+	if (until <= next_iteration)
+	{
+		return;
+	}
+
+	iterations = (until - 0x1 - next_iteration) / loop->iteration_cycles;
+	gb->clock.cycles += iterations * loop->iteration_cycles;
+	gb->idle_loop_stats.iterations_skipped += iterations;
+	gb->idle_loop_stats.cycles_skipped += iterations * loop->iteration_cycles;
+	if (loop->report >= 0)
+	{
+		gb->idle_loops.reported[loop->report].skips++;
+		gb->idle_loops.reported[loop->report].cycles_skipped += iterations * loop->iteration_cycles;
+	}
+}		/* -----  end of function idle_loop_branch  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  print_idle_loops
+ *  Description:  Lists the idle loops found in the loaded cartridge and the cycles
+ *                  skipped in each
+ * =====================================================================================
+ */
+void print_idle_loops(GB *gb)
+{
+	printf("    idle loops %lu, iterations skipped %lu, cycles skipped %lu\n",
+	       gb->idle_loop_stats.loops_detected, gb->idle_loop_stats.iterations_skipped,
+	       gb->idle_loop_stats.cycles_skipped);
+	for (unsigned int i = 0; i < gb->idle_loops.reported_count; i++)
+	{
+		printf("      %02X:%04X  %3u cycles per iteration, skipped %lu times, %lu cycles\n",
+		       gb->idle_loops.reported[i].key >> 0x10u, gb->idle_loops.reported[i].key & 0xFFFFu,
+		       gb->idle_loops.reported[i].iteration_cycles, gb->idle_loops.reported[i].skips, gb->idle_loops.reported[i].cycles_skipped);
+	}
+}		/* -----  end of function print_idle_loops  ----- */
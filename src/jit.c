@@ -0,0 +1,685 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  jit.c
+ *
+ *    Description:  Dynamic recompiler that translates basic blocks into x86-64 code.
+ *                  A block runs from PC to the first instruction that changes the
+ *                  flow of control. Loads, logical ops, 16-bit INC/DEC, DI/EI, JR
+ *                  and JP are emitted as native code, every other instruction
+ *                  becomes a direct call to its handler from the opcode tables.
+ *                  The machine clock still advances after every instruction so
+ *                  blocks give the same results as the interpreter. Blocks are
+ *                  cached by ROM bank and address. Built when JIT is defined
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 13:20:51
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Matt Gercz (matt.gercz@icloud.com)
+ *
+ * =====================================================================================
+ */
+#ifdef JIT
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "jit.h"
+#include "cpu_emulator.h"
+#include "global_declarations.h"
+#include "idle_loop.h"
+#include "scheduler.h"
+
+#define CODE_BUFFER_SIZE 0x400000 // 4 MiB of executable memory
+#define CODE_PAGE_SIZE 0x1000 // Protection changes cover whole pages
+#define MAX_BLOCK_CODE 0x2000 // Worst case native code for one block
+#define MAX_BLOCK_INSTRUCTIONS 0x40
+#define MAX_BLOCKS 0x4000
+#define HASH_BUCKETS 0x1000
+
+typedef unsigned int (*jit_block_fn)(GB *gb, const unsigned char *exit_requested);
+
+typedef struct JIT_Block
+{
+	unsigned int key; // ROM bank in the upper half, address in the lower
+	unsigned int end; // One past the last byte of the block
+	unsigned int instructions;
+	jit_block_fn code; // NULL when the first instruction can't be translated
+	struct JIT_Block *next; // Next block in the same hash bucket
+	struct JIT_Block *next_ram; // Next block that lives in RAM
+} JIT_Block;
+
+struct JIT_Cache
+{
+	unsigned char *code_buffer;
+	unsigned char *code_end; // Where the next block is translated to
+	JIT_Block blocks[MAX_BLOCKS];
+	unsigned int blocks_used;
+	JIT_Block *buckets[HASH_BUCKETS];
+	JIT_Block *ram_blocks;
+	int compiled_stop_pc;
+
+	// Set by jit_invalidate so the running block leaves after its current instruction
+	unsigned char exit_requested;
+};
+
+// Output of the block being translated, instances may translate on several threads
+static _Thread_local unsigned char *emit_ptr;
+
+// Offsets into the register file, reached through rbx. The registers come first in
+// the instance so rbx also points at the instance handlers are called with
+static const unsigned char reg_offset[0x8] = {
+	offsetof(Registers, B), offsetof(Registers, C), offsetof(Registers, D),
+	offsetof(Registers, E), offsetof(Registers, H), offsetof(Registers, L),
+	0x0, offsetof(Registers, A)
+};
+
+// Offsets of BC, DE, HL, and SP, indexed by bits 4 and 5 of the opcode
+static const unsigned char pair_offset[0x4] = {
+	offsetof(Registers, BC), offsetof(Registers, DE), offsetof(Registers, HL),
+	offsetof(Registers, SP)
+};
+
+	static void
+emit8 (unsigned char byte)
+{
+	*emit_ptr++ = byte;
+}
+
+	static void
+emit16 (unsigned short value)
+{
+	emit8((unsigned char) value);
+	emit8((unsigned char) (value >> 0x8u));
+}
+
+	static void
+emit32 (unsigned int value)
+{
+	emit16((unsigned short) value);
+	emit16((unsigned short) (value >> 0x10u));
+}
+
+	static void
+emit64 (unsigned long value)
+{
+	emit32((unsigned int) value);
+	emit32((unsigned int) (value >> 0x20u));
+}
+
+// call rel32 when fn is in reach of the code buffer, otherwise movabs rax, fn; call rax
+	static void
+emit_call (void *fn)
+{
+	long rel = (long) ((unsigned char *) fn - (emit_ptr + 0x5));
+
+	if (rel == (int) rel)
+	{
+		emit8(0xE8); emit32((unsigned int) rel);
+		return;
+	}
+	emit8(0x48); emit8(0xB8); emit64((unsigned long) fn);
+	emit8(0xFF); emit8(0xD0);
+}
+
+// op al, [rbx + offset] for the mov/and/or/xor forms with a byte register operand
+	static void
+emit_reg_op (unsigned char op, unsigned char offset)
+{
+	emit8(op); emit8(0x43); emit8(offset);
+}
+
+// mov word [rbx + offset], value
+	static void
+emit_set_word (unsigned char offset, unsigned short value)
+{
+	emit8(0x66); emit8(0xC7); emit8(0x43); emit8(offset);
+	emit16(value);
+}
+
+	static void
+emit_set_pc (unsigned short addr)
+{
+	emit_set_word(offsetof(Registers, PC), addr);
+}
+
+// mov rdi, rbx; mov esi, overwritten; call sync_flags, needed before flags are used natively
+	static void
+emit_sync_flags (unsigned char overwritten)
+{
+#ifdef LAZY_FLAGS
+	emit8(0x48); emit8(0x89); emit8(0xDF); // mov rdi, rbx
+	emit8(0xBE); emit32(overwritten); // mov esi, overwritten
+	emit_call((void *) sync_flags);
+#endif
+}
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  emit_update
+ *  Description:  Advances the machine clock the same as cpu_execution does after
+ *                every instruction, only calling run_events once an event is due
+ *   Parameters:  cycles is the constant cycle count, 0 to use the count in r14d
+ * =====================================================================================
+ */
+	static void
+emit_update (unsigned char cycles)
+{
+	unsigned char *skip;
+
+	emit8(0x48); emit8(0x8D); emit8(0x83); emit32(offsetof(GB, clock)); // lea rax, [rbx+clock]
+	if (cycles)
+	{
+		emit8(0x48); emit8(0x81); emit8(0x00); emit32(cycles); // add qword [rax], cycles
+	}
+	else
+	{
+		emit8(0x4C); emit8(0x01); emit8(0x30); // add [rax], r14
+	}
+	emit8(0x48); emit8(0x8B); emit8(0x10); // mov rdx, [rax]
+	emit8(0x48); emit8(0x3B); emit8(0x50); emit8(offsetof(Machine_Clock, next_event));
+	emit8(0x72); // jb over the call, cmp rdx, [rax+next_event] above
+	skip = emit_ptr;
+	emit8(0x0);
+	emit8(0x48); emit8(0x89); emit8(0xDF); // mov rdi, rbx
+	emit_call((void *) run_events);
+	*skip = (unsigned char) (emit_ptr - (skip + 0x1));
+}		/* -----  end of function emit_update  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  emit_exit
+ *  Description:  Leaves the block with PC at the next instruction to execute
+ *   Parameters:  pc is the address execution continues from, -1 if already set
+ *                count is the number of instructions the block has executed
+ * =====================================================================================
+ */
+	static void
+emit_exit (int pc, unsigned int count)
+{
+	if (pc >= 0)
+	{
+		emit_set_pc((unsigned short) pc);
+	}
+	emit8(0xB8); emit32(count); // mov eax, count
+	emit8(0x41); emit8(0x5F); // pop r15
+	emit8(0x41); emit8(0x5E); // pop r14
+	emit8(0x5B); // pop rbx
+	emit8(0xC3); // ret
+}		/* -----  end of function emit_exit  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  emit_branch
+ *  Description:  Emits JR and JP, PC is set to the fall through address and then
+ *                replaced by the target if the condition holds
+ *   Parameters:  flag is the bit of F tested, 0 for an unconditional jump
+ *                when_set is nonzero if the jump is taken when the flag is set
+ *                idle is nonzero if the branch closes an idle loop
+ * =====================================================================================
+ */
+	static void
+emit_branch (unsigned char flag, unsigned char when_set, unsigned short fall_through,
+             unsigned short target, unsigned char not_taken, unsigned char taken,
+             unsigned char idle)
+{
+	unsigned char *skip = NULL;
+
+	if (flag)
+	{
+		emit_sync_flags(0x0);
+		emit8(0x41); emit8(0xBE); emit32(not_taken); // mov r14d, not_taken
+		emit_set_pc(fall_through);
+		emit8(0xF6); emit8(0x43); emit8(offsetof(Registers, F)); emit8(flag); // test [rbx+F], flag
+		emit8((unsigned char) (when_set ? 0x74 : 0x75)); // je/jne over taken
+		skip = emit_ptr;
+		emit8(0x0);
+	}
+	if (idle)
+	{
+		emit8(0x48); emit8(0x89); emit8(0xDF); // mov rdi, rbx
+		emit8(0xBE); emit32(target); // mov esi, target
+		emit8(0xBA); emit32(fall_through); // mov edx, fall_through
+		emit_call((void *) idle_loop_branch);
+	}
+	emit8(0x41); emit8(0xBE); emit32(taken); // mov r14d, taken
+	emit_set_pc(target);
+	if (skip != NULL)
+	{
+		*skip = (unsigned char) (emit_ptr - (skip + 0x1));
+	}
+	emit_update(0x0);
+}		/* -----  end of function emit_branch  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  mark_lines
+ *  Description:  Sets or clears the code line flags covering a block in RAM
+ * =====================================================================================
+ */
+	static void
+mark_lines (GB *gb, const JIT_Block *block, unsigned char value)
+{
+	unsigned int start = block->key & 0xFFFFu;
+
+	for (unsigned int line = start >> 0x4u; line <= (block->end - 1) >> 0x4u; line++)
+	{
+		gb->code_lines[line] = value;
+	}
+}		/* -----  end of function mark_lines  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  compile_block
+ *  Description:  Translates the basic block starting at addr into native code
+ *   Parameters:  key is the cache key of the block
+ *                region_end is one past the last address the block may use
+ *                stop_pc ends the block before the breakpoint, -1 for none
+ *       Return:  The new block, whose code is NULL if nothing could be translated
+ * =====================================================================================
+ */
+	static JIT_Block*
+compile_block (GB *gb, unsigned int key, unsigned int region_end, int stop_pc)
+{
+	unsigned short exit_pcs[MAX_BLOCK_INSTRUCTIONS];
+	unsigned char *exit_jumps[MAX_BLOCK_INSTRUCTIONS];
+	unsigned int exit_counts[MAX_BLOCK_INSTRUCTIONS];
+	unsigned int exits = 0;
+	unsigned int count = 0;
+	unsigned int pc = key & 0xFFFFu;
+	unsigned char *start = emit_ptr;
+	int open = 1; // Cleared once an instruction has set PC itself
+
+	JIT_Block *block = &gb->jit->blocks[gb->jit->blocks_used++];
+	block->key = key;
+	block->code = (jit_block_fn) start;
+
+	// Keep the instance in rbx, r14 holds a handler's cycles
+	emit8(0x53); // push rbx
+	emit8(0x41); emit8(0x56); // push r14
+	emit8(0x41); emit8(0x57); // push r15
+	emit8(0x48); emit8(0x89); emit8(0xFB); // mov rbx, rdi
+	emit8(0x49); emit8(0x89); emit8(0xF7); // mov r15, rsi
+
+	while (open && count < MAX_BLOCK_INSTRUCTIONS && (int) pc != stop_pc)
+	{
+		unsigned char opcode = read_memory(gb, (unsigned short) pc);
+		const Opcode *instruction = &opcode_table[opcode];
+		unsigned short operand = 0;
+		unsigned short next = (unsigned short) (pc + 0x1 + instruction->length);
+		unsigned char src = reg_offset[opcode & 0x7u];
+		unsigned char dst = reg_offset[(opcode >> 0x3u) & 0x7u];
+
+		if (opcode_is_illegal(opcode) || pc + 0x1 + instruction->length > region_end)
+		{
+			break;
+		}
+		if (instruction->length)
+		{
+			operand = read_memory(gb, (unsigned short) (pc + 0x1));
+			if (instruction->length == 0x2)
+			{
+				operand = combine_bytes(read_memory(gb, (unsigned short) (pc + 0x2)),
+				                        (unsigned char) operand);
+			}
+		}
+		count++;
+
+		switch (opcode)
+		{
+			case 0x00: // NOP
+				emit_update(0x4);
+				break;
+			case 0x40 ... 0x75:
+			case 0x77 ... 0x7F: // LD r,r
+				if ((opcode & 0x7u) == 0x6 || (opcode & 0x38u) == 0x30)
+				{
+					goto handler; // Loads to and from memory[HL]
+				}
+				if (src != dst)
+				{
+					emit_reg_op(0x8A, src);
+					emit_reg_op(0x88, dst);
+				}
+				emit_update(0x4);
+				break;
+			case 0x06: case 0x0E: case 0x16: case 0x1E:
+			case 0x26: case 0x2E: case 0x3E: // LD r,n
+				emit8(0xC6); emit8(0x43); emit8(dst); emit8((unsigned char) operand); // mov [rbx+dst], n
+				emit_update(0x8);
+				break;
+			case 0x01: case 0x11: case 0x21: case 0x31: // LD rr,nn
+				emit_set_word(pair_offset[opcode >> 0x4u], operand);
+				emit_update(0xC);
+				break;
+			case 0x03: case 0x13: case 0x23: case 0x33: // INC rr
+			case 0x0B: case 0x1B: case 0x2B: case 0x3B: // DEC rr
+				emit8(0x66); emit8(0xFF); emit8((unsigned char) (opcode & 0x8u ? 0x4B : 0x43));
+				emit8(pair_offset[opcode >> 0x4u]); // inc/dec word [rbx+pair]
+				emit_update(0x8);
+				break;
+			case 0xA0 ... 0xB7:
+			case 0xE6: case 0xEE: case 0xF6: // AND, XOR, OR
+			{
+				unsigned char kind = (unsigned char) ((opcode >> 0x3u) & 0x3u);
+				unsigned char reg_ops[] = {0x22, 0x32, 0x0A}; // and, xor, or al,[rbx+d]
+				unsigned char imm_ops[] = {0x24, 0x34, 0x0C}; // and, xor, or al,imm8
+
+				if (opcode < 0xC0 && (opcode & 0x7u) == 0x6)
+				{
+					goto handler;
+				}
+				emit_sync_flags(FLAG_Z | FLAG_H | FLAG_C);
+				emit_reg_op(0x8A, reg_offset[0x7]);
+				if (opcode < 0xC0)
+				{
+					emit_reg_op(reg_ops[kind], src);
+				}
+				else
+				{
+					emit8(imm_ops[kind]); emit8((unsigned char) operand);
+				}
+				emit_reg_op(0x88, reg_offset[0x7]);
+				// F = Z, plus H for AND
+				emit8(0x84); emit8(0xC0); // test al, al
+				emit8(0x0F); emit8(0x94); emit8(0xC2); // sete dl
+				emit8(0xC0); emit8(0xE2); emit8(0x07); // shl dl, 7
+				if (kind == 0x0)
+				{
+					emit8(0x80); emit8(0xCA); emit8(FLAG_H); // or dl, FLAG_H
+				}
+				emit8(0x88); emit8(0x53); emit8(offsetof(Registers, F)); // mov [rbx+F], dl
+				emit_update((unsigned char) (opcode < 0xC0 ? 0x4 : 0x8));
+				break;
+			}
+			case 0xF3: case 0xFB: // DI, EI
+				emit8(0xC6); emit8(0x43); emit8(offsetof(Registers, IME)); // mov [rbx+IME], n
+				emit8((unsigned char) (opcode == 0xFB));
+				emit_update(0x4);
+				break;
+			case 0x18: case 0x20: case 0x28: case 0x30: case 0x38: // JR
+				emit_branch((unsigned char) (opcode == 0x18 ? 0x0 : (opcode & 0x10u ?
+				            FLAG_C : FLAG_Z)),
+				            (unsigned char) (opcode & 0x8u), next,
+				            (unsigned short) (next + (signed char) operand), 0x8, 0xC,
+				            (unsigned char) ((signed char) operand < 0 &&
+				            is_idle_loop(gb, (unsigned short) (next + (signed char) operand), next)));
+				open = 0;
+				break;
+			case 0xC3: case 0xC2: case 0xCA: case 0xD2: case 0xDA: // JP
+				emit_branch((unsigned char) (opcode == 0xC3 ? 0x0 : (opcode & 0x10u ?
+				            FLAG_C : FLAG_Z)),
+				            (unsigned char) (opcode & 0x8u), next, operand, 0xC, 0x10, 0x0);
+				open = 0;
+				break;
+			default:
+			handler:
+				if (opcode_ends_block(opcode))
+				{
+					emit_set_pc(next); // Calls and RSTs push the address after them
+					open = 0;
+				}
+				emit8(0x48); emit8(0x89); emit8(0xDF); // mov rdi, rbx
+				emit8(0xBE); emit32(operand); // mov esi, operand
+				emit_call((void *) instruction->execute);
+				emit8(0x44); emit8(0x0F); emit8(0xB6); emit8(0xF0); // movzx r14d, al
+				emit_update(0x0);
+				if (open)
+				{
+					// The handler may have written over translated code or switched banks
+					emit8(0x41); emit8(0x80); emit8(0x3F); emit8(0x00); // cmp byte [r15], 0
+					emit8(0x0F); emit8(0x85); // jne exit
+					exit_jumps[exits] = emit_ptr;
+					exit_counts[exits] = count;
+					exit_pcs[exits++] = next;
+					emit32(0x0);
+				}
+				break;
+		}
+		pc = next;
+	}
+
+	if (!count)
+	{
+		emit_ptr = start;
+		block->code = NULL;
+		block->end = (key & 0xFFFFu) + 0x1;
+		block->instructions = 0x0;
+		return block;
+	}
+
+	emit_exit(open ? (int) (unsigned short) pc : -1, count);
+	for (unsigned int i = 0; i < exits; i++)
+	{
+		int rel = (int) (emit_ptr - (exit_jumps[i] + 0x4));
+
+		memcpy(exit_jumps[i], &rel, sizeof(rel));
+		emit_exit(exit_pcs[i], exit_counts[i]);
+	}
+
+	block->end = pc;
+	block->instructions = count;
+	gb->jit_stats.blocks_compiled++;
+	return block;
+}		/* -----  end of function compile_block  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  protect_code
+ *  Description:  Switches the pages a block is translated into between writable and
+ *                executable. They are never both, which systems enforcing W^X need
+ *   Parameters:  start is where the block is translated to
+ *                writable picks read/write over read/execute
+ *       Return:  0 on success, -1 if the protection can't be changed
+ * =====================================================================================
+ */
+	static int
+protect_code(unsigned char *start, int writable)
+{
+	unsigned char *page = (unsigned char *) ((unsigned long) start & ~(CODE_PAGE_SIZE - 0x1ul));
+
+	return mprotect(page, (unsigned long) (start - page) + MAX_BLOCK_CODE,
+	                writable ? PROT_READ | PROT_WRITE : PROT_READ | PROT_EXEC);
+}		/* -----  end of function protect_code  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  jit_flush
+ *  Description:  Drops every translated block, needed when a new cartridge is loaded
+ * =====================================================================================
+ */
+void jit_flush(GB *gb)
+{
+	JIT_Cache *cache = gb->jit;
+
+	memset(gb->code_lines, 0, sizeof(gb->code_lines));
+	if (cache == NULL) // Nothing translated yet
+	{
+		return;
+	}
+	memset(cache->buckets, 0, sizeof(cache->buckets));
+	cache->ram_blocks = NULL;
+	cache->blocks_used = 0;
+	cache->code_end = cache->code_buffer;
+}		/* -----  end of function jit_flush  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  jit_invalidate
+ *  Description:  Called by write_memory for writes to the MBC registers or to RAM
+ *                holding translated code. Stops the running block after the current
+ *                instruction and drops every block in RAM that covers the address
+ *   Parameters:  addr is the address written
+ * =====================================================================================
+ */
+void jit_invalidate(GB *gb, unsigned short addr)
+{
+	JIT_Cache *cache = gb->jit;
+	JIT_Block **link;
+
+	if (cache == NULL)
+	{
+		return;
+	}
+	cache->exit_requested = 0x1;
+	link = &cache->ram_blocks;
+	if (addr < 0x8000) // Bank switch, blocks are keyed by bank so stay valid
+	{
+		return;
+	}
+
+	while (*link != NULL)
+	{
+		JIT_Block *block = *link;
+
+		if (addr >= (block->key & 0xFFFFu) && addr < block->end)
+		{
+			JIT_Block **bucket = &cache->buckets[block->key % HASH_BUCKETS];
+
+			while (*bucket != block)
+			{
+				bucket = &(*bucket)->next;
+			}
+			*bucket = block->next;
+			*link = block->next_ram;
+			mark_lines(gb, block, 0x0);
+			gb->jit_stats.invalidations++;
+		}
+		else
+		{
+			link = &block->next_ram;
+		}
+	}
+
+	// Lines may be shared with blocks that survived
+	for (JIT_Block *block = cache->ram_blocks; block != NULL; block = block->next_ram)
+	{
+		mark_lines(gb, block, 0x1);
+	}
+}		/* -----  end of function jit_invalidate  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  jit_execute
+ *  Description:  Runs the translated block at PC, translating it first if needed
+ *   Parameters:  max_instructions is the most instructions the block may execute
+ *                stop_pc is the breakpoint blocks must end before, -1 for none
+ *       Return:  The number of instructions executed, 0 when the interpreter must
+ *                execute the next instruction instead
+ * =====================================================================================
+ */
+unsigned int jit_execute(GB *gb, unsigned long max_instructions, int stop_pc)
+{
+	JIT_Cache *cache = gb->jit;
+	unsigned int key;
+	unsigned int region_end = code_region(gb, gb->regs.PC, &key);
+	JIT_Block *block;
+
+	if (!region_end)
+	{
+		return 0x0;
+	}
+	if (cache == NULL) // First block this instance runs
+	{
+		// Ask for memory just below our own code so handlers can be called directly
+		void *hint = (void *) (((unsigned long) jit_execute & ~0xFFFFFul) - 0x10000000ul);
+		void *buffer;
+
+		if (gb->jit_unavailable) // Already failed, the interpreter runs everything
+		{
+			return 0x0;
+		}
+		buffer = mmap(hint, CODE_BUFFER_SIZE, PROT_READ | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (buffer == MAP_FAILED)
+		{
+			gb->jit_unavailable = 0x1;
+			return 0x0;
+		}
+		cache = gb->jit = malloc(sizeof(*cache));
+		if (cache == NULL)
+		{
+			munmap(buffer, CODE_BUFFER_SIZE);
+			gb->jit_unavailable = 0x1;
+			return 0x0;
+		}
+		cache->code_buffer = buffer;
+		jit_flush(gb);
+		cache->compiled_stop_pc = stop_pc;
+	}
+	if (stop_pc != cache->compiled_stop_pc) // Blocks were built around another breakpoint
+	{
+		jit_flush(gb);
+		cache->compiled_stop_pc = stop_pc;
+	}
+
+	for (block = cache->buckets[key % HASH_BUCKETS]; block != NULL; block = block->next)
+	{
+		if (block->key == key)
+		{
+			break;
+		}
+	}
+
+	if (block == NULL)
+	{
+		if (cache->blocks_used == MAX_BLOCKS ||
+		    cache->code_end + MAX_BLOCK_CODE > cache->code_buffer + CODE_BUFFER_SIZE)
+		{
+			jit_flush(gb);
+		}
+		if (protect_code(cache->code_end, 0x1))
+		{
+			jit_free(gb);
+			gb->jit_unavailable = 0x1;
+			return 0x0;
+		}
+		emit_ptr = cache->code_end;
+		block = compile_block(gb, key, region_end, stop_pc);
+		if (protect_code(cache->code_end, 0x0))
+		{
+			jit_free(gb);
+			gb->jit_unavailable = 0x1;
+			return 0x0;
+		}
+		cache->code_end = emit_ptr;
+		block->next = cache->buckets[key % HASH_BUCKETS];
+		cache->buckets[key % HASH_BUCKETS] = block;
+		if (block->code != NULL && (key & 0xFFFFu) >= 0x8000)
+		{
+			block->next_ram = cache->ram_blocks;
+			cache->ram_blocks = block;
+			mark_lines(gb, block, 0x1);
+		}
+	}
+
+	if (block->code == NULL || block->instructions > max_instructions)
+	{
+		return 0x0;
+	}
+
+	cache->exit_requested = 0x0;
+	unsigned int executed = block->code(gb, &cache->exit_requested);
+	gb->jit_stats.blocks_executed++;
+	gb->jit_stats.instructions_executed += executed;
+	return executed;
+}		/* -----  end of function jit_execute  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  jit_free
+ *  Description:  Releases the translated code of an instance
+ * =====================================================================================
+ */
+void jit_free(GB *gb)
+{
+	if (gb->jit == NULL)
+	{
+		return;
+	}
+	munmap(gb->jit->code_buffer, CODE_BUFFER_SIZE);
+	free(gb->jit);
+	gb->jit = NULL;
+}		/* -----  end of function jit_free  ----- */
+#endif
@@ -0,0 +1,107 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  joypad.c
+ *
+ *    Description:  Emulates the joypad. The buttons are wired as two rows of four
+ *                  lines, P1 bits 4 and 5 pick the rows that pull the lines in the
+ *                  low nibble to 0 while held. A line falling requests the joypad
+ *                  interrupt, whether from a press or from a row being selected
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026 02:05:31
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Matt Gercz (matt.gercz@icloud.com)
+ *
+ * =====================================================================================
+ */
+
+#include "joypad.h"
+#include "cpu_emulator.h"
+#include "global_declarations.h"
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  joypad_lines
+ *  Description:  Works out the low nibble of P1 for a row selection and the buttons
+ *                  held, 0 bits are pressed
+ * =====================================================================================
+ */
+	static unsigned char
+joypad_lines(unsigned char select, unsigned char buttons)
+{
+	unsigned char pressed = 0x0;
+
+	if (!(select & 0x10u)) // Direction keys
+	{
+		pressed |= buttons & 0xFu;
+	}
+	if (!(select & 0x20u)) // A, B, Select, and Start
+	{
+		pressed |= buttons >> 0x4u;
+	}
+	return (unsigned char) (~pressed & 0xFu);
+}		/* -----  end of function joypad_lines  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  update_joypad
+ *  Description:  Requests the joypad interrupt if any line fell between two
+ *                  readings of the lines
+ * =====================================================================================
+ */
+	static void
+update_joypad(GB *gb, unsigned char before, unsigned char after)
+{
+	if (before & ~after)
+	{
+		request_interrupt(gb, 0x10);
+	}
+}		/* -----  end of function update_joypad  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  read_joypad
+ *  Description:  Returns P1, the unused top bits read back as 1
+ * =====================================================================================
+ */
+	unsigned char
+read_joypad(GB *gb)
+{
+	unsigned char select = (unsigned char) (gb->memory[0xFF00] & 0x30u);
+
+	return (unsigned char) (0xC0u | select | joypad_lines(select, gb->buttons));
+}		/* -----  end of function read_joypad  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  write_joypad
+ *  Description:  Handles a write to P1, only the row selection bits are writable
+ * =====================================================================================
+ */
+	void
+write_joypad(GB *gb, unsigned char data)
+{
+	unsigned char before = joypad_lines(gb->memory[0xFF00], gb->buttons);
+
+	gb->memory[0xFF00] = (unsigned char) (0xC0u | (data & 0x30u) | 0xFu);
+	update_joypad(gb, before, joypad_lines(gb->memory[0xFF00], gb->buttons));
+}		/* -----  end of function write_joypad  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  set_buttons
+ *  Description:  Changes the buttons the host holds down
+ *   Parameters:  buttons is a mask of MATTYGBOY_BUTTON_* values
+ * =====================================================================================
+ */
+	void
+set_buttons(GB *gb, unsigned char buttons)
+{
+	unsigned char before = joypad_lines(gb->memory[0xFF00], gb->buttons);
+
+	gb->buttons = buttons;
+	update_joypad(gb, before, joypad_lines(gb->memory[0xFF00], gb->buttons));
+}		/* -----  end of function set_buttons  ----- */
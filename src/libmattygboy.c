@@ -0,0 +1,454 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  libmattygboy.c
+ *
+ *    Description:  The library interface declared in mattygboy.h, a thin layer over
+ *                  the instance, the cores, and save states
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 21:37:05
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Matt Gercz (matt.gercz@icloud.com)
+ *
+ * =====================================================================================
+ */
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include "mattygboy.h"
+#include "global_declarations.h"
+#include "state.h"
+
+#if MATTYGBOY_SCREEN_WIDTH != SCREEN_WIDTH || MATTYGBOY_SCREEN_HEIGHT != SCREEN_HEIGHT
+#error "The public screen size must match the framebuffer"
+#endif
+
+// The opcode tables are shared by every instance and filled in once
+static pthread_once_t tables_ready = PTHREAD_ONCE_INIT;
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  mattygboy_create
+ *  Description:  Creates an emulator instance running a cartridge
+ *   Parameters:  rom is the cartridge image, copied so the caller may free it
+ *                size is the length of rom in bytes
+ *       Return:  The new instance, NULL if the rom fails the header checks or out
+ *                of memory
+ * =====================================================================================
+ */
+	GB*
+mattygboy_create(const unsigned char *rom, unsigned long size)
+{
+	GB *gb;
+
+	pthread_once(&tables_ready, init_opcode_tables);
+	gb = init_gb();
+	if (gb == NULL)
+	{
+		return NULL;
+	}
+	if (load_cartridge_data(gb, rom, size))
+	{
+		free_gb(gb);
+		return NULL;
+	}
+	init_memory(gb, NULL);
+	return gb;
+}		/* -----  end of function mattygboy_create  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  mattygboy_open
+ *  Description:  Creates an emulator instance running a rom file. The file is
+ *                mapped read only, every instance opening the same file shares one
+ *                copy of the rom
+ *   Parameters:  file is the path of the rom
+ *       Return:  The new instance, NULL if the file can't be read, isn't a rom, or
+ *                out of memory
+ * =====================================================================================
+ */
+	GB*
+mattygboy_open(const char *file)
+{
+	GB *gb;
+
+	pthread_once(&tables_ready, init_opcode_tables);
+	gb = init_gb();
+	if (gb == NULL)
+	{
+		return NULL;
+	}
+	if (load_cartridge(gb, file))
+	{
+		free_gb(gb);
+		return NULL;
+	}
+	init_memory(gb, NULL);
+	return gb;
+}		/* -----  end of function mattygboy_open  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  mattygboy_reset
+ *  Description:  Restarts an instance as if the power was cycled, keeping the
+ *                cartridge and battery RAM. New instances start this way with no
+ *                boot ROM
+ *   Parameters:  boot_rom_file is the path of a 256 byte boot ROM to run first, NULL
+ *                to start at 0x100 as the boot ROM leaves the machine
+ *       Return:  0 on success, -1 if the boot ROM can't be read, then the instance
+ *                is left as it was
+ * =====================================================================================
+ */
+	int
+mattygboy_reset(GB *gb, const char *boot_rom_file)
+{
+	unsigned char boot_rom[sizeof(gb->boot_rom)];
+
+	if (boot_rom_file != NULL)
+	{
+		FILE *file = fopen(boot_rom_file, "rb");
+		unsigned long size = file != NULL ? fread(boot_rom, 0x1, sizeof(boot_rom), file) : 0x0;
+
+		if (file != NULL)
+		{
+			fclose(file);
+		}
+		if (size != sizeof(boot_rom))
+		{
+			return -1;
+		}
+	}
+
+	memset(&gb->memory[0x8000], 0x0, 0xFF00 - 0x8000);
+	if (gb->mbc != NULL)
+	{
+		init_mbc(gb);
+	}
+	init_memory(gb, boot_rom_file != NULL ? boot_rom : NULL);
+	return 0x0;
+}		/* -----  end of function mattygboy_reset  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  mattygboy_destroy
+ *  Description:  Releases an instance made by mattygboy_create, mattygboy_open, or
+ *                mattygboy_fork
+ * =====================================================================================
+ */
+	void
+mattygboy_destroy(GB *gb)
+{
+	free_gb(gb);
+}		/* -----  end of function mattygboy_destroy  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  mattygboy_snapshot
+ *  Description:  Freezes the state of an instance for forking, the instance keeps
+ *                running unaffected. Costs one copy of the instance's state
+ *       Return:  The snapshot, NULL if it can't be made
+ * =====================================================================================
+ */
+	Snapshot*
+mattygboy_snapshot(GB *gb)
+{
+	return take_snapshot(gb);
+}		/* -----  end of function mattygboy_snapshot  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  mattygboy_fork
+ *  Description:  Creates an instance that carries on from a snapshot. Forks share
+ *                memory with the snapshot until they write to it, a page at a time,
+ *                so each one only costs the pages it changes
+ *       Return:  The new instance, free it with mattygboy_destroy, NULL on failure
+ * =====================================================================================
+ */
+	GB*
+mattygboy_fork(Snapshot *snapshot)
+{
+	return fork_snapshot(snapshot);
+}		/* -----  end of function mattygboy_fork  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  mattygboy_free_snapshot
+ *  Description:  Releases a snapshot, forks already made from it carry on
+ * =====================================================================================
+ */
+	void
+mattygboy_free_snapshot(Snapshot *snapshot)
+{
+	free_snapshot(snapshot);
+}		/* -----  end of function mattygboy_free_snapshot  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  mattygboy_run_cycles
+ *  Description:  Runs for a number of clock cycles, or until the breakpoint or
+ *                the cpu locks up, see mattygboy_is_locked_up
+ *       Return:  The number of cycles run
+ * =====================================================================================
+ */
+	unsigned long
+mattygboy_run_cycles(GB *gb, unsigned long cycles)
+{
+	return cpu_run_cycles(gb, cycles, gb->breakpoint);
+}		/* -----  end of function mattygboy_run_cycles  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  mattygboy_run_frame
+ *  Description:  Runs until the next V-Blank starts, when the framebuffer holds a
+ *                finished frame, or until the breakpoint or the cpu locks up
+ *       Return:  The number of cycles run
+ * =====================================================================================
+ */
+	unsigned long
+mattygboy_run_frame(GB *gb)
+{
+	return cpu_run_cycles(gb, mattygboy_cycles_to_frame(gb), gb->breakpoint);
+}		/* -----  end of function mattygboy_run_frame  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  mattygboy_cycles_to_frame
+ *  Description:  Returns how many cycles mattygboy_run_frame would run for if
+ *                nothing stops it early
+ * =====================================================================================
+ */
+	unsigned long
+mattygboy_cycles_to_frame(GB *gb)
+{
+	return next_vblank(gb) - gb->clock.cycles;
+}		/* -----  end of function mattygboy_cycles_to_frame  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  mattygboy_set_breakpoint
+ *  Description:  Makes runs stop when PC reaches an address
+ *   Parameters:  pc is the address to stop at, -1 to run without a breakpoint
+ * =====================================================================================
+ */
+	void
+mattygboy_set_breakpoint(GB *gb, int pc)
+{
+	gb->breakpoint = pc;
+}		/* -----  end of function mattygboy_set_breakpoint  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  mattygboy_at_breakpoint
+ *  Description:  Returns nonzero if the last run stopped at the breakpoint
+ * =====================================================================================
+ */
+	int
+mattygboy_at_breakpoint(GB *gb)
+{
+	return gb->breakpoint >= 0 && gb->regs.PC == gb->breakpoint;
+}		/* -----  end of function mattygboy_at_breakpoint  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  mattygboy_is_stuck
+ *  Description:  Returns nonzero if the cpu is in a loop it can never leave: a jump
+ *                to itself, or a HALT with every interrupt disabled. Test ROMs
+ *                finish in one of these
+ * =====================================================================================
+ */
+	int
+mattygboy_is_stuck(GB *gb)
+{
+	unsigned short pc = gb->regs.PC;
+
+	switch (read_memory(gb, pc))
+	{
+		case 0x18: // JR -2
+			return read_memory(gb, (unsigned short) (pc + 0x1)) == 0xFE;
+		case 0xC3: // JP to its own address
+			return read_memory(gb, (unsigned short) (pc + 0x1)) == (pc & 0xFFu) &&
+			       read_memory(gb, (unsigned short) (pc + 0x2)) == pc >> 0x8u;
+		case 0x76: case 0x10: // HALT, STOP
+			return !(read_memory(gb, 0xFFFF) & 0x1Fu);
+		default:
+			return 0x0;
+	}
+}		/* -----  end of function mattygboy_is_stuck  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  mattygboy_is_locked_up
+ *  Description:  Returns nonzero if the cpu ran an opcode it doesn't have, which
+ *                locks up the hardware. PC is left on the opcode and runs return
+ *                without running anything until the instance is reset or a state
+ *                is loaded
+ * =====================================================================================
+ */
+	int
+mattygboy_is_locked_up(GB *gb)
+{
+	return gb->locked_up;
+}		/* -----  end of function mattygboy_is_locked_up  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  mattygboy_get_cycles
+ *  Description:  Returns the number of clock cycles the instance has run for
+ * =====================================================================================
+ */
+	unsigned long
+mattygboy_get_cycles(GB *gb)
+{
+	return gb->clock.cycles;
+}		/* -----  end of function mattygboy_get_cycles  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  mattygboy_get_instructions
+ *  Description:  Returns the number of instructions run through the library, a
+ *                HALT counts once each time it hands back control
+ * =====================================================================================
+ */
+	unsigned long
+mattygboy_get_instructions(GB *gb)
+{
+	return gb->instructions;
+}		/* -----  end of function mattygboy_get_instructions  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  mattygboy_get_registers
+ *  Description:  Copies out the CPU registers
+ *   Parameters:  values receives them
+ * =====================================================================================
+ */
+	void
+mattygboy_get_registers(GB *gb, Register_Values *values)
+{
+	sync_flags(gb, 0x0);
+	values->AF = gb->regs.AF;
+	values->BC = gb->regs.BC;
+	values->DE = gb->regs.DE;
+	values->HL = gb->regs.HL;
+	values->SP = gb->regs.SP;
+	values->PC = gb->regs.PC;
+	values->IME = gb->regs.IME;
+}		/* -----  end of function mattygboy_get_registers  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  mattygboy_get_framebuffer
+ *  Description:  Returns the instance's framebuffer, MATTYGBOY_SCREEN_WIDTH by
+ *                MATTYGBOY_SCREEN_HEIGHT shades from 0 (lightest) to 3, row by row.
+ *                The pointer stays valid until the instance is destroyed
+ * =====================================================================================
+ */
+	const unsigned char*
+mattygboy_get_framebuffer(GB *gb)
+{
+	return gb->framebuffer;
+}		/* -----  end of function mattygboy_get_framebuffer  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  mattygboy_get_pixel_indices
+ *  Description:  Returns the colour of each framebuffer pixel from 0 to 3 before its
+ *                palette was applied, laid out like the framebuffer. The pointer
+ *                stays valid until the instance is destroyed
+ * =====================================================================================
+ */
+	const unsigned char*
+mattygboy_get_pixel_indices(GB *gb)
+{
+	return gb->pixel_indices;
+}		/* -----  end of function mattygboy_get_pixel_indices  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  mattygboy_frame_unchanged
+ *  Description:  Tells hosts whether the last frame the lcd finished drew exactly what
+ *                the one before it did, so they can skip encoding or hashing it. Lines
+ *                nothing visible was written under are kept rather than drawn again
+ *       Return:  1 if the framebuffer didn't change over the last frame, otherwise 0,
+ *                as it is while the lcd is off
+ * =====================================================================================
+ */
+	int
+mattygboy_frame_unchanged(GB *gb)
+{
+	return gb->line_cache.frame_unchanged;
+}		/* -----  end of function mattygboy_frame_unchanged  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  mattygboy_drain_serial
+ *  Description:  Takes the bytes sent over the serial cable since the last drain,
+ *                oldest first. The instance keeps the last SERIAL_BUFFER_SIZE bytes
+ *                until they are drained
+ *   Parameters:  buffer receives the bytes and size is its length
+ *       Return:  The number of bytes taken, more remain if this equals size
+ * =====================================================================================
+ */
+	unsigned long
+mattygboy_drain_serial(GB *gb, unsigned char *buffer, unsigned long size)
+{
+	return drain_serial(gb, buffer, size);
+}		/* -----  end of function mattygboy_drain_serial  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  mattygboy_set_serial_callback
+ *  Description:  Streams serial output, the callback gets each byte as its transfer
+ *                finishes. Bytes still go to the buffer for draining
+ *   Parameters:  callback is called with context and the byte, NULL to stop
+ * =====================================================================================
+ */
+	void
+mattygboy_set_serial_callback(GB *gb, mattygboy_serial_callback callback, void *context)
+{
+	gb->serial.callback = callback;
+	gb->serial.context = context;
+}		/* -----  end of function mattygboy_set_serial_callback  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  mattygboy_set_buttons
+ *  Description:  Sets the buttons held down until the next call, pressing a button
+ *                in a row the program selected requests the joypad interrupt
+ *   Parameters:  buttons is a mask of MATTYGBOY_BUTTON_* values
+ * =====================================================================================
+ */
+	void
+mattygboy_set_buttons(GB *gb, unsigned char buttons)
+{
+	set_buttons(gb, buttons);
+}		/* -----  end of function mattygboy_set_buttons  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  mattygboy_save_state
+ *  Description:  Saves the state of an instance, see save_state
+ *       Return:  The size of the state, nothing is written if buffer is too small
+ * =====================================================================================
+ */
+	unsigned long
+mattygboy_save_state(GB *gb, unsigned char *buffer, unsigned long size)
+{
+	return save_state(gb, buffer, size);
+}		/* -----  end of function mattygboy_save_state  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  mattygboy_load_state
+ *  Description:  Restores an instance from a saved state, see load_state
+ *       Return:  0 on success, -1 if the state can't be used
+ * =====================================================================================
+ */
+	int
+mattygboy_load_state(GB *gb, const unsigned char *buffer, unsigned long size)
+{
+	return load_state(gb, buffer, size);
+}		/* -----  end of function mattygboy_load_state  ----- */
@@ -15,284 +15,151 @@
  *
  * =====================================================================================
  */
-#include <stdio.h>
 #include "global_declarations.h"
 #include "memory.h"
+#include "load_instructions.h"
 
+// LD between registers and from memory[HL] or an immediate into a register
+#define LD_HANDLERS(dst_name, dst) \
+	static unsigned char ld_##dst_name##_b(GB *gb, unsigned short operand) \
+	{ gb->regs.dst = gb->regs.B; return 0x4; } \
+	static unsigned char ld_##dst_name##_c(GB *gb, unsigned short operand) \
+	{ gb->regs.dst = gb->regs.C; return 0x4; } \
+	static unsigned char ld_##dst_name##_d(GB *gb, unsigned short operand) \
+	{ gb->regs.dst = gb->regs.D; return 0x4; } \
+	static unsigned char ld_##dst_name##_e(GB *gb, unsigned short operand) \
+	{ gb->regs.dst = gb->regs.E; return 0x4; } \
+	static unsigned char ld_##dst_name##_h(GB *gb, unsigned short operand) \
+	{ gb->regs.dst = gb->regs.H; return 0x4; } \
+	static unsigned char ld_##dst_name##_l(GB *gb, unsigned short operand) \
+	{ gb->regs.dst = gb->regs.L; return 0x4; } \
+	static unsigned char ld_##dst_name##_hl_mem(GB *gb, unsigned short operand) \
+	{ gb->regs.dst = read_memory(gb, gb->regs.HL); return 0x8; } \
+	static unsigned char ld_##dst_name##_a(GB *gb, unsigned short operand) \
+	{ gb->regs.dst = gb->regs.A; return 0x4; } \
+	static unsigned char ld_##dst_name##_imm(GB *gb, unsigned short operand) \
+	{ gb->regs.dst = (unsigned char) operand; return 0x8; } \
+	static unsigned char ld_hl_mem_##dst_name(GB *gb, unsigned short operand) \
+	{ write_memory(gb, gb->regs.HL, gb->regs.dst); return 0x8; }
 
-/* 
- * ===  FUNCTION  ======================================================================
- *         Name:  basic_ld
- *  Description:  Handles basic LD instructions for loading data between registers
- *  		      or between registers and memory[HL]
- *       Return:  The number of clock cycles to execute this instruction
- * =====================================================================================
- */
-	unsigned char
-basic_ld (unsigned char opcode)
-{
-	unsigned char cycles = 0;
-
-	unsigned short reg_hl = combine_bytes(regs->H, regs->L);
-	// Pointers to locations to which to load data and the value to load
-	unsigned char load_value;
-	unsigned char *load_to;
-
-	unsigned char left_operand = (unsigned char) ((opcode - 0x40) / 8);
-	unsigned char right_operand = (unsigned char) ((opcode - 0x40) % 8);
-
-	switch (right_operand)
-        {
-			case 0x0:
-				load_value = regs->B;
-				cycles += 0x2;
-				break;
-			case 0x1:
-				load_value = regs->C;
-				cycles += 0x2;
-				break;
-			case 0x2:
-				load_value = regs->D;
-				cycles += 0x2;
-				break;
-			case 0x3:
-				load_value = regs->E;
-				cycles += 0x2;
-				break;
-			case 0x4:
-				load_value = regs->H;
-				cycles += 0x2;
-				break;
-			case 0x5:
-				load_value = regs->L;
-				cycles += 0x2;
-				break;
-			case 0x6:
-				load_value = read_memory(reg_hl);
-				cycles += 0x6;
-				break;
-			case 0x7:
-				load_value = regs->A;
-				cycles += 0x2;
-				break;
-			default:
-				printf("ERROR: Unable to determine value to load\n");
-				load_value = 0x0;
-				cycles += 0x0;
-				break;
-		}
-
-	switch (left_operand)
-	{
-		case 0x0:
-			load_to = &regs->B;
-			cycles += 0x2;
-			break;
-		case 0x1:
-			load_to = &regs->C;
-			cycles += 0x2;
-			break;
-		case 0x2:
-			load_to = &regs->D;
-			cycles += 0x2;
-			break;
-		case 0x3:
-			load_to = &regs->E;
-			cycles += 0x2;
-			break;
-		case 0x4:
-			load_to = &regs->H;
-			cycles += 0x2;
-			break;
-		case 0x5:
-			load_to = &regs->L;
-			cycles += 0x2;
-			break;
-		case 0x6:
-			// Write to memory
-			write_memory(reg_hl, load_value);
-			cycles += 0x6;
-			return cycles;
-		case 0x7:
-			load_to = &regs->A;
-			cycles += 0x2;
-			break;
-		default:
-			load_to = 0x0;
-			printf("ERROR: Unable to determine load location\n");
-			cycles += 0x0;
-			break;
-	}
+#define REGISTER_LD_HANDLERS(table, opcode, imm_opcode, dst_name) \
+	table[(opcode) + 0x0] = (Opcode) {ld_##dst_name##_b, 0x0}; \
+	table[(opcode) + 0x1] = (Opcode) {ld_##dst_name##_c, 0x0}; \
+	table[(opcode) + 0x2] = (Opcode) {ld_##dst_name##_d, 0x0}; \
+	table[(opcode) + 0x3] = (Opcode) {ld_##dst_name##_e, 0x0}; \
+	table[(opcode) + 0x4] = (Opcode) {ld_##dst_name##_h, 0x0}; \
+	table[(opcode) + 0x5] = (Opcode) {ld_##dst_name##_l, 0x0}; \
+	table[(opcode) + 0x6] = (Opcode) {ld_##dst_name##_hl_mem, 0x0}; \
+	table[(opcode) + 0x7] = (Opcode) {ld_##dst_name##_a, 0x0}; \
+	table[(imm_opcode)] = (Opcode) {ld_##dst_name##_imm, 0x1}
 
-	*load_to = load_value;
-	return cycles;
-}		/* -----  end of function basic_ld  ----- */
+LD_HANDLERS(b, B)
+LD_HANDLERS(c, C)
+LD_HANDLERS(d, D)
+LD_HANDLERS(e, E)
+LD_HANDLERS(h, H)
+LD_HANDLERS(l, L)
+LD_HANDLERS(a, A)
 
-/* 
- * ===  FUNCTION  ======================================================================
- *         Name:  load_one_byte_imm
- *  Description:  Handles instructions to load 1-byte immediate value into reg/mem
- *       Return:  The number of clock cycles to execute this instruction
- * =====================================================================================
- */
-	unsigned char
-load_one_byte_imm (unsigned char opcode)
+	static unsigned char
+ld_hl_mem_imm (GB *gb, unsigned short operand)
 {
-    unsigned char cycles;
-
-	// Immediate to load and place to load it to
-	unsigned char imm = read_memory(ptrs->PC);
-	ptrs->PC++;
-	unsigned char *load_to;
-	unsigned short reg_hl = combine_bytes(regs->H, regs->L);
-	int left_operand = opcode / 8;
-
-	switch (left_operand)
-	{
-		case 0x0:
-			load_to = &regs->B;
-			cycles = 0x8;
-			break;
-		case 0x1:
-			load_to = &regs->C;
-			cycles = 0x8;
-			break;
-		case 0x2:
-			load_to = &regs->D;
-			cycles = 0x8;
-			break;
-		case 0x3:
-			load_to = &regs->E;
-			cycles = 0x8;
-			break;
-		case 0x4:
-			load_to = &regs->H;
-			cycles = 0x8;
-			break;
-		case 0x5:
-			load_to = &regs->L;
-			cycles = 0x8;
-			break;
-		case 0x6:
-			// Write to memory
-			write_memory(reg_hl, imm);
-			cycles = 0xC;
-			return cycles;
-		case 0x7:
-			load_to = &regs->A;
-			cycles = 0x8;
-			break;
-		default:
-			load_to = NULL;
-			printf("ERROR: Unable to determine load location\n");
-			cycles = 0x0;
-			break;
-	}
+	// Write to memory
+	write_memory(gb, gb->regs.HL, (unsigned char) operand);
+	return 0xC;
+}
 
-	*load_to = imm;
-	return cycles;
-}		/* -----  end of function load_one_byte_imm  ----- */
+// Loads between A and memory at BC, DE, or a 16-bit immediate address
+	static unsigned char
+ld_a_bc_mem (GB *gb, unsigned short operand)
+{
+	gb->regs.A = read_memory(gb, gb->regs.BC);
+	return 0x8;
+}
 
+	static unsigned char
+ld_a_de_mem (GB *gb, unsigned short operand)
+{
+	gb->regs.A = read_memory(gb, gb->regs.DE);
+	return 0x8;
+}
 
-/* 
- * ===  FUNCTION  ======================================================================
- *         Name:  load_from_to_mem
- *  Description:  Handles instructions to load value from memory at specified address
- *  		  	  into A and vice versa
- *       Return:  The number of clock cycles to execute this instruction
- * =====================================================================================
- */
-	unsigned char
-load_from_to_mem (unsigned char opcode)
+	static unsigned char
+ld_a_imm_mem (GB *gb, unsigned short operand)
 {
-    unsigned char cycles;
+	gb->regs.A = read_memory(gb, operand);
+	return 0x10;
+}
 
-	unsigned char mem_lo = read_memory(ptrs->PC);
-	unsigned char mem_hi = read_memory((unsigned short) (ptrs->PC + 1));
-	unsigned short addr = combine_bytes(mem_hi, mem_lo);
+	static unsigned char
+ld_bc_mem_a (GB *gb, unsigned short operand)
+{
+	write_memory(gb, gb->regs.BC, gb->regs.A);
+	return 0x8;
+}
 
-	switch (opcode)
-	{
-		case 0x0A:
-			addr = combine_bytes(regs->B, regs->C);
-			regs->A = read_memory(addr);
-			cycles = 0x8;
-			return cycles;
-		case 0x1A:
-			addr = combine_bytes(regs->D, regs->E);
-			regs->A = read_memory(addr);
-			cycles = 0x8;
-			return cycles;
-		case 0xFA:
-			ptrs->PC += 0x2;
-			regs->A = read_memory(addr);
-			cycles = 0x10;
-			return cycles;
-		case 0x02:
-			addr = combine_bytes(regs->B, regs->C);
-			write_memory(addr, regs->A);
-			cycles = 0x8;
-			return cycles;
-		case 0x12:
-			addr = combine_bytes(regs->D, regs->E);
-			write_memory(addr, regs->A);
-			cycles = 0x8;
-			return cycles;
-		case 0xEA:
-			ptrs->PC += 0x2;
-			write_memory(addr, regs->A);
-			cycles = 0x10;
-			return cycles;
-		default:
-		    return 0x0;
-	}
-}		/* -----  end of function load_from_to_mem  ----- */
+	static unsigned char
+ld_de_mem_a (GB *gb, unsigned short operand)
+{
+	write_memory(gb, gb->regs.DE, gb->regs.A);
+	return 0x8;
+}
 
+	static unsigned char
+ld_imm_mem_a (GB *gb, unsigned short operand)
+{
+	write_memory(gb, operand, gb->regs.A);
+	return 0x10;
+}
 
 /* 
  * ===  FUNCTION  ======================================================================
  *         Name:  load_hl
  *  Description:  Handles loads between A and HL with inc/dec
+ *   Parameters:  step is added to HL after the load, either 1 or -1
+ *                store is nonzero to write A to memory[HL], zero to read it into A
  *       Return:  The number of clock cycles to execute this instruction
  * =====================================================================================
  */
-	unsigned char
-load_hl (unsigned char opcode)
+	static unsigned char
+load_hl (GB *gb, short step, unsigned char store)
 {
-    unsigned char cycles;
-	unsigned short reg_hl = combine_bytes(regs->H, regs->L);
-
-	switch (opcode)
+	if (store)
+	{
+		write_memory(gb, gb->regs.HL, gb->regs.A);
+	}
+	else
 	{
-		case 0x22:
-			write_memory(reg_hl, regs->A);
-			reg_hl++;
-			split_bytes(reg_hl, &regs->H, &regs->L);
-			cycles = 0x8;
-			return cycles;
-		case 0x2A:
-			regs->A = read_memory(reg_hl);
-			reg_hl++;
-			split_bytes(reg_hl, &regs->H, &regs->L);
-			cycles = 0x8;
-			return cycles;
-		case 0x32:
-			write_memory(reg_hl, regs->A);
-			reg_hl--;
-			split_bytes(reg_hl, &regs->H, &regs->L);
-			cycles = 0x8;
-			return cycles;
-		case 0x3A:
-			regs->A = read_memory(reg_hl);
-			reg_hl--;
-			split_bytes(reg_hl, &regs->H, &regs->L);
-			cycles = 0x8;
-			return cycles;
-        	default:
-        	    return 0x0;
-    }
+		gb->regs.A = read_memory(gb, gb->regs.HL);
+	}
+	gb->regs.HL += step;
+	return 0x8;
 }		/* -----  end of function load_hl  ----- */
 
+	static unsigned char
+ldi_hl_mem_a (GB *gb, unsigned short operand)
+{
+	return load_hl(gb, 1, 0x1);
+}
+
+	static unsigned char
+ldi_a_hl_mem (GB *gb, unsigned short operand)
+{
+	return load_hl(gb, 1, 0x0);
+}
+
+	static unsigned char
+ldd_hl_mem_a (GB *gb, unsigned short operand)
+{
+	return load_hl(gb, -1, 0x1);
+}
+
+	static unsigned char
+ldd_a_hl_mem (GB *gb, unsigned short operand)
+{
+	return load_hl(gb, -1, 0x0);
+}
+
 /*
  * ===  FUNCTION  ======================================================================
  *         Name:  ld_hl_sp
@@ -300,123 +167,143 @@ load_hl (unsigned char opcode)
  *       Return:  The number of clock cycles to execute this instruction
  * =====================================================================================
  */
-    unsigned char
-ld_hl_sp (unsigned char opcode)
+    static unsigned char
+ld_hl_sp (GB *gb, unsigned short operand)
 {
-    unsigned char cycles;
-    char offset;
-
-    switch (opcode)
-    {
-        case 0xF8:
-            offset = read_memory(ptrs->PC); // NOLINT
-            ptrs->PC++;
-            split_bytes(ptrs->SP + offset, &regs->H, &regs->L);
-            cycles = 0xC;
-            return cycles;
-        case 0xF9:
-            ptrs->SP = combine_bytes(regs->H, regs->L);
-            cycles = 0x8;
-            return cycles;
-        default:
-            return 0x0;
-    }
+    char offset = (char) operand; // NOLINT
+
+    gb->regs.HL = (unsigned short) (gb->regs.SP + offset);
+    return 0xC;
 }
 
-/* 
- * ===  FUNCTION  ======================================================================
- *         Name:  sixteen_bit_load
- *  Description:  Handles instructions to load 16-bit values
- *       Return:  The number of clock cycles to execute this instruction
- * =====================================================================================
- */
-	unsigned char
-sixteen_bit_load (unsigned char opcode)
+    static unsigned char
+ld_sp_hl (GB *gb, unsigned short operand)
+{
+    gb->regs.SP = gb->regs.HL;
+    return 0x8;
+}
+
+// Loads of 16-bit immediates into register pairs and from SP into memory
+	static unsigned char
+ld_bc_imm (GB *gb, unsigned short operand)
 {
-    unsigned char cycles;
-	unsigned char imm_lo = read_memory(ptrs->PC);
-	ptrs->PC++;
-	unsigned char imm_hi = read_memory(ptrs->PC);
-	ptrs->PC++;
+	gb->regs.BC = operand;
+	return 0xC;
+}
 
-	unsigned char sp_lo, sp_hi;
+	static unsigned char
+ld_de_imm (GB *gb, unsigned short operand)
+{
+	gb->regs.DE = operand;
+	return 0xC;
+}
 
-	switch (opcode)
-	{
-		case 0x01:
-		    regs->B = imm_hi;
-		    regs->C = imm_lo;
-		    cycles = 0xC;
-			return cycles;
-		case 0x08: // This one is obnoxious
-			sp_lo = (unsigned char) ptrs->SP;
-			sp_hi = (unsigned char) (ptrs->SP >> 0x8u);
-			unsigned short addr = combine_bytes(imm_hi, imm_lo);
-			write_memory(addr, sp_lo);
-			addr++;
-			write_memory(addr, sp_hi);
-			cycles = 0x14;
-			return cycles;
-		case 0x11:
-		    regs->D = imm_hi;
-		    regs->E = imm_lo;
-		    cycles = 0xC;
-			return cycles;
-		case 0x21:
-		    regs->H = imm_hi;
-		    regs->L = imm_lo;
-		    cycles = 0xC;
-			return cycles;
-		case 0x31:
-			ptrs->SP = combine_bytes(imm_hi, imm_lo);
-			cycles = 0xC;
-			return cycles;
-        default:
-            return 0x0;
-    }
-}		/* -----  end of function sixteen_bit_load  ----- */
+	static unsigned char
+ld_hl_imm (GB *gb, unsigned short operand)
+{
+	gb->regs.HL = operand;
+	return 0xC;
+}
 
-/* 
+	static unsigned char
+ld_sp_imm (GB *gb, unsigned short operand)
+{
+	gb->regs.SP = operand;
+	return 0xC;
+}
+
+	static unsigned char
+ld_imm_mem_sp (GB *gb, unsigned short operand)
+{
+	// This one is obnoxious
+	unsigned char sp_lo = (unsigned char) gb->regs.SP;
+	unsigned char sp_hi = (unsigned char) (gb->regs.SP >> 0x8u);
+
+	write_memory(gb, operand, sp_lo);
+	operand++;
+	write_memory(gb, operand, sp_hi);
+	return 0x14;
+}
+
+// Reads and writes of the i/o ports at 0xFF00 plus an offset
+	static unsigned char
+ldh_a_imm (GB *gb, unsigned short operand)
+{
+	gb->regs.A = read_memory(gb, (unsigned short) (operand + 0xFF00));
+	return 0xC;
+}
+
+	static unsigned char
+ldh_imm_a (GB *gb, unsigned short operand)
+{
+	write_memory(gb, (unsigned short) (operand + 0xFF00), gb->regs.A);
+	return 0xC;
+}
+
+	static unsigned char
+ldh_a_c (GB *gb, unsigned short operand)
+{
+	gb->regs.A = read_memory(gb, (unsigned short) (gb->regs.C + 0xFF00));
+	return 0x8;
+}
+
+	static unsigned char
+ldh_c_a (GB *gb, unsigned short operand)
+{
+	write_memory(gb, (unsigned short) (gb->regs.C + 0xFF00), gb->regs.A);
+	return 0x8;
+}
+
+/*
  * ===  FUNCTION  ======================================================================
- *         Name:  read_write_io
- *  Description:  Handles instructions to read/write to/from i/o ports
- *       Return:  The number of clock cycles to execute this instruction
+ *         Name:  register_load_instructions
+ *  Description:  Places the handlers for every load opcode in the opcode table
+ *   Parameters:  table is the 256 entry opcode table to fill in
  * =====================================================================================
  */
-	unsigned char
-read_write_io (unsigned char opcode)
+	void
+register_load_instructions (Opcode *table)
 {
-    unsigned char cycles;
-	unsigned char imm;
-	unsigned short addr;
+	REGISTER_LD_HANDLERS(table, 0x40, 0x06, b);
+	REGISTER_LD_HANDLERS(table, 0x48, 0x0E, c);
+	REGISTER_LD_HANDLERS(table, 0x50, 0x16, d);
+	REGISTER_LD_HANDLERS(table, 0x58, 0x1E, e);
+	REGISTER_LD_HANDLERS(table, 0x60, 0x26, h);
+	REGISTER_LD_HANDLERS(table, 0x68, 0x2E, l);
+	REGISTER_LD_HANDLERS(table, 0x78, 0x3E, a);
+	// 0x76 would be LD (HL),(HL) but is HALT instead
+	table[0x70] = (Opcode) {ld_hl_mem_b, 0x0};
+	table[0x71] = (Opcode) {ld_hl_mem_c, 0x0};
+	table[0x72] = (Opcode) {ld_hl_mem_d, 0x0};
+	table[0x73] = (Opcode) {ld_hl_mem_e, 0x0};
+	table[0x74] = (Opcode) {ld_hl_mem_h, 0x0};
+	table[0x75] = (Opcode) {ld_hl_mem_l, 0x0};
+	table[0x77] = (Opcode) {ld_hl_mem_a, 0x0};
+	table[0x36] = (Opcode) {ld_hl_mem_imm, 0x1};
 
-	switch (opcode)
-	{
-		case 0xF0:
-			imm = read_memory(ptrs->PC);
-			ptrs->PC++;
-			addr = (unsigned short) (imm + 0xFF00);
-			regs->A = read_memory(addr);
-			cycles = 0xC;
-			return cycles;
-	    case 0xE0:
-			imm = read_memory(ptrs->PC);
-			ptrs->PC++;
-            addr = (unsigned short) (imm + 0xFF00);
-			write_memory(addr, regs->A);
-			cycles = 0xC;
-			return cycles;
-		case 0xF2:
-			addr = (unsigned short) (regs->C + 0xFF00);
-			regs->A = read_memory(addr);
-			cycles = 0x8;
-			return cycles;
-		case 0xE2:
-			addr = (unsigned short) (regs->C + 0xFF00);
-			write_memory(addr, regs->A);
-			cycles = 0x8;
-			return cycles;
-        default:
-            return 0x0;
-    }
-}		/* -----  end of function read_write_io  ----- */
+	table[0x0A] = (Opcode) {ld_a_bc_mem, 0x0};
+	table[0x1A] = (Opcode) {ld_a_de_mem, 0x0};
+	table[0xFA] = (Opcode) {ld_a_imm_mem, 0x2};
+	table[0x02] = (Opcode) {ld_bc_mem_a, 0x0};
+	table[0x12] = (Opcode) {ld_de_mem_a, 0x0};
+	table[0xEA] = (Opcode) {ld_imm_mem_a, 0x2};
+
+	table[0x22] = (Opcode) {ldi_hl_mem_a, 0x0};
+	table[0x2A] = (Opcode) {ldi_a_hl_mem, 0x0};
+	table[0x32] = (Opcode) {ldd_hl_mem_a, 0x0};
+	table[0x3A] = (Opcode) {ldd_a_hl_mem, 0x0};
+
+	table[0xF8] = (Opcode) {ld_hl_sp, 0x1};
+	table[0xF9] = (Opcode) {ld_sp_hl, 0x0};
+
+	table[0x01] = (Opcode) {ld_bc_imm, 0x2};
+	table[0x11] = (Opcode) {ld_de_imm, 0x2};
+	table[0x21] = (Opcode) {ld_hl_imm, 0x2};
+	table[0x31] = (Opcode) {ld_sp_imm, 0x2};
+	table[0x08] = (Opcode) {ld_imm_mem_sp, 0x2};
+
+	table[0xF0] = (Opcode) {ldh_a_imm, 0x1};
+	table[0xE0] = (Opcode) {ldh_imm_a, 0x1};
+	table[0xF2] = (Opcode) {ldh_a_c, 0x0};
+	table[0xE2] = (Opcode) {ldh_c_a, 0x0};
+}		/* -----  end of function register_load_instructions  ----- */
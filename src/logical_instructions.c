@@ -15,7 +15,6 @@
  *
  * =====================================================================================
  */
-#include <stdlib.h>
 #include "logical_instructions.h"
 #include "global_declarations.h"
 #include "cpu_emulator.h"
@@ -24,227 +23,55 @@
 /* 
  * ===  FUNCTION  ======================================================================
  *         Name:  and
- *  Description:  Handles opcodes translating to AND instructions
- *       Return:  The number of clock cycles to execute this instruction
+ *  Description:  Emulates AND instructions, left operand is always register A
+ *   Parameters:  operand is the right operand of the AND
  * =====================================================================================
  */
-        unsigned char
-and (unsigned char opcode)
+        static void
+and (GB *gb, unsigned char operand)
 {
-    unsigned char cycles;
-
-    // Right operand is dependant on opcode, left is always register A
-    unsigned char operand = 0;
-    unsigned short reg_hl = combine_bytes(regs->H, regs->L);
-
-    switch (opcode)
-    {
-        case 0xE6:
-            operand = read_memory(ptrs->PC);
-            ptrs->PC++;
-            cycles = 0x8;
-            break;
-        case 0xA0:
-            operand = regs->B;
-            cycles = 0x4;
-            break;
-        case 0xA1:
-            operand = regs->C;
-            cycles = 0x4;
-            break;
-        case 0xA2:
-            operand = regs->D;
-            cycles = 0x4;
-            break;
-        case 0xA3:
-            operand = regs->E;
-            cycles = 0x4;
-            break;
-        case 0xA4:
-            operand = regs->H;
-            cycles = 0x4;
-            break;
-        case 0xA5:
-            operand = regs->L;
-            cycles = 0x4;
-            break;
-        case 0xA6:
-            operand = read_memory(reg_hl);
-            cycles = 0x8;
-            break;
-        case 0xA7:
-            operand = regs->A;
-            cycles = 0x4;
-            break;
-        default:
-            return 0x0;
-    }
-
     // AND instruction clears subtract and carry, but sets half-carry flags
-    flags->H = 0x1; flags->C = 0x0; flags->N = 0x0;
+    sync_flags(gb, FLAG_Z | FLAG_H | FLAG_C);
 
     // Register A & with operand, if yields 0 set zero flag
-    regs->A &= operand;
-    if (!regs->A)
-    {
-        flags->Z = 1;
-    }
-    else
-    {
-        flags->Z = 0;
-    }
-
-    return cycles;
+    gb->regs.A &= operand;
+    gb->regs.F = (unsigned char) ((gb->regs.A ? 0x0 : FLAG_Z) | FLAG_H);
 }               /* -----  end of function and  ----- */
 
 /*
  * ===  FUNCTION  ======================================================================
  *         Name:  or
- *  Description:  Handles opcodes translating to OR instructions
- *       Return:  The number of clock cycles to execute this instruction
+ *  Description:  Emulates OR instructions, left operand is always register A
+ *   Parameters:  operand is the right operand of the OR
  * =====================================================================================
  */
-        unsigned char
-or (unsigned char opcode)
+        static void
+or (GB *gb, unsigned char operand)
 {
-    unsigned char cycles;
-    // Right operand is dependant on opcode, left is always register A
-    unsigned char operand = 0;
-    unsigned short reg_hl = combine_bytes(regs->H, regs->L);
-
-    switch (opcode)
-    {
-        case 0xF6:
-            operand = read_memory(ptrs->PC);
-            ptrs->PC++;
-            cycles = 0x8;
-            break;
-        case 0xB0:
-            operand = regs->B;
-            cycles = 0x4;
-            break;
-        case 0xB1:
-            operand = regs->C;
-            cycles = 0x4;
-            break;
-        case 0xB2:
-            operand = regs->D;
-            cycles = 0x4;
-            break;
-        case 0xB3:
-            operand = regs->E;
-            cycles = 0x4;
-            break;
-        case 0xB4:
-            operand = regs->H;
-            cycles = 0x4;
-            break;
-        case 0xB5:
-            operand = regs->L;
-            cycles = 0x4;
-            break;
-        case 0xB6:
-            operand = read_memory(reg_hl);
-            cycles = 0x8;
-            break;
-        case 0xB7:
-            operand = regs->A;
-            cycles = 0x4;
-            break;
-        default:
-            return 0x0;
-    }
-
     // OR instruction clears half-carry, carry, and subtract flags
-    flags->H = 0; flags->C = 0; flags->N = 0;
+    sync_flags(gb, FLAG_Z | FLAG_H | FLAG_C);
 
     // Register A | with operand, if yields 0 set zero flag
-    regs->A |= operand;
-    if (!regs->A)
-    {
-        flags->Z = 1;
-    }
-    else
-    {
-        flags->Z = 0;
-    }
-
-    return cycles;
+    gb->regs.A |= operand;
+    gb->regs.F = (unsigned char) ((gb->regs.A ? 0x0 : FLAG_Z));
 }               /* -----  end of function or  ----- */
 
 /*
  * ===  FUNCTION  ======================================================================
  *         Name:  xor
- *  Description:  Handles opcodes translating to XOR instructions
- *       Return:  The number of clock cycles to execute this instruction
+ *  Description:  Emulates XOR instructions, left operand is always register A
+ *   Parameters:  operand is the right operand of the XOR
  * =====================================================================================
  */
-        unsigned char
-xor (unsigned char opcode)
+        static void
+xor (GB *gb, unsigned char operand)
 {
-    unsigned char cycles;
-    // Right operand is dependant on opcode, left is always register A
-    unsigned char operand = 0;
-    unsigned short reg_hl = combine_bytes(regs->H, regs->L);
-
-    switch (opcode)
-    {
-        case 0xEE:
-            operand = read_memory(ptrs->PC);
-            ptrs->PC++;
-            cycles = 0x8;
-            break;
-        case 0xA8:
-            operand = regs->B;
-            cycles = 0x4;
-            break;
-        case 0xA9:
-            operand = regs->C;
-            cycles = 0x4;
-            break;
-        case 0xAA:
-            operand = regs->D;
-            cycles = 0x4;
-            break;
-        case 0xAB:
-            operand = regs->E;
-            cycles = 0x4;
-            break;
-        case 0xAC:
-            operand = regs->H;
-            cycles = 0x4;
-            break;
-        case 0xAD:
-            operand = regs->L;
-            cycles = 0x4;
-            break;
-        case 0xAE:
-            operand = read_memory(reg_hl);
-            cycles = 0x8;
-            break;
-        case 0xAF:
-            operand = regs->A;
-            cycles = 0x4;
-            break;
-        default:
-            return 0x0;
-    }
-
     // XOR instruction clears half-carry, carry, and subtract flags
-    flags->H = 0; flags->C = 0; flags->N = 0;
+    sync_flags(gb, FLAG_Z | FLAG_H | FLAG_C);
 
     // Register A ^ with operand, if yields 0 set zero flag
-    regs->A ^= operand;
-    if (!regs->A)
-    {
-        flags->Z = 1;
-    }
-    else
-    {
-        flags->Z = 0;
-    }
-
-    return cycles;
+    gb->regs.A ^= operand;
+    gb->regs.F = (unsigned char) ((gb->regs.A ? 0x0 : FLAG_Z));
 }               /* -----  end of function xor  ----- */
 
 
@@ -255,11 +82,12 @@ xor (unsigned char opcode)
  *       Return:  The number of clock cycles to execute this instruction
  * =====================================================================================
  */
-	unsigned char
-cpl ()
+	static unsigned char
+cpl (GB *gb, unsigned short operand)
 {
-	regs->A ^= 0xFFu; // Just invert the bits to get 1's complement
-	flags->N = 1; flags->H = 1;
+	gb->regs.A ^= 0xFFu; // Just invert the bits to get 1's complement
+	sync_flags(gb, FLAG_H);
+	gb->regs.F |= FLAG_N | FLAG_H;
     return 0x4;
 }		/* -----  end of function cpl  ----- */
 
@@ -275,38 +103,60 @@ cpl ()
  *       Return:  The number of clock cycles to execute this instruction
  * =====================================================================================
  */
-        unsigned char
-daa ()
+        static unsigned char
+daa (GB *gb, unsigned short operand)
 {
 	/* Lots of inspiration for this function's code taken from Eric Haskins at
 	 * https://ehaskins.com/2018-01-30%20Z80%20DAA/ */
 
 	unsigned char correction = 0;
+	sync_flags(gb, 0x0); // Needs the flags of the last add or subtract
 
 	// If half carry set OR if least significant nibble of A > 9
-	if (flags->H || (!flags->N && (regs->A & 0xFu) > 0x9u))
+	if (get_flag(FLAG_H) || (!get_flag(FLAG_N) && (gb->regs.A & 0xFu) > 0x9u))
 	{
 		correction += 0x6;
 	}
 
 	// If carry set OR most significant nibble of A >9
-	if(flags->C || (!flags->N && (regs->A & 0xF0u) > 0x9u))
+	if(get_flag(FLAG_C) || (!get_flag(FLAG_N) && (gb->regs.A & 0xF0u) > 0x9u))
 	{
 		correction += 0x60;
-		flags->C = 1; // Carry flag gets set if correct upper nibble
+		gb->regs.F |= FLAG_C; // Carry flag gets set if correct upper nibble
 	}
 
-	flags->H = 0; // Half-carry flag gets cleared by this op
+	gb->regs.F &= ~FLAG_H; // Half-carry flag gets cleared by this op
 
 	// Correction added/subtracted to/from A based on previous op
-	if (flags->N)
+	if (get_flag(FLAG_N))
 	{
-		regs->A -= correction;
+		gb->regs.A -= correction;
 	}
 	else
 	{
-		regs->A += correction;
+		gb->regs.A += correction;
 	}
 
 	return 0x4;
 }		/* -----  end of function daa  ----- */
+
+EIGHT_BIT_OPERAND_HANDLERS(and_a, and)
+EIGHT_BIT_OPERAND_HANDLERS(or_a, or)
+EIGHT_BIT_OPERAND_HANDLERS(xor_a, xor)
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  register_logical_instructions
+ *  Description:  Places the handlers for every logical opcode in the opcode table
+ *   Parameters:  table is the 256 entry opcode table to fill in
+ * =====================================================================================
+ */
+	void
+register_logical_instructions (Opcode *table)
+{
+	REGISTER_EIGHT_BIT_OPERAND_HANDLERS(table, 0xA0, 0xE6, and_a);
+	REGISTER_EIGHT_BIT_OPERAND_HANDLERS(table, 0xB0, 0xF6, or_a);
+	REGISTER_EIGHT_BIT_OPERAND_HANDLERS(table, 0xA8, 0xEE, xor_a);
+	table[0x27] = (Opcode) {daa, 0x0};
+	table[0x2F] = (Opcode) {cpl, 0x0};
+}		/* -----  end of function register_logical_instructions  ----- */
@@ -17,587 +17,284 @@
  */
 #include "global_declarations.h"
 #include "cpu_emulator.h"
+#include "math_instructions.h"
 #include "helper_functions.h"
 
 /* 
  * ===  FUNCTION  ======================================================================
  *         Name:  eight_bit_add
- *  Description:  Handles opcodes translating to 8-bit ADD instructions
- *       Return:  The number of clock cycles used for this opcode
+ *  Description:  Emulates 8-bit ADD instructions, A is always the left operand
+ *   Parameters:  value is the value to be added to A
  * =====================================================================================
  */
-	unsigned char
-eight_bit_add (unsigned char opcode)
+	static void
+eight_bit_add (GB *gb, unsigned char value)
 {
-	unsigned char cycles = 0;
-
 	// Clear the N flag
-	flags->N = 0;
-
-	// Hold the value to be added to A
-	unsigned char value;
-
-	unsigned short reg_hl = combine_bytes(regs->H, regs->L);
-
-	switch (opcode)
-	{
-		case 0xC6:
-			value = read_memory(ptrs->PC);
-			ptrs->PC++;
-            cycles = 0x8;
-			break;
-		/* Oddball case. SP updated instead of A, so do all needed
-		 * actions and return. Value is also signed, so check and set
-		 * N flag if negative
-		 */
-		case 0xE8:
-		    value = read_memory(ptrs->PC);
-			flags->N = 0;
-			// SP requires a 16-bit update
-			sixteen_bit_update_flags(ptrs->SP, (char)value);
-			flags->Z = 0;
-			ptrs->SP += (char)value;
-			ptrs->PC++;
-            cycles = 0x10;
-			return cycles;
-		// 8-bit register cases
-		case 0x80:
-			value = regs->B;
-			cycles = 0x4;
-			break;
-		case 0x81:
-			value = regs->C;
-            cycles = 0x4;
-			break;
-		case 0x82:
-			value = regs->D;
-            cycles = 0x4;
-			break;
-		case 0x83:
-			value = regs->E;
-            cycles = 0x4;
-			break;
-		case 0x84:
-			value = regs->H;
-            cycles = 0x4;
-			break;
-		case 0x85:
-			value = regs->L;
-            cycles = 0x4;
-			break;
-		case 0x87:
-			value = regs->A;
-            cycles = 0x4;
-			break;
-		case 0x86:
-			value = read_memory(reg_hl);
-            cycles = 0x8;
-			break;
-		default:
-		    value = 0; // Error case
-			break;
-	}
-	
-	eight_bit_update_flags(regs->A, value);
-	regs->A += value;
-	return cycles;
+	set_flag(FLAG_N, 0);
+
+	eight_bit_update_flags(gb, gb->regs.A, value, FLAG_Z | FLAG_H | FLAG_C);
+	gb->regs.A += value;
 }		/* -----  end of function add  ----- */
 
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  add_sp
+ *  Description:  Handles the oddball ADD SP instruction. SP updated instead of A and
+ *                the immediate is signed
+ *       Return:  The number of clock cycles used for this opcode
+ * =====================================================================================
+ */
+	static unsigned char
+add_sp (GB *gb, unsigned short operand)
+{
+	char value = (char) operand; // NOLINT
+
+	set_flag(FLAG_N, 0);
+	// SP requires a 16-bit update, Z is always cleared
+	sixteen_bit_update_flags(gb, gb->regs.SP, value, FLAG_H | FLAG_C);
+	set_flag(FLAG_Z, 0);
+	gb->regs.SP += value;
+	return 0x10;
+}		/* -----  end of function add_sp  ----- */
+
 /* 
  * ===  FUNCTION  ======================================================================
  *         Name:  sixteen_bit_add
- *  Description:  Handles opcodes translating to 16-bit ADD instructions
- *       Return:  The number of clock cycles used for this opcode
+ *  Description:  Emulates 16-bit ADD instructions, HL is always the left operand
+ *   Parameters:  value is the value to be added to HL
  * =====================================================================================
  */
-        unsigned char
-sixteen_bit_add (unsigned char opcode)
+        static void
+sixteen_bit_add (GB *gb, unsigned short value)
 {
 	// Clear N
-	flags->N = 0;
-	// Preserve Z
-	unsigned char initial_z = flags->Z;
-	// Left operand always HL
-	unsigned short reg_hl = combine_bytes(regs->H, regs->L);
-	unsigned short value;
-	unsigned char cycles = 0;
-
-	switch (opcode)
-	{
-		case 0x09:
-			value = combine_bytes(regs->B, regs->C);
-			cycles = 0x8;
-			break;
-		case 0x19:
-			value = combine_bytes(regs->D, regs->E);
-			cycles = 0x8;
-			break;
-		case 0x29:
-			value = reg_hl;
-			cycles = 0x8;
-			break;
-		case 0x39:
-			value = ptrs->SP;
-			cycles = 0x8;
-			break;
-		default:
-			value = 0;
-			break;
-	}
-
-	sixteen_bit_update_flags(reg_hl, value);
-	flags->Z = initial_z;
-	split_bytes((reg_hl + value), &(regs->H), &(regs->L));
-	return cycles;
+	set_flag(FLAG_N, 0);
+
+	// Z is preserved
+	sixteen_bit_update_flags(gb, gb->regs.HL, value, FLAG_H | FLAG_C);
+	gb->regs.HL += value;
 }		/* -----  end of function sixteen_bit_add  ----- */
 	
 
 /*
  * ===  FUNCTION  ======================================================================
  *         Name:  adc
- *  Description:  Handles opcodes translating to ADC instructions
- *       Return:  The number of clock cycles used for this opcode
+ *  Description:  Emulates ADC instructions, A is always the left operand
+ *   Parameters:  value is the value to be added to A along with the carry flag
  * =====================================================================================
  */
-        unsigned char
-adc (unsigned char opcode)
+        static void
+adc (GB *gb, unsigned char value)
 {
     // Clear the N flag
-    flags->N = 0;
+    set_flag(FLAG_N, 0);
 
-    unsigned char cycles = 0;
 	unsigned char sum = 0; // Total the operand and the carry flag
-    sum += flags->C;
-	unsigned short reg_hl = combine_bytes(regs->H, regs->L);
-
-	// All operations update A, so just need to get sum
-        switch (opcode)
-        {
-		case 0xCE:
-			sum += read_memory(ptrs->PC);
-			ptrs->PC++;
-			cycles = 0x8;
-			break;
-		case 0x8E:
-			sum += read_memory(reg_hl);
-			cycles = 0x8;
-			break;
-		case 0x8F:
-			sum += regs->A;
-			cycles = 0x4;
-			break;
-		case 0x88:
-			sum += regs->B;
-			cycles = 0x4;
-			break;
-		case 0x89:
-			sum += regs->C;
-			cycles = 0x4;
-			break;
-		case 0x8A:
-			sum += regs->D;
-			cycles = 0x4;
-			break;
-		case 0x8B:
-			sum += regs->E;
-			cycles = 0x4;
-			break;
-		case 0x8C:
-			sum += regs->H;
-			cycles = 0x4;
-			break;
-		case 0x8D:
-			sum += regs->L;
-			cycles = 0x4;
-			break;
-		default:
-			break;
-		}
+	sync_flags(gb, 0x0);
+    sum += get_flag(FLAG_C);
+	sum += value;
 
 	// Update A and the flags
-	eight_bit_update_flags(regs->A, sum);
-	regs->A += sum;
-	return cycles;
+	eight_bit_update_flags(gb, gb->regs.A, sum, FLAG_Z | FLAG_H | FLAG_C);
+	gb->regs.A += sum;
 }               /* -----  end of function adc  ----- */
 
 
 /* 
  * ===  FUNCTION  ======================================================================
  *         Name:  sub
- *  Description:  Handles opcodes translating to SUB instructions
- *       Return:  The number of clock cycles used for this opcode
+ *  Description:  Emulates SUB instructions, the minuend is always register A
+ *   Parameters:  subtrahend is the value to be subtracted from A
  * =====================================================================================
  */
-	unsigned char
-sub (unsigned char opcode)
+	static void
+sub (GB *gb, unsigned char subtrahend)
 {
 	// Set the N flag
-	flags->N = 1;
+	set_flag(FLAG_N, 1);
 
-	// Minuend is always register A
-	unsigned char subtrahend;
-	unsigned short reg_hl = combine_bytes(regs->H, regs->L);
-	
-	unsigned char cycles = 0;
-	
-	switch (opcode)
-	{
-		case 0xD6:
-			subtrahend = read_memory(ptrs->PC);
-            ptrs->PC++;
-            cycles = 0x8;
-			break;
-		case 0x90:
-			subtrahend = regs->B;
-			cycles = 0x4;
-			break;
-		case 0x91:
-			subtrahend = regs->C;
-			cycles = 0x4;
-			break;
-		case 0x92:
-			subtrahend = regs->D;
-			cycles = 0x4;
-			break;
-		case 0x93:
-			subtrahend = regs->E;
-			cycles = 0x4;
-			break;
-		case 0x94:
-			subtrahend = regs->H;
-			cycles = 0x4;
-			break;
-		case 0x95:
-			subtrahend = regs->L;
-			cycles = 0x4;
-			break;
-		case 0x96:
-			subtrahend = read_memory(reg_hl);
-			cycles = 0x8;
-			break;
-		case 0x97:
-			subtrahend = regs->A;
-			cycles = 0x4;
-			break;
-		default:
-			subtrahend = 0;
-			break;
-	}
-	
 	// Update A and the flags
-	eight_bit_update_flags(regs->A, subtrahend);
-	regs->A -= subtrahend;
-	return cycles;
+	eight_bit_update_flags(gb, gb->regs.A, subtrahend, FLAG_Z | FLAG_H | FLAG_C);
+	gb->regs.A -= subtrahend;
 }		/* -----  end of function sub  ----- */
 
 
 /* 
  * ===  FUNCTION  ======================================================================
  *         Name:  sbc
- *  Description:  Handles opcodes translating to SBC instructions
- *       Return:  The number of clock cycles used for this opcode
+ *  Description:  Emulates SBC instructions, the minuend is always register A
+ *   Parameters:  value is the value to be subtracted from A along with the carry flag
  * =====================================================================================
  */
-	unsigned char
-sbc (unsigned char opcode)
+	static void
+sbc (GB *gb, unsigned char value)
 {
 	// Set the N flag
-    flags->N = 1;
+    set_flag(FLAG_N, 1);
 
     unsigned char subtrahend = 0; // Total the operand and the carry flag
-    subtrahend += flags->C;
-    unsigned short reg_hl = combine_bytes(regs->H, regs->L);
-    unsigned char cycles = 0;
-
-    // All operations update A, so just need to get sum
-    switch (opcode)
-    {
-        case 0xDE:
-            subtrahend += read_memory(ptrs->PC);
-            ptrs->PC++;
-            cycles = 0x8;
-            break;
-        case 0x9E:
-            subtrahend += read_memory(reg_hl);
-			cycles = 0x8;
-            break;
-        case 0x9F:
-            subtrahend += regs->A;
-			cycles = 0x4;
-            break;
-        case 0x98:
-            subtrahend += regs->B;
-			cycles = 0x4;
-            break;
-        case 0x99:
-            subtrahend += regs->C;
-			cycles = 0x4;
-            break;
-        case 0x9A:
-            subtrahend += regs->D;
-			cycles = 0x4;
-            break;
-        case 0x9B:
-            subtrahend += regs->E;
-			cycles = 0x4;
-            break;
-        case 0x9C:
-            subtrahend += regs->H;
-			cycles = 0x4;
-            break;
-        case 0x9D:
-            subtrahend += regs->L;
-			cycles = 0x4;
-            break;
-        default:
-            break;
-    }
+    sync_flags(gb, 0x0);
+    subtrahend += get_flag(FLAG_C);
+    subtrahend += value;
 
     // Update A and the flags
-    eight_bit_update_flags(regs->A, subtrahend);
-    regs->A -= subtrahend;
-    return cycles;
+    eight_bit_update_flags(gb, gb->regs.A, subtrahend, FLAG_Z | FLAG_H | FLAG_C);
+    gb->regs.A -= subtrahend;
 }		/* -----  end of function sbc  ----- */
 
 
 /* 
  * ===  FUNCTION  ======================================================================
  *         Name:  eight_bit_inc
- *  Description:  Handles opcodes translating to an 8-bit INC instruction
- *       Return:  The number of clock cycles to execute this instruction
+ *  Description:  Emulates an 8-bit INC instruction
+ *   Parameters:  initial_state is the value of the register/memory being incremented
+ *       Return:  The incremented value
  * =====================================================================================
  */
-	unsigned char
-eight_bit_inc (unsigned char opcode)
+	static unsigned char
+eight_bit_inc (GB *gb, unsigned char initial_state)
 {
-	unsigned char cycles;
 	// Clear N flag
-	flags->N = 0;
-
-	// Capture state of C flag so it can be preserved
-	unsigned char c_flag = flags->C;
-
-	unsigned char initial_state; // Capture initial state for flag updates
-	unsigned short reg_hl = combine_bytes(regs->H, regs->L);
-	switch (opcode)
-	{
-		case 0x34:
-			initial_state = read_memory(reg_hl);
-			write_memory(reg_hl, (unsigned char) (initial_state + 1));
-			cycles = 0xC;
-			break;
-		case 0x3C:
-			initial_state = regs->A;
-			cycles = 0x4;
-			regs->A++;
-			break;
-		case 0x04:
-			initial_state = regs->B;
-			cycles = 0x4;
-			regs->B++;
-			break;
-		case 0x0C:
-			initial_state = regs->C;
-			cycles = 0x4;
-			regs->C++;
-			break;
-		case 0x14:
-			initial_state = regs->D;
-			cycles = 0x4;
-			regs->D++;
-			break;
-		case 0x1C:
-			initial_state = regs->E;
-			cycles = 0x4;
-			regs->E++;
-			break;
-		case 0x24:
-			initial_state = regs->H;
-			cycles = 0x4;
-			regs->H++;
-			break;
-		case 0x2C:
-			initial_state = regs->L;
-			cycles = 0x4;
-			regs->L++;
-			break;
-		default:
-			initial_state = 0;
-			cycles = 0x0;
-			break;
-	}
-
-	eight_bit_update_flags(initial_state, 1);
-
-	// Restore C flag, this instruction doesn't set or clear it
-	flags->C = c_flag;
-	return cycles;
+	set_flag(FLAG_N, 0);
+
+	// C flag is preserved, this instruction doesn't set or clear it
+	eight_bit_update_flags(gb, initial_state, 1, FLAG_Z | FLAG_H);
+	return (unsigned char) (initial_state + 1);
 }		/* -----  end of function eight_bit_inc  ----- */
 
 
 /* 
  * ===  FUNCTION  ======================================================================
- *         Name:  sixteen_bit_inc
- *  Description:  Handles opcodes translating to 16-bit INC instructions
- *  		      This instruction does not affect flags
- *       Return:  The number of clock cycles to execute this instruction
+ *         Name:  eight_bit_dec
+ *  Description:  Emulates an 8-bit DEC instruction
+ *   Parameters:  initial_state is the value of the register/memory being decremented
+ *       Return:  The decremented value
  * =====================================================================================
  */
-	unsigned char
-sixteen_bit_inc (unsigned char opcode)
+	static unsigned char
+eight_bit_dec (GB *gb, unsigned char initial_state)
 {
-    unsigned char cycles;
-	unsigned short value;
-	switch (opcode)
-	{
-		case 0x03:
-			value = combine_bytes(regs->B, regs->C);
-			value++;
-			split_bytes(value, &regs->B, &regs->C);
-			cycles = 0x8;
-			break;
-		case 0x13:
-			value = combine_bytes(regs->D, regs->E);
-			value++;
-			split_bytes(value, &regs->D, &regs->E);
-			cycles = 0x8;
-			break;
-		case 0x23:
-			value = combine_bytes(regs->H, regs->L);
-			value++;
-			split_bytes(value, &regs->H, &regs->L);
-			cycles = 0x8;
-			break;
-		case 0x33:
-			ptrs->SP++;
-			cycles = 0x8;
-			break;
-		default:
-		    cycles = 0x0;
-			break;
-	}
-
-	return cycles;
-}		/* -----  end of function sixteen_bit_inc  ----- */
+    // Set N flag
+    set_flag(FLAG_N, 1);
 
+    // C flag is preserved, this instruction doesn't set or clear it
+    eight_bit_update_flags(gb, initial_state, 1, FLAG_Z | FLAG_H);
+    return (unsigned char) (initial_state - 1);
+}		/* -----  end of function eight_bit_dec  ----- */
 
-/* 
- * ===  FUNCTION  ======================================================================
- *         Name:  eight_bit_dec
- *  Description:  Handles opcodes translating to 8-bit DEC instructions
- *       Return:  The number of clock cycles to execute this instruction
- * =====================================================================================
- */
-	unsigned char
-eight_bit_dec (unsigned char opcode)
+// One handler per opcode, each family above shares its operand decoding
+EIGHT_BIT_OPERAND_HANDLERS(add_a, eight_bit_add)
+EIGHT_BIT_OPERAND_HANDLERS(adc_a, adc)
+EIGHT_BIT_OPERAND_HANDLERS(sub_a, sub)
+EIGHT_BIT_OPERAND_HANDLERS(sbc_a, sbc)
+
+// 8-bit INC and DEC of a register
+#define INC_DEC_HANDLERS(reg_name, reg) \
+	static unsigned char inc_##reg_name(GB *gb, unsigned short operand) \
+	{ gb->regs.reg = eight_bit_inc(gb, gb->regs.reg); return 0x4; } \
+	static unsigned char dec_##reg_name(GB *gb, unsigned short operand) \
+	{ gb->regs.reg = eight_bit_dec(gb, gb->regs.reg); return 0x4; }
+
+INC_DEC_HANDLERS(b, B)
+INC_DEC_HANDLERS(c, C)
+INC_DEC_HANDLERS(d, D)
+INC_DEC_HANDLERS(e, E)
+INC_DEC_HANDLERS(h, H)
+INC_DEC_HANDLERS(l, L)
+INC_DEC_HANDLERS(a, A)
+
+	static unsigned char
+inc_hl_mem (GB *gb, unsigned short operand)
 {
-    unsigned char cycles;
+	write_memory(gb, gb->regs.HL, eight_bit_inc(gb, read_memory(gb, gb->regs.HL)));
+	return 0xC;
+}
 
-    // Set N flag
-    flags->N = 1;
-
-    // Capture state of C flag so it can be preserved
-    unsigned char c_flag = flags->C;
-
-    unsigned char initial_state; // Capture initial state for flag updates
-    unsigned short reg_hl = combine_bytes(regs->H, regs->L);
-    switch (opcode)
-    {
-        case 0x35:
-            initial_state = read_memory(reg_hl);
-            write_memory(reg_hl, (unsigned char) (initial_state - 1));
-			cycles = 0xC;
-            break;
-        case 0x3D:
-            initial_state = regs->A;
-            regs->A--;
-			cycles = 0x4;
-            break;
-        case 0x05:
-            initial_state = regs->B;
-            regs->B--;
-			cycles = 0x4;
-            break;
-        case 0x0D:
-            initial_state = regs->C;
-            regs->C--;
-			cycles = 0x4;
-            break;
-        case 0x15:
-            initial_state = regs->D;
-            regs->D--;
-			cycles = 0x4;
-            break;
-        case 0x1D:
-            initial_state = regs->E;
-            regs->E--;
-			cycles = 0x4;
-            break;
-        case 0x25:
-            initial_state = regs->H;
-            regs->H--;
-			cycles = 0x4;
-            break;
-        case 0x2D:
-            initial_state = regs->L;
-            regs->L--;
-			cycles = 0x4;
-            break;
-        default:
-            initial_state = 0x0;
-            cycles = 0x0;
-            break;
-    }
-
-    eight_bit_update_flags(initial_state, 1);
-
-    // Restore C flag, this instruction doesn't set or clear it
-    flags->C = c_flag;
-    return cycles;
-}		/* -----  end of function eight_bit_dec  ----- */
+	static unsigned char
+dec_hl_mem (GB *gb, unsigned short operand)
+{
+	write_memory(gb, gb->regs.HL, eight_bit_dec(gb, read_memory(gb, gb->regs.HL)));
+	return 0xC;
+}
+
+// 16-bit INC, DEC, and ADD HL of a register pair, these don't affect flags except ADD
+#define SIXTEEN_BIT_HANDLERS(pair_name, pair) \
+	static unsigned char inc_##pair_name(GB *gb, unsigned short operand) \
+	{ gb->regs.pair++; return 0x8; } \
+	static unsigned char dec_##pair_name(GB *gb, unsigned short operand) \
+	{ gb->regs.pair--; return 0x8; } \
+	static unsigned char add_hl_##pair_name(GB *gb, unsigned short operand) \
+	{ sixteen_bit_add(gb, gb->regs.pair); return 0x8; }
+
+SIXTEEN_BIT_HANDLERS(bc, BC)
+SIXTEEN_BIT_HANDLERS(de, DE)
+SIXTEEN_BIT_HANDLERS(hl, HL)
+
+	static unsigned char
+inc_sp (GB *gb, unsigned short operand)
+{
+	gb->regs.SP++;
+	return 0x8;
+}
 
+	static unsigned char
+dec_sp (GB *gb, unsigned short operand)
+{
+	gb->regs.SP--;
+	return 0x8;
+}
 
-/* 
+	static unsigned char
+add_hl_sp (GB *gb, unsigned short operand)
+{
+	sixteen_bit_add(gb, gb->regs.SP);
+	return 0x8;
+}
+
+/*
  * ===  FUNCTION  ======================================================================
- *         Name:  sixteen_bit_dec
- *  Description:  Handles opcodes translating to 16-bit DEC instructions
- *  		      This instruction does not affect flags
- *       Return:  The number of clock cycles to execute this instruction
+ *         Name:  register_math_instructions
+ *  Description:  Places the handlers for every arithmetic opcode in the opcode table
+ *   Parameters:  table is the 256 entry opcode table to fill in
  * =====================================================================================
  */
-	unsigned char
-sixteen_bit_dec (unsigned char opcode)
+	void
+register_math_instructions (Opcode *table)
 {
-    unsigned char cycles;
-	unsigned short value;
-        switch (opcode)
-        {
-			case 0x0B:
-				value = combine_bytes(regs->B, regs->C);
-				value--;
-				split_bytes(value, &regs->B, &regs->C);
-				cycles = 0x8;
-				break;
-			case 0x1B:
-				value = combine_bytes(regs->D, regs->E);
-				value--;
-				split_bytes(value, &regs->D, &regs->E);
-				cycles = 0x8;
-				break;
-			case 0x2B:
-				value = combine_bytes(regs->L, regs->L);
-				value--;
-				split_bytes(value, &regs->H, &regs->L);
-				cycles = 0x8;
-				break;
-			case 0x3B:
-				ptrs->SP--;
-				cycles = 0x8;
-				break;
-			default:
-			    cycles = 0x0;
-				break;
-		}
-
-		return cycles;
-}		/* -----  end of function sixteen_bit_dec  ----- */
+	REGISTER_EIGHT_BIT_OPERAND_HANDLERS(table, 0x80, 0xC6, add_a);
+	REGISTER_EIGHT_BIT_OPERAND_HANDLERS(table, 0x88, 0xCE, adc_a);
+	REGISTER_EIGHT_BIT_OPERAND_HANDLERS(table, 0x90, 0xD6, sub_a);
+	REGISTER_EIGHT_BIT_OPERAND_HANDLERS(table, 0x98, 0xDE, sbc_a);
+	table[0xE8] = (Opcode) {add_sp, 0x1};
+
+	table[0x04] = (Opcode) {inc_b, 0x0};
+	table[0x0C] = (Opcode) {inc_c, 0x0};
+	table[0x14] = (Opcode) {inc_d, 0x0};
+	table[0x1C] = (Opcode) {inc_e, 0x0};
+	table[0x24] = (Opcode) {inc_h, 0x0};
+	table[0x2C] = (Opcode) {inc_l, 0x0};
+	table[0x34] = (Opcode) {inc_hl_mem, 0x0};
+	table[0x3C] = (Opcode) {inc_a, 0x0};
+	table[0x05] = (Opcode) {dec_b, 0x0};
+	table[0x0D] = (Opcode) {dec_c, 0x0};
+	table[0x15] = (Opcode) {dec_d, 0x0};
+	table[0x1D] = (Opcode) {dec_e, 0x0};
+	table[0x25] = (Opcode) {dec_h, 0x0};
+	table[0x2D] = (Opcode) {dec_l, 0x0};
+	table[0x35] = (Opcode) {dec_hl_mem, 0x0};
+	table[0x3D] = (Opcode) {dec_a, 0x0};
+
+	table[0x03] = (Opcode) {inc_bc, 0x0};
+	table[0x13] = (Opcode) {inc_de, 0x0};
+	table[0x23] = (Opcode) {inc_hl, 0x0};
+	table[0x33] = (Opcode) {inc_sp, 0x0};
+	table[0x0B] = (Opcode) {dec_bc, 0x0};
+	table[0x1B] = (Opcode) {dec_de, 0x0};
+	table[0x2B] = (Opcode) {dec_hl, 0x0};
+	table[0x3B] = (Opcode) {dec_sp, 0x0};
+	table[0x09] = (Opcode) {add_hl_bc, 0x0};
+	table[0x19] = (Opcode) {add_hl_de, 0x0};
+	table[0x29] = (Opcode) {add_hl_hl, 0x0};
+	table[0x39] = (Opcode) {add_hl_sp, 0x0};
+}		/* -----  end of function register_math_instructions  ----- */
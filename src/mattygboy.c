@@ -15,80 +15,162 @@
  * =====================================================================================
  */
 #include <unistd.h>
+#include <string.h>
+#include <limits.h>
 #include <stdlib.h>
 #include <stdio.h>
-#include "global_declarations.h"
-#include "cpu_emulator.h"
-#include "helper_functions.h"
-#include "memory.h"
+#include "mattygboy.h"
+#include "runner.h"
 
 #define EXIT_SUCCESS 0 // Quit without error condition
 
-unsigned char error_value = 0xFF;
-unsigned char boot_up = 0x0;
-Registers *regs;
-Pointers *ptrs;
-CPU_Flags *flags;
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  echo_serial
+ *  Description:  Streams serial output to a stdio stream, which buffers it
+ *   Parameters:  context is the FILE to write to
+ * =====================================================================================
+ */
+	static void
+echo_serial(void *context, unsigned char data)
+{
+	fputc(data, context);
+}		/* -----  end of function echo_serial  ----- */
 
-int main(int argc, char **argv)
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  print_registers
+ *  Description:  Prints the contents of the registers to the console
+ * =====================================================================================
+ */
+	static void
+print_registers(GB *gb)
+{
+	Register_Values values;
+
+	mattygboy_get_registers(gb, &values);
+	printf("Registers:\nAF: 0x%04X\nBC: 0x%04X\nDE: 0x%04X\nHL: 0x%04X\n",
+	       values.AF, values.BC, values.DE, values.HL);
+	printf("Stack pointer: 0x%02X Program Counter: 0x%02X\n", values.SP, values.PC);
+	printf("Flags: Z: 0x%02X N: 0x%02X H: 0x%02X C: 0x%02X IME: 0x%02X\n\n",
+	       (values.AF >> 0x7u) & 0x1u, (values.AF >> 0x6u) & 0x1u, (values.AF >> 0x5u) & 0x1u,
+	       (values.AF >> 0x4u) & 0x1u, values.IME);
+}		/* -----  end of function print_registers  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  write_json_summary
+ *  Description:  Writes a one line JSON summary of a run for scripts to collect
+ *   Parameters:  file is a path, or "-" for stdout
+ *       Return:  0 on success, -1 if the file can't be written
+ * =====================================================================================
+ */
+	static int
+write_json_summary(const char *file, const char *rom, GB *gb, const Run_Result *result)
+{
+	FILE *out = strcmp(file, "-") ? fopen(file, "w") : stdout;
+
+	if (out == NULL)
+	{
+		return -1;
+	}
+	print_run_json(out, rom, gb, result);
+	fputc('\n', out);
+	if (out != stdout)
+	{
+		fclose(out);
+	}
+	return 0x0;
+}		/* -----  end of function write_json_summary  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  usage
+ *  Description:  Prints the command line options
+ * =====================================================================================
+ */
+	static void
+usage(const char *program)
 {
-	// Virtual registers are loaded
-	regs = init_registers();
-	ptrs = init_pointers();
-	flags = init_flags();
+	fprintf(stderr, "usage: %s [options] rom.gb\n"
+	        "  -c cycles   stop after this many clock cycles\n"
+	        "  -f frames   stop after this many frames\n"
+	        "  -b file     run this 256 byte boot ROM first instead of skipping it\n"
+	        "  -p pc       stop when PC reaches this address, e.g. 0xC7D2\n"
+	        "  -s string   stop and pass when the rom sends this over serial\n"
+	        "  -x string   stop and fail when the rom sends this over serial\n"
+	        "  -l          stop when the cpu is stuck in an infinite loop\n"
+	        "  -j file     write a JSON summary to file, - for stdout and serial to stderr\n"
+	        "  -q          don't print the registers at the end\n"
+	        "exit status: 0 passed, %d failed, %d out of cycles or frames, %d stuck, "
+	        "%d illegal opcode\n", program, RUN_FAILED, RUN_LIMIT, RUN_STUCK, RUN_LOCKED_UP);
+}		/* -----  end of function usage  ----- */
 
-	// TODO: for now just load rom via command line argument
-	load_cartridge(argv[optind]);
-	init_memory();
+int main(int argc, char **argv)
+{
+	Run_Options options = {ULONG_MAX, ULONG_MAX, -1, NULL, NULL, 0x0};
+	const char *json_file = NULL; // "-" for stdout
+	const char *boot_rom_file = NULL; // Skip booting by default
+	int quiet = 0x0;
+	Run_Result result;
+	GB *gb;
+	int option;
 
-	// TODO: Main program loop, fetch/decode/execute
-	// TODO: just set up for testing for the moment
-	int i = 0;
+	while ((option = getopt(argc, argv, "b:c:f:p:s:x:lj:q")) != -1)
+	{
+		switch (option)
+		{
+			case 'b': boot_rom_file = optarg; break;
+			case 'c': options.max_cycles = strtoul(optarg, NULL, 0); break;
+			case 'f': options.max_frames = strtoul(optarg, NULL, 0); break;
+			case 'p': options.stop_pc = (int) (strtoul(optarg, NULL, 0) & 0xFFFFu); break;
+			case 's': options.pass_string = optarg; break;
+			case 'x': options.fail_string = optarg; break;
+			case 'l': options.stop_when_stuck = 0x1; break;
+			case 'j': json_file = optarg; break;
+			case 'q': quiet = 0x1; break;
+			default:
+				usage(argv[0]);
+				return EXIT_FAILURE;
+		}
+	}
+	if (optind >= argc)
+	{
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+	gb = mattygboy_open(argv[optind]);
+	if (gb == NULL)
+	{
+		fprintf(stderr, "%s can't be read or isn't a Game Boy rom\n", argv[optind]);
+		return EXIT_FAILURE;
+	}
+	if (boot_rom_file != NULL && mattygboy_reset(gb, boot_rom_file))
+	{
+		fprintf(stderr, "%s isn't a 256 byte boot ROM\n", boot_rom_file);
+		mattygboy_destroy(gb);
+		return EXIT_FAILURE;
+	}
 
-	while (ptrs->PC != 0xcc41)
+	// Keep stdout to the JSON alone when it goes there
+	mattygboy_set_serial_callback(gb, echo_serial, json_file != NULL && !strcmp(json_file, "-") ? stderr : stdout);
+	result = run_headless(gb, &options);
+	if (result.outcome == RUN_LOCKED_UP)
+	{
+		fprintf(stderr, "the cpu locked up on an illegal opcode\n");
+	}
+	if (!quiet)
+	{
+		printf("\n");
+		print_registers(gb);
+		printf("cycles is %lu\n", result.cycles);
+	}
+	if (json_file != NULL && write_json_summary(json_file, argv[optind], gb, &result))
 	{
-		cpu_execution();
-		i++;
+		fprintf(stderr, "can't write %s\n", json_file);
 	}
-	//dump_registers();
-	printf("\n");
-	dump_registers();
-	//    printf("ff05 is %x\n", read_memory(0xff05));
-	//    printf("ff06 is %x\n", read_memory(0xff06));
-	//    printf("ff07 is %x\n", read_memory(0xff07));
-	//    printf("ff10 is %x\n", read_memory(0xff10));// wrong
-	//    printf("ff11 is %x\n", read_memory(0xff11));// wrong
-	//    printf("ff12 is %x\n", read_memory(0xff12));
-	//    printf("ff14 is %x\n", read_memory(0xff14));// wrong
-	//    printf("ff16 is %x\n", read_memory(0xff16));// wrong
-	//    printf("ff17 is %x\n", read_memory(0xff17));
-	//    printf("ff19 is %x\n", read_memory(0xff19));// wrong
-	//    printf("ff1a is %x\n", read_memory(0xff1a));// wrong
-	//    printf("ff1b is %x\n", read_memory(0xff1b));// wrong
-	//    printf("ff1c is %x\n", read_memory(0xff1c));// wrong
-	//    printf("ff1e is %x\n", read_memory(0xff1e));// wrong
-	//    printf("ff20 is %x\n", read_memory(0xff20));// wrong
-	//    printf("ff21 is %x\n", read_memory(0xff21));
-	//    printf("ff22 is %x\n", read_memory(0xff22));
-	//    printf("ff23 is %x\n", read_memory(0xff23));// wrong
-	//    printf("ff24 is %x\n", read_memory(0xff24));
-	//    printf("ff25 is %x\n", read_memory(0xff25));
-	//    printf("ff26 is %x\n", read_memory(0xff26));// wrong
-	//    printf("ff40 is %x\n", read_memory(0xff40));
-	//    printf("ff42 is %x\n", read_memory(0xff42));
-	//    printf("ff43 is %x\n", read_memory(0xff43));
-	//    printf("ff45 is %x\n", read_memory(0xff45));
-	//    printf("ff47 is %x\n", read_memory(0xff47));
-	//    printf("ff48 is %x\n", read_memory(0xff48));// wrong
-	//    printf("ff49 is %x\n", read_memory(0xff49));// wrong
-	//    printf("ff4a is %x\n", read_memory(0xff4a));
-	//    printf("ff4b is %x\n", read_memory(0xff4b));
-	//    printf("ffff is %x\n", read_memory(0xffff));
-	printf("i is %d\n", i);
-	//dump_memory(0xC000, 0xCC70);
 
-	free(regs);
-	free(ptrs);
-	free(flags);
-	return EXIT_SUCCESS;
-}
\ No newline at end of file
+	free_run_result(&result);
+	mattygboy_destroy(gb);
+	return result.outcome;
+}
@@ -18,147 +18,227 @@
  *
  * =====================================================================================
  */
-#include <stdlib.h>
-#include <stdio.h>
+#include <string.h>
 #include <cpu_emulator.h>
 #include "memory.h"
+#include "cartridge.h"
 #include "global_declarations.h"
+#include "graphics.h"
+#include "idle_loop.h"
+#include "joypad.h"
+#include "scheduler.h"
+#include "serial.h"
+#include "timers.h"
+#ifdef JIT
+#include "jit.h"
+#define CACHED_CODE
+#define invalidate_code jit_invalidate
+#define flush_code jit_flush
+#elif defined(BLOCK_CACHE)
+#include "block_cache.h"
+#define CACHED_CODE
+#define invalidate_code block_cache_invalidate
+#define flush_code block_cache_flush
+#endif
 
-// Track ROM banking
-static unsigned char banking_mode;
-static MBC_Registers *mbc = NULL;
+unsigned char error_value = 0xFF; // Returned for reads of disabled RAM
 
-// Track RAM banking
-static unsigned char *ext_ram_bank = NULL; // Single array to virtualize all RAM banks
+// The io page as the boot ROM leaves it, a skip-boot start copies it in whole
+static const unsigned char post_boot_io[0x100] = {
+    [0x00] = 0xCF, // Neither button row selected
+    [0x05] = 0x00,
+    [0x06] = 0x00,
+    [0x07] = 0x00,
+    [0x10] = 0x80,
+    [0x11] = 0xBF,
+    [0x12] = 0xF3,
+    [0x14] = 0xBF,
+    [0x16] = 0x3F,
+    [0x17] = 0x00,
+    [0x19] = 0xBF,
+    [0x1A] = 0x7F,
+    [0x1B] = 0xFF,
+    [0x1C] = 0x9F,
+    [0x1E] = 0xBF,
+    [0x20] = 0xFF,
+    [0x21] = 0x00,
+    [0x22] = 0x00,
+    [0x23] = 0xBF,
+    [0x24] = 0x77,
+    [0x25] = 0xF3,
+    [0x26] = 0xF1,
+    [0x40] = 0x91,
+    [0x42] = 0x00,
+    [0x43] = 0x00,
+    [0x45] = 0x00,
+    [0x47] = 0xFC,
+    [0x48] = 0xFF,
+    [0x49] = 0xFF,
+    [0x4A] = 0x00,
+    [0x4B] = 0x00,
+    [0xFF] = 0x00,
+};
 
 /*
  * ===  FUNCTION  ======================================================================
  *         Name:  init_memory
- *  Description:  Initializes the the virtual memory
+ *  Description:  Initializes the virtual memory and resets the devices, either
+ *                  to power on with the boot ROM mapped in or straight to the state
+ *                  the boot ROM leaves behind
+ *   Parameters:  boot_rom is the 256 byte boot ROM to run, NULL to skip booting
  * =====================================================================================
  */
 	void
-init_memory()
+init_memory(GB *gb, const unsigned char *boot_rom)
 {
-	unsigned char *new_memory = malloc(0xFFFF);
-	unsigned char *boot = malloc(0xFF);
-
-	// Load BIOS
-    FILE *bios_file = fopen("/Users/MattyG/Documents/Programming/BIOS.gb", "r");
-    fread(boot, 0x1, 0xFF, bios_file);
-    fclose(bios_file);
-
-	memory = new_memory;
-    memory[0xFF05] = 0x00;
-    memory[0xFF06] = 0x00;
-    memory[0xFF07] = 0x00;
-    memory[0xFF10] = 0x80;
-    memory[0xFF11] = 0xBF;
-    memory[0xFF12] = 0xF3;
-    memory[0xFF14] = 0xBF;
-    memory[0xFF16] = 0x3F;
-    memory[0xFF17] = 0x00;
-    memory[0xFF19] = 0xBF;
-    memory[0xFF1A] = 0x7F;
-    memory[0xFF1B] = 0xFF;
-    memory[0xFF1C] = 0x9F;
-    memory[0xFF1E] = 0xBF;
-    memory[0xFF20] = 0xFF;
-    memory[0xFF21] = 0x00;
-    memory[0xFF22] = 0x00;
-    memory[0xFF23] = 0xBF;
-    memory[0xFF24] = 0x77;
-    memory[0xFF25] = 0xF3;
-    memory[0xFF26] = 0xF1;
-    memory[0xFF40] = 0x91;
-    memory[0xFF42] = 0x00;
-    memory[0xFF43] = 0x00;
-    memory[0xFF45] = 0x00;
-    memory[0xFF47] = 0xFC;
-    memory[0xFF48] = 0xFF;
-    memory[0xFF49] = 0xFF;
-    memory[0xFF4A] = 0x00;
-    memory[0xFF4B] = 0x00;
-    memory[0xFFFF] = 0x00;
-    boot_rom = boot;
+    if (boot_rom != NULL) // Registers and io start cleared, the boot ROM sets them up
+    {
+        memcpy(gb->boot_rom, boot_rom, sizeof(gb->boot_rom));
+        memset(&gb->memory[0xFF00], 0x0, 0x100);
+        memset(&gb->regs, 0x0, sizeof(gb->regs));
+        gb->boot_up = 0x1;
+    }
+    else
+    {
+        memcpy(&gb->memory[0xFF00], post_boot_io, sizeof(post_boot_io));
+        init_registers(&gb->regs);
+        gb->boot_up = 0x0;
+    }
+    gb->locked_up = 0x0;
+#ifdef LAZY_FLAGS
+    gb->lazy.pending = 0x0; // F was just set
+#endif
+    memset(gb->disabled_ram, error_value, sizeof(gb->disabled_ram));
+    update_memory_map(gb);
+    init_scheduler(gb); // Timers, the lcd, and the serial port start over with the new registers
+    init_idle_loops(gb);
+#ifdef CACHED_CODE
+    flush_code(gb); // Blocks from the last cartridge are stale
+#endif
 }		/* -----  end of function init_memory  ----- */
 
 /*
  * ===  FUNCTION  ======================================================================
- *         Name:  load_cartridge
- *  Description:  Loads the game cartridge rom and parses the cartridge header
+ *         Name:  insert_cartridge
+ *  Description:  Parses the cartridge header and maps the cartridge in, replacing
+ *                  any cartridge loaded before
+ *   Parameters:  new_cartridge is a checked rom, the instance takes over the
+ *                  caller's reference to it
  * =====================================================================================
  */
-	void
-load_cartridge(char *file)
+	static void
+insert_cartridge(GB *gb, Cartridge *new_cartridge)
 {
-	unsigned char *new_cartridge = malloc(0x200000);
-	FILE *binary_file = fopen(file, "r");
-	fread(new_cartridge, 0x1, 0x200000, binary_file);
-	fclose(binary_file);
-
 	// Parse fields of the header to determine rom/ram banking used
-	switch (new_cartridge[0x147]) // Which mbc should be used
+	switch (new_cartridge->rom[0x147]) // Which mbc should be used
 	{
 		case 0x0:
-			banking_mode = 0x0; // ROM only
+			gb->banking_mode = 0x0; // ROM only
 			break;
 		case 0x1 ... 0x3: // MBC1
-			banking_mode = 0x1;
-			mbc = init_mbc();
+			gb->banking_mode = 0x1;
+			init_mbc(gb);
 			break;
 		case 0x5 ... 0x6:
-			banking_mode = 0x2;
-			mbc = init_mbc();
+			gb->banking_mode = 0x2;
+			init_mbc(gb);
 			break;
 		default: // Other banking not handled yet
-			banking_mode = 0x0;
+			gb->banking_mode = 0x0;
 			break;
 	}
 	// Allocate memory as appropriate based on size indicated by header
-	switch (new_cartridge[0x149])
+	switch (gb->mbc != NULL ? new_cartridge->rom[0x149] : 0x0) // No RAM without an MBC
 	{
 		case 0x0:
 		    break;
 		case 0x1:
-			mbc->ram_bank_size = 0x800;
-			ext_ram_bank = malloc(0x1000);
+			gb->mbc->ram_bank_size = 0x800;
+			gb->ext_ram_bank = gb->ext_ram;
 			break;
 		case 0x2:
-		    mbc->ram_bank_size = 0x800;
-			ext_ram_bank = malloc(0x2000);
+		    gb->mbc->ram_bank_size = 0x800;
+			gb->ext_ram_bank = gb->ext_ram;
 			break;
 		case 0x3:
-		    mbc->ram_bank_size = 0x2000;
-			ext_ram_bank = malloc(0x8000);
+		    gb->mbc->ram_bank_size = 0x2000;
+			gb->ext_ram_bank = gb->ext_ram;
 			break;
 	    case 0x4:
-	        mbc->ram_bank_size = 0x2000;
-	        ext_ram_bank = malloc(0x20000);
+	        gb->mbc->ram_bank_size = 0x2000;
+	        gb->ext_ram_bank = gb->ext_ram;
 	        break;
 	    case 0x5:
-	        mbc->ram_bank_size = 0x2000;
-	        ext_ram_bank = malloc(0x10000);
+	        gb->mbc->ram_bank_size = 0x2000;
+	        gb->ext_ram_bank = gb->ext_ram;
 	        break;
 		default:
 			break;
 	}
 
-	cartridge = new_cartridge;
+	release_cartridge(gb->cartridge);
+	gb->cartridge = new_cartridge;
+	update_memory_map(gb);
+}               /* -----  end of function insert_cartridge  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  load_cartridge
+ *  Description:  Loads the game cartridge rom and parses the cartridge header. The
+ *                  file is mapped read only and shared with any other instance
+ *                  running it
+ *   Parameters:  file is the path of the rom
+ *       Return:  0 on success, -1 if the file can't be read or fails the header
+ *                  checks
+ * =====================================================================================
+ */
+	int
+load_cartridge(GB *gb, const char *file)
+{
+	Cartridge *new_cartridge = open_cartridge(file);
+
+	if (new_cartridge == NULL)
+	{
+		return -1;
+	}
+	insert_cartridge(gb, new_cartridge);
+	return 0x0;
 }               /* -----  end of function load_cartridge  ----- */
 
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  load_cartridge_data
+ *  Description:  Loads a cartridge rom already in memory, the bytes are copied so
+ *                  the caller may free them afterwards
+ *   Parameters:  data is the rom image and size its length in bytes
+ *       Return:  0 on success, -1 if the rom fails the header checks or out of
+ *                  memory
+ * =====================================================================================
+ */
+	int
+load_cartridge_data(GB *gb, const unsigned char *data, unsigned long size)
+{
+	Cartridge *new_cartridge = copy_cartridge(data, size);
+
+	if (new_cartridge == NULL)
+	{
+		return -1;
+	}
+	insert_cartridge(gb, new_cartridge);
+	return 0x0;
+}               /* -----  end of function load_cartridge_data  ----- */
+
 /*
  * ===  FUNCTION  ======================================================================
  *         Name:  init_mbc
  *  Description:  Initializes struct containing needed registers when using an MBC chip
- *      Returns:  Pointer to a struct containing registers for MBC chip
  * =====================================================================================
  */
-MBC_Registers*
-init_mbc()
+void
+init_mbc(GB *gb)
 {
-	MBC_Registers *mbc_ptr = malloc(sizeof(*mbc_ptr));
-	if (banking_mode == 1) // MBC1
+	MBC_Registers *mbc_ptr = &gb->mbc_registers;
+	if (gb->banking_mode == 1) // MBC1
 	{
 		mbc_ptr->ram_enable = 0x0;
 		mbc_ptr->rom_bank_number = 0x1;
@@ -167,7 +247,7 @@ init_mbc()
 		mbc_ptr->ram_rom_select = 0x0;
 	}
 
-	if (banking_mode == 2) // MBC2
+	if (gb->banking_mode == 2) // MBC2
 	{
 		mbc_ptr->ram_enable = 0x0;
 		mbc_ptr->rom_bank_number = 0x1;
@@ -176,293 +256,549 @@ init_mbc()
 		mbc_ptr->ram_rom_select = 0xFF;
 	}
 
-	return mbc_ptr;
+	gb->mbc = mbc_ptr;
 }               /* -----  end of function init_mbc  ----- */
 
 /*
  * ===  FUNCTION  ======================================================================
- *         Name:  read_memory
- *  Description:  Returns a 1-byte value located at the specified memory address
- *  		        while taking into account rom and ram banks
- *   Parameters:  addr is a 16-bit memory address
+ *         Name:  current_rom_bank
+ *  Description:  Returns the ROM bank mapped in at 0x4000-0x7FFF
  * =====================================================================================
  */
 	unsigned char
-read_memory(unsigned short addr)
+current_rom_bank(GB *gb)
 {
-	unsigned char data;
-
-	if (boot_up && (addr < 0x100)) // Only use during boot process
-    {
-        return boot_rom[addr];
-    }
+	return gb->mbc != NULL ? gb->mbc->rom_bank_number : (unsigned char) 0x1;
+}		/* -----  end of function current_rom_bank  ----- */
 
-	if (banking_mode == 1) // MBC1
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  code_region
+ *  Description:  Finds the memory region code at an address runs in, translated and
+ *                decoded blocks never cross the end of a region
+ *   Parameters:  addr is the address of the code
+ *                key receives the cache key of a block starting at addr, the ROM
+ *                bank in the upper half and the address in the lower
+ *       Return:  One past the last address of the region, 0 if code there isn't
+ *                cached (boot ROM, VRAM, external RAM, echo and i/o)
+ * =====================================================================================
+ */
+	unsigned int
+code_region(GB *gb, unsigned short addr, unsigned int *key)
+{
+	*key = addr;
+	if (gb->boot_up && addr < 0x100)
 	{
-        if (addr < 0x4000)
-        {
-            data = cartridge[addr];
-        }
-        else if ((addr >= 0x4000) && (addr < 0x8000)) // Read from ROM banks
-        {
-        addr -= 0x4000;
-        data = cartridge[addr + (mbc->rom_bank_number * 0x4000)];
-        }
-        else if ((addr >= 0xA000) && (addr < 0xC000))
-        // Read from RAM banks
-        {
-            if (!mbc->ram_enable)
-            {
-                return error_value;
-            }
-            else
-            {
-                // Getting a segfault here
-                addr -= 0xA000;
-                data = ext_ram_bank[addr + (mbc->ram_bank_number * mbc->ram_bank_size)];
-            }
-        }
-        else
-        {
-            data = memory[addr];
-        }
+		return 0x0;
 	}
-	else if (banking_mode == 2) // MBC2
-	    {
-            if (addr < 0x4000)
-            {
-                data = cartridge[addr];
-            }
-            else if ((addr > 0x3FFF) && (addr < 0x8000)) // Read from ROM banks
-            {
-                data = cartridge[addr + (mbc->rom_bank_number * 0x4000)];
-            }
-            else
-            {
-                data = memory[addr];
-            }
-	    }
-	else // No memory banking
+	if (addr < 0x4000)
 	{
-        if (addr < 0x8000)
-        {
-            data = cartridge[addr];
-        }
-        else
-        {
-            data = memory[addr];
-        }
+		return 0x4000;
 	}
+	if (addr < 0x8000)
+	{
+		*key |= (unsigned int) current_rom_bank(gb) << 0x10u;
+		return 0x8000;
+	}
+	if (addr >= 0xC000 && addr < 0xE000)
+	{
+		return 0xE000;
+	}
+	if (addr >= 0xFF80 && addr < 0xFFFF)
+	{
+		return 0xFFFF;
+	}
+	return 0x0;
+}		/* -----  end of function code_region  ----- */
 
-	return data;
-}		/* -----  end of function read_memory  ----- */
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  rom_bank
+ *  Description:  Returns the start of a ROM bank, bank numbers past the end of the
+ *                  rom wrap around as the unused upper bits are ignored
+ * =====================================================================================
+ */
+    static unsigned char*
+rom_bank(GB *gb, unsigned int bank)
+{
+    return &gb->cartridge->rom[(bank % gb->cartridge->rom_banks) * 0x4000];
+}		/* -----  end of function rom_bank  ----- */
 
 /*
  * ===  FUNCTION  ======================================================================
- *         Name:  read_memory_ptr
- *  Description:  Returns a pointer to the specified memory address while taking
- *                  into account rom and ram banks
+ *         Name:  decode_read
+ *  Description:  Works out where a read of the specified address goes while taking
+ *                  into account the boot rom, rom and ram banks. This is the slow
+ *                  path, update_memory_map runs it once per page
  *   Parameters:  addr is a 16-bit memory address
+ *       Return:  Pointer to the byte at addr, &error_value for disabled RAM
  * =====================================================================================
  */
     unsigned char*
-read_memory_ptr(unsigned short addr)
+decode_read(GB *gb, unsigned short addr)
 {
     unsigned char *mem;
 
-    if (banking_mode == 1) // MBC1
+    if (gb->boot_up && (addr < 0x100)) // Only use during boot process
+    {
+        return &gb->boot_rom[addr];
+    }
+
+    if (gb->banking_mode == 1) // MBC1
     {
         if ((addr > 0x3FFF) && (addr < 0x8000)) // Read from ROM banks
         {
-            addr -= 0x4000;
-            mem = &cartridge[addr + (mbc->rom_bank_number * 0x4000)];
+            mem = &rom_bank(gb, gb->mbc->rom_bank_number)[addr - 0x4000];
         }
         else if ((addr > 0x9FFF) && (addr < 0xC000))
         // Read from RAM banks
         {
             {
-                if (!mbc->ram_enable)
+                if (!gb->mbc->ram_enable || gb->ext_ram_bank == NULL)
                 {
                     return &error_value;
                 }
                 else
                 {
                     addr -= 0xA000;
-                    mem = &ext_ram_bank[addr + (mbc->ram_bank_number * mbc->ram_bank_size)];
+                    mem = &gb->ext_ram_bank[addr + (gb->mbc->ram_bank_number * gb->mbc->ram_bank_size)];
                 }
             }
         }
+        else if (addr < 0x4000)
+        {
+            mem = &gb->cartridge->rom[addr];
+        }
         else
         {
-            mem = &memory[addr];
+            mem = &gb->memory[addr];
         }
     }
-    else if (banking_mode == 2) // MBC2
+    else if (gb->banking_mode == 2) // MBC2
     {
-        if ((addr > 0x3FFF) && (addr < 0x8000)) // Read from ROM banks
+        if (addr < 0x4000)
         {
-            mem = &cartridge[addr + (mbc->rom_bank_number * 0x4000)];
+            mem = &gb->cartridge->rom[addr];
+        }
+        else if ((addr > 0x3FFF) && (addr < 0x8000)) // Read from ROM banks
+        {
+            mem = &rom_bank(gb, gb->mbc->rom_bank_number)[addr - 0x4000];
         }
         else
         {
-            mem = &memory[addr];
+            mem = &gb->memory[addr];
         }
     }
     else // No memory banking
     {
         if (addr < 0x8000)
         {
-            mem = &cartridge[addr];
+            mem = &gb->cartridge->rom[addr];
         }
         else
         {
-            mem = &memory[addr];
+            mem = &gb->memory[addr];
         }
     }
 
     return mem;
+}		/* -----  end of function decode_read  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  update_memory_map
+ *  Description:  Rebuilds the page tables used by read_memory and write_memory.
+ *                  Must run whenever the cartridge, an MBC register, or the boot
+ *                  rom latch changes
+ * =====================================================================================
+ */
+    void
+update_memory_map(GB *gb)
+{
+    for (unsigned int page = 0x0; page < 0x100; page++)
+    {
+        unsigned char *mem = decode_read(gb, (unsigned short) (page << 0x8u));
+
+        gb->read_pages[page] = mem == &error_value ? gb->disabled_ram : mem;
+        gb->write_pages[page] = NULL;
+    }
+    gb->read_pages[0xFF] = NULL; // P1, DIV, and TIMA are worked out when read, see read_io
+
+    // Only VRAM and work RAM writes have no side effects
+    for (unsigned int page = 0x80; page < 0xA0; page++)
+    {
+        gb->write_pages[page] = &gb->memory[page << 0x8u];
+    }
+    for (unsigned int page = 0xC0; page < 0xE0; page++)
+    {
+        gb->write_pages[page] = &gb->memory[page << 0x8u];
+    }
+
+    // External RAM once enabled, banked the same way decode_write does
+    if (gb->mbc != NULL && gb->mbc->ram_enable && gb->ext_ram_bank != NULL)
+    {
+        for (unsigned int page = 0xA0; page < 0xC0; page++)
+        {
+            gb->write_pages[page] = &gb->ext_ram_bank[(page << 0x8u) - 0xA000 +
+                                              gb->mbc->ram_bank_number * 0x2000];
+        }
+    }
+}		/* -----  end of function update_memory_map  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  read_io
+ *  Description:  Slow path for reads from the io page, which has no read pointer
+ *                  so the joypad and timer registers can be computed on demand
+ *   Parameters:  addr is a 16-bit memory address from 0xFF00 up
+ * =====================================================================================
+ */
+    static unsigned char
+read_io(GB *gb, unsigned short addr)
+{
+    if (addr == 0xFF00)
+    {
+        return read_joypad(gb);
+    }
+    if (addr == 0xFF04)
+    {
+        return read_divider(gb);
+    }
+    if (addr == 0xFF05)
+    {
+        return read_timer_counter(gb);
+    }
+    return gb->memory[addr];
+}		/* -----  end of function read_io  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  read_memory
+ *  Description:  Returns a 1-byte value located at the specified memory address
+ *  		        while taking into account rom and ram banks
+ *   Parameters:  addr is a 16-bit memory address
+ * =====================================================================================
+ */
+	unsigned char
+read_memory(GB *gb, unsigned short addr)
+{
+	unsigned char *page = gb->read_pages[addr >> 0x8u];
+
+	if (page != NULL)
+	{
+		return page[addr & 0xFFu];
+	}
+	return read_io(gb, addr);
+}		/* -----  end of function read_memory  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  is_drawn_from
+ *  Description:  Returns true for VRAM, OAM, and the lcd registers that change what
+ *                  lines look like
+ * =====================================================================================
+ */
+    static inline int
+is_drawn_from(unsigned short addr)
+{
+    if (addr < 0xFE00u)
+    {
+        return (unsigned short) (addr - 0x8000u) < 0x2000u;
+    }
+    return addr < 0xFEA0u || ((unsigned short) (addr - 0xFF40u) < 0xCu &&
+                              ((LCD_VISIBLE_REGISTERS >> (addr - 0xFF40u)) & 0x1u));
+}       /* -----  end of function is_drawn_from  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  drawn_from_changed
+ *  Description:  Makes the lines, and the tile, drawn from an address draw again
+ * =====================================================================================
+ */
+    static inline void
+drawn_from_changed(GB *gb, unsigned short addr)
+{
+    gb->line_cache.writes++;
+    if ((unsigned short) (addr - 0x8000u) < VRAM_TILES * 0x10u)
+    {
+        gb->tile_cache.valid[(addr - 0x8000u) >> 0x4u] = 0x0;
+    }
+}       /* -----  end of function drawn_from_changed  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  read_memory_ptr
+ *  Description:  Returns a pointer to the specified memory address while taking
+ *                  into account rom and ram banks
+ *   Parameters:  addr is a 16-bit memory address
+ * =====================================================================================
+ */
+    unsigned char*
+read_memory_ptr(GB *gb, unsigned short addr)
+{
+#ifdef CACHED_CODE
+    // The caller may write through the pointer, which write_memory never sees
+    if (gb->code_lines[addr >> 0x4u])
+    {
+        invalidate_code(gb, addr);
+    }
+#endif
+    if (is_drawn_from(addr)) // Lines and tiles written through it are drawn again
+    {
+        drawn_from_changed(gb, addr);
+    }
+
+    if (gb->read_pages[addr >> 0x8u] == NULL) // Refresh the timer registers first
+    {
+        gb->memory[addr] = read_io(gb, addr);
+        return &gb->memory[addr];
+    }
+    if (addr < 0x8000) // ROM is read only, writes go nowhere
+    {
+        gb->rom_write = gb->read_pages[addr >> 0x8u][addr & 0xFFu];
+        return &gb->rom_write;
+    }
+    return &gb->read_pages[addr >> 0x8u][addr & 0xFFu];
 }		/* -----  end of function read_memory_ptr  ----- */
 
 /*
  * ===  FUNCTION  ======================================================================
- *         Name:  write_memory
- *  Description:  Writes data to the appropriate location in virtual memory
- *   Parameters:  addr is the memory address to write to
- *   			  data is the byte of data to write there
+ *         Name:  write_mbc_register
+ *  Description:  Handles writes to the MBC registers in the ROM address range
+ *   Parameters:  addr is the memory address written
+ *   			  data is the byte of data written there
  * =====================================================================================
  */
-	void
-write_memory(unsigned short addr, unsigned char data)
+	static void
+write_mbc_register(GB *gb, unsigned short addr, unsigned char data)
 {
     if (addr <= 0x1FFF) // RAM enable
     {
         // Enable RAM if lower nibble of data == 0xA
-        mbc->ram_enable = (unsigned char) ((data & 0xFu) == 0xA ? 1 : 0);
-        return;
+        gb->mbc->ram_enable = (unsigned char) ((data & 0xFu) == 0xA ? 1 : 0);
     }
     else if (addr >= 0x2000 && addr <= 0x3FFF) // Set low 5 bits of rom bank
     {
-        mbc->rom_bank_number += (unsigned char) (data & 0x1Fu);
+        gb->mbc->rom_bank_number += (unsigned char) (data & 0x1Fu);
 
-        switch (mbc->rom_bank_number)
+        switch (gb->mbc->rom_bank_number)
         {
             case 0x0: // Bank 0 is fixed
-                mbc->rom_bank_number = 0x1;
+                gb->mbc->rom_bank_number = 0x1;
                 break;
             case 0x20: // Banks 20, 40, and 60 aren't used/don't exist
-                mbc->rom_bank_number = 0x21;
+                gb->mbc->rom_bank_number = 0x21;
                 break;
             case 0x40:
-                mbc->rom_bank_number = 0x41;
+                gb->mbc->rom_bank_number = 0x41;
                 break;
             case 0x61:
-                mbc->rom_bank_number = 0x61;
+                gb->mbc->rom_bank_number = 0x61;
                 break;
             default:
                 break;
         }
-        return;
     }
     else if (addr > 0x3FFF && addr < 0x6000) // Set ram bank or upper 2 bits rom
     {
-        if (mbc->ram_rom_select) // RAM mode
+        if (gb->mbc->ram_rom_select) // RAM mode
         {
-            mbc->ram_bank_number = (unsigned char) (data & 0x3u);
+            gb->mbc->ram_bank_number = (unsigned char) (data & 0x3u);
         }
         else // ROM mode, set bits 5 and 6 of rom bank
         {
-            mbc->rom_bank_number &= 0x6E0u;
+            gb->mbc->rom_bank_number &= 0x6E0u;
             data &= 0x1Fu;
-            mbc->rom_bank_number |= data;
-            if (mbc->rom_bank_number == 0x0)
+            gb->mbc->rom_bank_number |= data;
+            if (gb->mbc->rom_bank_number == 0x0)
             {
-                mbc->rom_bank_number = 0x1;
+                gb->mbc->rom_bank_number = 0x1;
             }
         }
     }
-    else if (addr > 0x5FFF && addr < 0x8000) // Select RAM/ROM mode
+    else // Select RAM/ROM mode
     {
-        mbc->ram_rom_select = (unsigned char) (data & 0x1u);
+        gb->mbc->ram_rom_select = (unsigned char) (data & 0x1u);
 
-        if (mbc->ram_rom_select)
+        if (gb->mbc->ram_rom_select)
         {
-            mbc->ram_bank_number = 0;
+            gb->mbc->ram_bank_number = 0;
+        }
+    }
+}       /* -----  end of function write_mbc_register  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  oam_dma
+ *  Description:  Copies 0xA0 bytes into sprite attribute memory for a write to the DMA
+ *                  register. The copy happens at once, the cpu isn't held off of the
+ *                  bus for the 160 cycles it takes on hardware
+ *   Parameters:  data is the upper byte of the source address
+ * =====================================================================================
+ */
+	static void
+oam_dma(GB *gb, unsigned char data)
+{
+    // Sources past work RAM read its echo, like the DMA controller does
+    unsigned short source = (unsigned short) ((data < 0xE0u ? data : data - 0x20u) << 0x8u);
+    int changed = 0x0;
+
+    for (unsigned short i = 0x0; i < 0xA0u; i++)
+    {
+        unsigned char byte = read_memory(gb, (unsigned short) (source + i));
+
+        changed |= gb->memory[0xFE00u + i] != byte;
+        gb->memory[0xFE00u + i] = byte;
+    }
+    if (changed) // Sprites may have moved on any line
+    {
+        drawn_from_changed(gb, 0xFE00);
+    }
+}       /* -----  end of function oam_dma  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  decode_write
+ *  Description:  Writes data to the appropriate location in virtual memory, handling
+ *                  every side effect. This is the slow path write_memory takes for
+ *                  pages without a write pointer
+ *   Parameters:  addr is the memory address to write to
+ *   			  data is the byte of data to write there
+ * =====================================================================================
+ */
+	void
+decode_write(GB *gb, unsigned short addr, unsigned char data)
+{
+    if (addr < 0x8000) // MBC registers, banks may move under the page tables
+    {
+        if (gb->mbc != NULL) // ROM only carts ignore them
+        {
+            write_mbc_register(gb, addr, data);
+            update_memory_map(gb);
         }
     }
     else if (addr > 0x9FFF && addr < 0xC000) // External RAM banks
     {
-        if (mbc->ram_enable)
+        if (gb->mbc != NULL && gb->mbc->ram_enable && gb->ext_ram_bank != NULL)
         {
             addr -= 0xA000;
-            ext_ram_bank[addr + (mbc->ram_bank_number * 0x2000)] = data;
+            gb->ext_ram_bank[addr + (gb->mbc->ram_bank_number * 0x2000)] = data;
         }
     }
     else if (addr > 0xDFFF && addr < 0xFE00) // ECHO
     {
-        memory[addr] = data;
-        memory[addr - 0x2000] = data;
+        gb->memory[addr] = data;
+        gb->memory[addr - 0x2000] = data;
+#ifdef CACHED_CODE
+        if (gb->code_lines[(addr - 0x2000) >> 0x4u])
+        {
+            invalidate_code(gb, addr - 0x2000);
+        }
+#endif
     }
     else if (addr >= 0xFEA0 && addr < 0xFF00) // Unusable because reasons
     {
         return;
     }
-    else if (addr == 0xFF04) // Divider Register, any write sets to 0
+    else if (addr > 0xFF03 && addr < 0xFF08) // DIV, TIMA, TMA, and TAC
     {
-        memory[0xFF04] = 0x0;
+        gb->memory[addr] = addr == 0xFF04 ? 0x0 : data; // Any write sets DIV to 0
+        write_timer_register(gb, addr, data);
     }
     else if (addr == 0xFF44) // Writes to y coordinate register clear it
     {
-        memory[0xFF44] = 0x0;
+        gb->memory[0xFF44] = 0x0;
     }
-    else if (addr == 0xFF02 && data == 0x81) // Serial cable out
+    else if (addr == 0xFF40) // Lcd control, the lcd may turn on or off
     {
-        printf("%c\n", read_memory(0xFF01));
-        fflush(stdout);
+        gb->memory[addr] = data;
+        lcd_control_changed(gb);
+    }
+    else if (addr == 0xFF46) // DMA, copies sprite attributes from data << 8
+    {
+        gb->memory[addr] = data;
+        oam_dma(gb, data);
+    }
+    else if (addr == 0xFF00) // Joypad row select, may request the joypad interrupt
+    {
+        write_joypad(gb, data);
+    }
+    else if (addr == 0xFF02) // Serial control, may start a transfer
+    {
+        write_serial_control(gb, data);
+    }
+    else if (addr == 0xFF50) // Any nonzero write unmaps the boot rom
+    {
+        gb->memory[addr] = data;
+        if (data)
+        {
+            gb->boot_up = 0x0;
+            update_memory_map(gb);
+        }
     }
     else // Unrestricted memory write access
     {
-        memory[addr] = data;
+        gb->memory[addr] = data;
     }
-}       /* -----  end of function write_memory  ----- */
+}       /* -----  end of function decode_write  ----- */
 
 /*
  * ===  FUNCTION  ======================================================================
- *         Name:  increment_divider
- *  Description:  Increments the divider register, mem address 0xFF04
+ *         Name:  write_memory
+ *  Description:  Writes data to the appropriate location in virtual memory
+ *   Parameters:  addr is the memory address to write to
+ *   			  data is the byte of data to write there
  * =====================================================================================
  */
-void
-increment_divider()
+	void
+write_memory(GB *gb, unsigned short addr, unsigned char data)
 {
-    memory[0xFF04]++;
-}		/* -----  end of function increment_divider  ----- */
+    unsigned char *page = gb->write_pages[addr >> 0x8u];
+
+#ifdef CACHED_CODE
+    // MBC writes may switch the bank under a block, RAM writes may hit cached code
+    if (addr < 0x8000 || gb->code_lines[addr >> 0x4u])
+    {
+        invalidate_code(gb, addr);
+    }
+#endif
+    // Lines and tiles are drawn again only after what they're drawn from changes
+    if (is_drawn_from(addr) && gb->memory[addr] != data)
+    {
+        drawn_from_changed(gb, addr);
+    }
+
+    if (page != NULL)
+    {
+        page[addr & 0xFFu] = data;
+        return;
+    }
+    decode_write(gb, addr, data);
+}       /* -----  end of function write_memory  ----- */
 
 /*
  * ===  FUNCTION  ======================================================================
  *         Name:  increment_scanline
- *  Description:  Increments the y coordinate register, mem address 0xFF44
+ *  Description:  Increments the y coordinate register, mem address 0xFF44. Lines are
+ *                  drawn by lcd_event at the end of their transfer to the lcd
  *   Parameters:  mem is a pointer to the virtual memory
  * =====================================================================================
  */
 void
-increment_scanline()
+increment_scanline(GB *gb)
 {
-    unsigned char cur_line = read_memory(0xFF44);
+    unsigned char cur_line = read_memory(gb, 0xFF44);
     cur_line++;
 
     if (cur_line == 0x90u) // V-Blank interrupt request
     {
-        request_interrupt(0x1u);
+        request_interrupt(gb, 0x1u);
     }
     else if (cur_line > 0x99u) // Past last vertical line
     {
         cur_line = 0x0u;
 
     }
-    else if (cur_line < 0x90u)
-    {
-        // TODO: Draw a line
-    }
 
-    memory[0xFF44] = cur_line;
+    gb->memory[0xFF44] = cur_line;
 }		/* -----  end of function increment_scanline  ----- */
@@ -0,0 +1,395 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  movie.c
+ *
+ *    Description:  Input movies, a recording of every change to the buttons and the
+ *                  clock cycle it happened on. Replaying one into an instance in the
+ *                  same state the recording started from runs the same session, which
+ *                  hashes of the frame taken while recording confirm. Replays run
+ *                  straight from one recorded cycle to the next, as fast as the core
+ *                  can go
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026 02:05:31
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Matt Gercz (matt.gercz@icloud.com)
+ *
+ * =====================================================================================
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "mattygboy.h"
+#include "global_declarations.h"
+
+#define MOVIE_MAGIC 0x4D42474Du // "MGBM"
+#define MOVIE_VERSION 0x1
+
+// Each record is a count of cycles since the one before, times two plus its kind,
+// written seven bits at a time, then the new buttons or the frame hash
+typedef enum Movie_Record
+{
+	MOVIE_INPUT, // One byte of buttons
+	MOVIE_HASH // Eight bytes of frame_hash, low byte first
+} Movie_Record;
+
+typedef struct Movie_Header
+{
+	unsigned int magic;
+	unsigned int version;
+	unsigned char cartridge[0x4]; // Header and global checksums, then padding
+	unsigned long start; // Cycle recording started on
+	unsigned long end; // Cycle the last frame ended on
+	unsigned long size; // Bytes of records following the header
+} Movie_Header;
+
+struct Movie
+{
+	Movie_Header header;
+	unsigned int hash_interval; // Frames between hashes, 0 when replaying
+	unsigned int frames; // Since the last hash
+	unsigned long last; // Cycle of the last record
+	unsigned char buttons;
+	unsigned char *records;
+	unsigned long capacity;
+};
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  frame_hash
+ *  Description:  FNV-1a hash of the framebuffer and the cpu registers, so sessions
+ *                that draw nothing yet are still checked
+ * =====================================================================================
+ */
+	static unsigned long
+frame_hash(GB *gb)
+{
+	unsigned long hash = 0xCBF29CE484222325ul;
+	unsigned short registers[0x7];
+
+	sync_flags(gb, 0x0); // F may still owe flags
+	registers[0x0] = gb->regs.AF;
+	registers[0x1] = gb->regs.BC;
+	registers[0x2] = gb->regs.DE;
+	registers[0x3] = gb->regs.HL;
+	registers[0x4] = gb->regs.SP;
+	registers[0x5] = gb->regs.PC;
+	registers[0x6] = gb->regs.IME;
+	for (unsigned long i = 0x0; i < sizeof(gb->framebuffer); i++)
+	{
+		hash = (hash ^ gb->framebuffer[i]) * 0x100000001B3ul;
+	}
+	for (unsigned long i = 0x0; i < 0x7; i++)
+	{
+		hash = (hash ^ registers[i]) * 0x100000001B3ul;
+	}
+	return hash;
+}		/* -----  end of function frame_hash  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  cartridge_checksums
+ *  Description:  Fills in the checksums that tell cartridges apart
+ * =====================================================================================
+ */
+	static void
+cartridge_checksums(GB *gb, unsigned char *checksums)
+{
+	memset(checksums, 0x0, 0x4);
+	if (gb->cartridge != NULL)
+	{
+		memcpy(checksums, &gb->cartridge->rom[0x14D], 0x3);
+	}
+}		/* -----  end of function cartridge_checksums  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  add_record
+ *  Description:  Appends a record at the current cycle
+ *   Parameters:  data is the record's bytes after the cycle count
+ *       Return:  0 on success, -1 if out of memory
+ * =====================================================================================
+ */
+	static int
+add_record(Movie *movie, GB *gb, Movie_Record kind, const unsigned char *data,
+           unsigned long length)
+{
+	unsigned long count = (gb->clock.cycles - movie->last) * 0x2 + kind;
+	unsigned long size = movie->header.size;
+
+	if (size + length + 0x10 > movie->capacity)
+	{
+		unsigned long capacity = movie->capacity ? movie->capacity * 0x2 : 0x1000;
+		unsigned char *records = realloc(movie->records, capacity);
+
+		if (records == NULL)
+		{
+			return -1;
+		}
+		movie->records = records;
+		movie->capacity = capacity;
+	}
+	while (count >= 0x80)
+	{
+		movie->records[size++] = (unsigned char) (count | 0x80u);
+		count >>= 0x7u;
+	}
+	movie->records[size++] = (unsigned char) count;
+	memcpy(&movie->records[size], data, length);
+	movie->header.size = size + length;
+	movie->last = gb->clock.cycles;
+	return 0x0;
+}		/* -----  end of function add_record  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  mattygboy_movie_record
+ *  Description:  Starts recording an instance's input from its current state. Set
+ *                buttons through mattygboy_movie_input while recording
+ *   Parameters:  hash_interval is how many frames pass between hashes of the frame,
+ *                0 for none
+ *       Return:  The movie, NULL if out of memory
+ * =====================================================================================
+ */
+	Movie*
+mattygboy_movie_record(GB *gb, unsigned int hash_interval)
+{
+	Movie *movie = calloc(0x1, sizeof(*movie));
+
+	if (movie == NULL)
+	{
+		return NULL;
+	}
+	movie->header.magic = MOVIE_MAGIC;
+	movie->header.version = MOVIE_VERSION;
+	cartridge_checksums(gb, movie->header.cartridge);
+	movie->header.start = movie->header.end = movie->last = gb->clock.cycles;
+	movie->hash_interval = hash_interval;
+	movie->buttons = gb->buttons;
+	if (add_record(movie, gb, MOVIE_INPUT, &movie->buttons, 0x1))
+	{
+		free(movie);
+		return NULL;
+	}
+	return movie;
+}		/* -----  end of function mattygboy_movie_record  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  mattygboy_movie_input
+ *  Description:  Sets the buttons held down, like mattygboy_set_buttons, and records
+ *                the change
+ *       Return:  0 on success, -1 if out of memory, then the buttons don't change
+ * =====================================================================================
+ */
+	int
+mattygboy_movie_input(Movie *movie, GB *gb, unsigned char buttons)
+{
+	if (buttons == movie->buttons)
+	{
+		return 0x0;
+	}
+	if (add_record(movie, gb, MOVIE_INPUT, &buttons, 0x1))
+	{
+		return -1;
+	}
+	movie->buttons = buttons;
+	set_buttons(gb, buttons);
+	return 0x0;
+}		/* -----  end of function mattygboy_movie_input  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  mattygboy_movie_frame
+ *  Description:  Call after every frame while recording, hashes the frame every
+ *                hash_interval frames. The movie ends at the last frame
+ *       Return:  0 on success, -1 if out of memory
+ * =====================================================================================
+ */
+	int
+mattygboy_movie_frame(Movie *movie, GB *gb)
+{
+	unsigned long hash;
+	unsigned char bytes[0x8];
+
+	movie->header.end = gb->clock.cycles;
+	if (!movie->hash_interval || ++movie->frames < movie->hash_interval)
+	{
+		return 0x0;
+	}
+
+	hash = frame_hash(gb);
+	for (unsigned int i = 0x0; i < sizeof(bytes); i++)
+	{
+		bytes[i] = (unsigned char) (hash >> (i * 0x8u));
+	}
+	movie->frames = 0x0;
+	return add_record(movie, gb, MOVIE_HASH, bytes, sizeof(bytes));
+}		/* -----  end of function mattygboy_movie_frame  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  mattygboy_movie_save
+ *  Description:  Writes a movie to a buffer
+ *   Parameters:  buffer receives the movie, pass NULL to only get the size
+ *       Return:  The size of the movie in bytes, nothing is written when buffer is
+ *                NULL or smaller than that
+ * =====================================================================================
+ */
+	unsigned long
+mattygboy_movie_save(Movie *movie, unsigned char *buffer, unsigned long size)
+{
+	unsigned long needed = sizeof(movie->header) + movie->header.size;
+
+	if (buffer == NULL || size < needed)
+	{
+		return needed;
+	}
+	memcpy(buffer, &movie->header, sizeof(movie->header));
+	memcpy(buffer + sizeof(movie->header), movie->records, movie->header.size);
+	return needed;
+}		/* -----  end of function mattygboy_movie_save  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  mattygboy_movie_load
+ *  Description:  Reads a movie made by mattygboy_movie_save for replaying
+ *       Return:  The movie, NULL if it's damaged, from another version, or out of
+ *                memory
+ * =====================================================================================
+ */
+	Movie*
+mattygboy_movie_load(const unsigned char *buffer, unsigned long size)
+{
+	Movie *movie;
+
+	if (buffer == NULL || size < sizeof(movie->header))
+	{
+		return NULL;
+	}
+	movie = calloc(0x1, sizeof(*movie));
+	if (movie == NULL)
+	{
+		return NULL;
+	}
+	memcpy(&movie->header, buffer, sizeof(movie->header));
+	if (movie->header.magic != MOVIE_MAGIC || movie->header.version != MOVIE_VERSION ||
+	    movie->header.size > size - sizeof(movie->header) ||
+	    movie->header.end < movie->header.start)
+	{
+		free(movie);
+		return NULL;
+	}
+	movie->records = malloc(movie->header.size + 0x1);
+	if (movie->records == NULL)
+	{
+		free(movie);
+		return NULL;
+	}
+	memcpy(movie->records, buffer + sizeof(movie->header), movie->header.size);
+	movie->capacity = movie->header.size + 0x1;
+	return movie;
+}		/* -----  end of function mattygboy_movie_load  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  run_to
+ *  Description:  Runs an instance until the clock reaches a cycle
+ *       Return:  0 if it stopped right on the cycle, -1 if an instruction ran past it
+ * =====================================================================================
+ */
+	static int
+run_to(GB *gb, unsigned long cycle)
+{
+	while (gb->clock.cycles < cycle)
+	{
+		cpu_run_cycles(gb, cycle - gb->clock.cycles, -1);
+	}
+	return gb->clock.cycles == cycle ? 0x0 : -1;
+}		/* -----  end of function run_to  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  mattygboy_movie_replay
+ *  Description:  Replays a movie into an instance in the state recording started
+ *                from, like a fresh instance of the same rom, up to the movie's last
+ *                frame. Every frame hash is checked along the way
+ *       Return:  0 if the replay matched the recording, -1 if the instance isn't at
+ *                the start of the movie or the movie is damaged, otherwise the
+ *                cycle the replay first went wrong on, plus one
+ * =====================================================================================
+ */
+	long
+mattygboy_movie_replay(Movie *movie, GB *gb)
+{
+	const unsigned char *record = movie->records;
+	const unsigned char *end = movie->records + movie->header.size;
+	unsigned char checksums[0x4];
+	unsigned long cycle = movie->header.start;
+
+	cartridge_checksums(gb, checksums);
+	if (memcmp(checksums, movie->header.cartridge, sizeof(checksums)) ||
+	    gb->clock.cycles != movie->header.start)
+	{
+		return -1;
+	}
+
+	while (record < end)
+	{
+		unsigned long count = 0x0, hash = 0x0;
+		unsigned int shift = 0x0;
+
+		do
+		{
+			count |= (unsigned long) (*record & 0x7Fu) << shift;
+			shift += 0x7;
+		} while (*record++ & 0x80u && record < end);
+		cycle += count >> 0x1u;
+		if ((count & 0x1u ? 0x8 : 0x1) > end - record)
+		{
+			return -1;
+		}
+		if (run_to(gb, cycle))
+		{
+			return (long) gb->clock.cycles + 0x1;
+		}
+
+		if ((count & 0x1u) == MOVIE_INPUT)
+		{
+			set_buttons(gb, *record++);
+			continue;
+		}
+		for (unsigned int i = 0x0; i < 0x8; i++)
+		{
+			hash |= (unsigned long) *record++ << (i * 0x8u);
+		}
+		if (frame_hash(gb) != hash)
+		{
+			return (long) cycle + 0x1;
+		}
+	}
+	if (run_to(gb, movie->header.end))
+	{
+		return (long) gb->clock.cycles + 0x1;
+	}
+	return 0x0;
+}		/* -----  end of function mattygboy_movie_replay  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  mattygboy_movie_free
+ *  Description:  Releases a movie
+ * =====================================================================================
+ */
+	void
+mattygboy_movie_free(Movie *movie)
+{
+	if (movie == NULL)
+	{
+		return;
+	}
+	free(movie->records);
+	free(movie);
+}		/* -----  end of function mattygboy_movie_free  ----- */
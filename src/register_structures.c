@@ -17,83 +17,25 @@
  * =====================================================================================
  */
 
-#include <stdlib.h>
 #include "register_structures.h"
 
 /*
  * ===  FUNCTION  ======================================================================
  *         Name:  init_registers
- *  Description:  Initializes the virtual registers
- *   Parameters:  init_values a pointer to the beginning of an int array
- *   		  containing 7 values, which will be assigned as the 
- *   		  initializing value of each register in alphabetical order
- *       Return:  Pointer to the struct containing the virtual registers
+ *  Description:  Initializes the virtual registers to their state after the boot ROM
+ *   Parameters:  r is the register file to initialize
  * =====================================================================================
  */
-	Registers*
-init_registers()
+	void
+init_registers(Registers *r)
 {
-	Registers *reg_ptr = malloc(sizeof(*reg_ptr));
-	if (reg_ptr == NULL) 
-	{
-		return NULL;
-	}
-
-	// Initialize registers
-	reg_ptr->A = 0x01u;
-	reg_ptr->B = 0x00u;
-	reg_ptr->C = 0x13u;
-	reg_ptr->D = 0x00u;
-	reg_ptr->E = 0xD8u;
-	reg_ptr->H = 0x01u;
-	reg_ptr->L = 0x4Du;
-
-	return reg_ptr;
-}		/* -----  end of function init_registers  ----- */
-
-/*
- * ===  FUNCTION  ======================================================================
- *         Name:  init_pointers
- *  Description:  Initializes the virtual stack pointer and program counter
- *       Return:  Pointer to the struct containing the virtual registers
- * =====================================================================================
- */
-	Pointers*
-init_pointers() 
-{
-	Pointers *ptrs_ptr = malloc(sizeof(*ptrs_ptr));
-	if (ptrs_ptr == NULL) 
-	{
-		return NULL;
-	}
+	// Initialize registers, F has Z, H, and C set
+	r->AF = 0x01B0u;
+	r->BC = 0x0013u;
+	r->DE = 0x00D8u;
+	r->HL = 0x014Du;
 	// Program counter starts at 0x100, stack at 0xFFFE
-	ptrs_ptr->PC = 0x0100u;
-	ptrs_ptr->SP = 0xFFFEu;
-
-	return ptrs_ptr;
-}		/* -----  end of function init_pointers  ----- */
-
-/*
- * ===  FUNCTION  ======================================================================
- *         Name:  init_flags
- *  Description:  Initializes the flags used by CPU
- *       Return:  Pointer to the struct containing the flags
- * =====================================================================================
- */
-	CPU_Flags*
-init_flags ()
-{
-	CPU_Flags *flags_ptr = malloc(sizeof(*flags_ptr));
-	if (flags_ptr == NULL)
-	{
-		return NULL;
-	}
-
-	flags_ptr->Z = 0x1u;
-	flags_ptr->N = 0x0u;
-	flags_ptr->H = 0x1u;
-	flags_ptr->C = 0x1u;
-	flags_ptr->IME = 0x0u;
-
-	return flags_ptr;
-}		/* -----  end of function init_flags  ----- */
+	r->PC = 0x0100u;
+	r->SP = 0xFFFEu;
+	r->IME = 0x0u;
+}		/* -----  end of function init_registers  ----- */
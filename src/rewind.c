@@ -0,0 +1,463 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  rewind.c
+ *
+ *    Description:  Rewind buffer, a fixed amount of memory holding the states saved
+ *                  every few frames. Every REWIND_KEYFRAME_INTERVAL entries a state is
+ *                  kept whole, the entries between only keep the bytes that changed
+ *                  since the one before, XORed with it and run length encoded. When
+ *                  the buffer fills up the oldest keyframe goes along with the deltas
+ *                  that need it
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026 01:12:40
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Matt Gercz (matt.gercz@icloud.com)
+ *
+ * =====================================================================================
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "mattygboy.h"
+
+#define REWIND_KEYFRAME_INTERVAL 0x20 // Bounds the deltas applied to reach any entry
+#define REWIND_MIN_RUN 0x8 // Shorter runs of unchanged bytes are kept as literals
+
+typedef struct Rewind_Entry
+{
+	unsigned long offset; // Into data
+	unsigned long length; // Encoded bytes
+	unsigned long state_size;
+	unsigned char keyframe; // Encoded against zeros rather than the entry before
+} Rewind_Entry;
+
+struct Rewind
+{
+	unsigned int frames_per_entry;
+	unsigned int frames; // Since the newest entry was recorded
+
+	// Encoded entries, oldest to newest, wrapping around the end of data
+	unsigned char *data;
+	unsigned long capacity;
+	Rewind_Entry *entries; // Ring of max_entries, first is the oldest
+	unsigned int max_entries;
+	unsigned int first;
+	unsigned int count;
+	unsigned int since_keyframe; // Entries recorded after the newest keyframe
+
+	// The newest entry's state is kept whole to encode the next one against
+	unsigned char *last;
+	unsigned long last_size;
+	unsigned char *state; // Scratch for a state being saved or rebuilt
+	unsigned char *encoded;
+	unsigned long buffer_size; // Of last, state, and encoded
+};
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  write_count
+ *  Description:  Writes a count seven bits at a time, low bits first
+ *       Return:  Where the next byte goes
+ * =====================================================================================
+ */
+	static unsigned char*
+write_count(unsigned char *out, unsigned long count)
+{
+	while (count >= 0x80)
+	{
+		*out++ = (unsigned char) (count | 0x80u);
+		count >>= 0x7u;
+	}
+	*out++ = (unsigned char) count;
+	return out;
+}		/* -----  end of function write_count  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  read_count
+ *  Description:  Reads a count written by write_count
+ *       Return:  Where the next byte is
+ * =====================================================================================
+ */
+	static const unsigned char*
+read_count(const unsigned char *in, unsigned long *count)
+{
+	unsigned int shift = 0x0;
+
+	*count = 0x0;
+	do
+	{
+		*count |= (unsigned long) (*in & 0x7Fu) << shift;
+		shift += 0x7;
+	} while (*in++ & 0x80u);
+	return in;
+}		/* -----  end of function read_count  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  delta_byte
+ *  Description:  Returns a byte of state XOR base, bytes past the end of either
+ *                count as zero
+ * =====================================================================================
+ */
+	static inline unsigned char
+delta_byte(const unsigned char *state, unsigned long size, const unsigned char *base,
+           unsigned long base_size, unsigned long i)
+{
+	return (unsigned char) ((i < size ? state[i] : 0x0) ^ (i < base_size ? base[i] : 0x0));
+}		/* -----  end of function delta_byte  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  encode_delta
+ *  Description:  Encodes state XOR base as pairs of a run of unchanged bytes and a
+ *                run of changed ones followed by those bytes. Covers the longer of
+ *                the two, so applying it also clears what's left of a longer base
+ *   Parameters:  base_size is 0 to encode against zeros
+ *                out has room for twice the longer size plus 0x20 bytes
+ *       Return:  The encoded length
+ * =====================================================================================
+ */
+	static unsigned long
+encode_delta(const unsigned char *state, unsigned long size, const unsigned char *base,
+             unsigned long base_size, unsigned char *out)
+{
+	unsigned char *start = out;
+	unsigned long end = size > base_size ? size : base_size;
+	unsigned long both = size < base_size ? size : base_size;
+	unsigned long i = 0x0;
+
+	while (i < end)
+	{
+		unsigned long same = i, changed, zeros = 0x0;
+
+		// Most of a state is the same from one entry to the next, skip it a word at a time
+		while (i + sizeof(unsigned long) <= both && !memcmp(state + i, base + i, sizeof(unsigned long)))
+		{
+			i += sizeof(unsigned long);
+		}
+		while (i < end && !delta_byte(state, size, base, base_size, i))
+		{
+			i++;
+		}
+		same = i - same;
+
+		// Changed bytes run on until enough unchanged ones in a row turn up
+		for (changed = i; i < end && zeros < REWIND_MIN_RUN; i++)
+		{
+			zeros = delta_byte(state, size, base, base_size, i) ? 0x0 : zeros + 0x1;
+		}
+		i -= zeros;
+
+		out = write_count(out, same);
+		out = write_count(out, i - changed);
+		for (; changed < i; changed++)
+		{
+			*out++ = delta_byte(state, size, base, base_size, changed);
+		}
+	}
+	return (unsigned long) (out - start);
+}		/* -----  end of function encode_delta  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  apply_delta
+ *  Description:  XORs an encoded delta into a state
+ * =====================================================================================
+ */
+	static void
+apply_delta(unsigned char *state, const unsigned char *in, unsigned long length)
+{
+	const unsigned char *end = in + length;
+	unsigned long i = 0x0;
+
+	while (in < end)
+	{
+		unsigned long same, changed;
+
+		in = read_count(in, &same);
+		in = read_count(in, &changed);
+		i += same;
+		for (; changed; changed--)
+		{
+			state[i++] ^= *in++;
+		}
+	}
+}		/* -----  end of function apply_delta  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  entry
+ *  Description:  Returns an entry counting from the oldest
+ * =====================================================================================
+ */
+	static Rewind_Entry*
+entry(Rewind *rewind, unsigned int index)
+{
+	return &rewind->entries[(rewind->first + index) % rewind->max_entries];
+}		/* -----  end of function entry  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  drop_oldest
+ *  Description:  Drops the oldest keyframe and the deltas recorded after it
+ * =====================================================================================
+ */
+	static void
+drop_oldest(Rewind *rewind)
+{
+	do
+	{
+		rewind->first = (rewind->first + 0x1) % rewind->max_entries;
+		rewind->count--;
+	} while (rewind->count && !entry(rewind, 0x0)->keyframe);
+}		/* -----  end of function drop_oldest  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  reserve
+ *  Description:  Finds room for an entry after the newest without wrapping it
+ *       Return:  Offset into data, -1 if there isn't room until older entries go
+ * =====================================================================================
+ */
+	static long
+reserve(Rewind *rewind, unsigned long length)
+{
+	unsigned long start, end;
+
+	if (rewind->count == rewind->max_entries)
+	{
+		return -1;
+	}
+	if (!rewind->count)
+	{
+		return length <= rewind->capacity ? 0x0 : -1;
+	}
+	start = entry(rewind, 0x0)->offset;
+	end = entry(rewind, rewind->count - 0x1)->offset + entry(rewind, rewind->count - 0x1)->length;
+	if (end > start)
+	{
+		if (rewind->capacity - end >= length)
+		{
+			return (long) end;
+		}
+		return start >= length ? 0x0 : -1;
+	}
+	return start - end >= length ? (long) end : -1;
+}		/* -----  end of function reserve  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  grow_buffers
+ *  Description:  Makes room for states of a size in the working buffers
+ *       Return:  0 on success, -1 if out of memory
+ * =====================================================================================
+ */
+	static int
+grow_buffers(Rewind *rewind, unsigned long size)
+{
+	unsigned char *last, *state, *encoded;
+
+	if (size <= rewind->buffer_size)
+	{
+		return 0x0;
+	}
+	last = realloc(rewind->last, size);
+	if (last != NULL)
+	{
+		rewind->last = last;
+	}
+	state = realloc(rewind->state, size);
+	if (state != NULL)
+	{
+		rewind->state = state;
+	}
+	encoded = realloc(rewind->encoded, size * 0x2 + 0x20);
+	if (encoded != NULL)
+	{
+		rewind->encoded = encoded;
+	}
+	if (last == NULL || state == NULL || encoded == NULL)
+	{
+		return -1;
+	}
+	rewind->buffer_size = size;
+	return 0x0;
+}		/* -----  end of function grow_buffers  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  mattygboy_rewind_create
+ *  Description:  Creates a rewind buffer. Memory use stays at about buffer_size
+ *                plus three saved states however long it records
+ *   Parameters:  buffer_size is the bytes kept for encoded states, about 0x100000
+ *                holds a minute at one state every frame for most games
+ *                frames_per_entry is how many frames pass between saved states,
+ *                and how finely a rewind can pick where it ends up
+ *       Return:  The rewind buffer, NULL if out of memory or an argument is 0
+ * =====================================================================================
+ */
+	Rewind*
+mattygboy_rewind_create(unsigned long buffer_size, unsigned int frames_per_entry)
+{
+	Rewind *rewind;
+
+	if (!buffer_size || !frames_per_entry)
+	{
+		return NULL;
+	}
+	rewind = calloc(0x1, sizeof(*rewind));
+	if (rewind == NULL)
+	{
+		return NULL;
+	}
+	rewind->frames_per_entry = frames_per_entry;
+	rewind->capacity = buffer_size;
+	rewind->max_entries = (unsigned int) (buffer_size / 0x100 + 0x2);
+	rewind->data = malloc(buffer_size);
+	rewind->entries = malloc(rewind->max_entries * sizeof(*rewind->entries));
+	if (rewind->data == NULL || rewind->entries == NULL)
+	{
+		mattygboy_rewind_free(rewind);
+		return NULL;
+	}
+	return rewind;
+}		/* -----  end of function mattygboy_rewind_create  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  mattygboy_rewind_free
+ *  Description:  Releases a rewind buffer
+ * =====================================================================================
+ */
+	void
+mattygboy_rewind_free(Rewind *rewind)
+{
+	if (rewind == NULL)
+	{
+		return;
+	}
+	free(rewind->data);
+	free(rewind->entries);
+	free(rewind->last);
+	free(rewind->state);
+	free(rewind->encoded);
+	free(rewind);
+}		/* -----  end of function mattygboy_rewind_free  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  mattygboy_rewind_record
+ *  Description:  Call once after every frame, saves the state every
+ *                frames_per_entry frames. The first call always saves
+ *       Return:  0 on success, -1 if the state didn't fit in the buffer or out of
+ *                memory, the buffer is left as it was
+ * =====================================================================================
+ */
+	int
+mattygboy_rewind_record(Rewind *rewind, GB *gb)
+{
+	unsigned long size, length;
+	unsigned char keyframe;
+	unsigned char *swap;
+	long offset;
+
+	if (rewind->count && ++rewind->frames < rewind->frames_per_entry)
+	{
+		return 0x0;
+	}
+	size = mattygboy_save_state(gb, NULL, 0x0);
+	if (grow_buffers(rewind, size))
+	{
+		return -1;
+	}
+	mattygboy_save_state(gb, rewind->state, size);
+
+	keyframe = !rewind->count || rewind->since_keyframe + 0x1 >= REWIND_KEYFRAME_INTERVAL;
+	length = encode_delta(rewind->state, size, rewind->last, keyframe ? 0x0 : rewind->last_size,
+	                      rewind->encoded);
+	if (length > rewind->capacity)
+	{
+		return -1;
+	}
+	while ((offset = reserve(rewind, length)) < 0x0)
+	{
+		if (!rewind->count)
+		{
+			return -1;
+		}
+		drop_oldest(rewind);
+		if (!rewind->count && !keyframe) // The delta's base went with it
+		{
+			keyframe = 0x1;
+			length = encode_delta(rewind->state, size, NULL, 0x0, rewind->encoded);
+		}
+	}
+
+	memcpy(rewind->data + offset, rewind->encoded, length);
+	*entry(rewind, rewind->count++) = (Rewind_Entry) {(unsigned long) offset, length, size, keyframe};
+	rewind->since_keyframe = keyframe ? 0x0 : rewind->since_keyframe + 0x1;
+	rewind->frames = 0x0;
+	swap = rewind->last;
+	rewind->last = rewind->state;
+	rewind->state = swap;
+	rewind->last_size = size;
+	return 0x0;
+}		/* -----  end of function mattygboy_rewind_record  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  mattygboy_rewind
+ *  Description:  Takes an instance back to the newest saved state at least a number
+ *                of frames old, or the oldest one kept. Entries newer than that are
+ *                dropped, so rewinding again goes further back
+ *   Parameters:  frames is how far back to go
+ *       Return:  The number of frames the instance went back, -1 if nothing is
+ *                saved or the state can't be loaded
+ * =====================================================================================
+ */
+	long
+mattygboy_rewind(Rewind *rewind, GB *gb, unsigned long frames)
+{
+	unsigned long back = 0x0;
+	unsigned int target, keyframe;
+
+	if (!rewind->count)
+	{
+		return -1;
+	}
+	if (frames > rewind->frames)
+	{
+		back = (frames - rewind->frames + rewind->frames_per_entry - 0x1) / rewind->frames_per_entry;
+	}
+	target = back < rewind->count ? rewind->count - 0x1 - (unsigned int) back : 0x0;
+	back = rewind->count - 0x1 - target;
+
+	// Rebuild the target from the keyframe at or before it
+	for (keyframe = target; !entry(rewind, keyframe)->keyframe; keyframe--)
+	{
+	}
+	if (target != rewind->count - 0x1)
+	{
+		memset(rewind->state, 0x0, rewind->buffer_size);
+		for (unsigned int i = keyframe; i <= target; i++)
+		{
+			apply_delta(rewind->state, rewind->data + entry(rewind, i)->offset, entry(rewind, i)->length);
+		}
+		memcpy(rewind->last, rewind->state, entry(rewind, target)->state_size);
+		rewind->last_size = entry(rewind, target)->state_size;
+	}
+	if (mattygboy_load_state(gb, rewind->last, rewind->last_size))
+	{
+		return -1;
+	}
+
+	back = back * rewind->frames_per_entry + rewind->frames;
+	rewind->count = target + 0x1;
+	rewind->since_keyframe = target - keyframe;
+	rewind->frames = 0x0;
+	return (long) back;
+}		/* -----  end of function mattygboy_rewind  ----- */
@@ -0,0 +1,471 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  rom_runner.c
+ *
+ *    Description:  Runs many test roms at once, each in its own emulator instance on
+ *                  a pool of worker threads, and writes one JSON report of how each
+ *                  of them finished
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 23:04:19
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Matt Gercz (matt.gercz@icloud.com)
+ *
+ * =====================================================================================
+ */
+#include <dirent.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "mattygboy.h"
+#include "runner.h"
+
+#define DEFAULT_MAX_FRAMES 0x1C20 // Two minutes of emulated time
+
+typedef struct Rom_Job
+{
+	const char *path;
+	int loaded; // 0 if the rom couldn't be read
+	Run_Result result;
+	char *report; // JSON object for the rom, written by the worker that ran it
+} Rom_Job;
+
+// Each worker takes jobs from the back of its own deque and steals from the
+// front of the others' once it runs dry. Nothing is queued after the start,
+// so every deque being empty means the work is done
+typedef struct Work_Deque
+{
+	pthread_mutex_t lock;
+	unsigned long *jobs;
+	unsigned long front;
+	unsigned long back; // One past the last job
+} Work_Deque;
+
+typedef struct Runner
+{
+	Rom_Job *jobs;
+	Work_Deque *deques;
+	unsigned int workers;
+	const Run_Options *options;
+	const char *boot_rom_file; // NULL to skip booting
+} Runner;
+
+typedef struct Worker
+{
+	Runner *runner;
+	unsigned int id;
+	pthread_t thread;
+} Worker;
+
+typedef struct Rom_List
+{
+	char **paths;
+	unsigned long count;
+	unsigned long capacity;
+} Rom_List;
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  add_rom
+ *  Description:  Appends a copy of a path to a rom list
+ *       Return:  0 on success, -1 if out of memory
+ * =====================================================================================
+ */
+	static int
+add_rom(Rom_List *list, const char *path)
+{
+	if (list->count == list->capacity)
+	{
+		unsigned long capacity = list->capacity ? list->capacity * 0x2 : 0x40;
+		char **paths = realloc(list->paths, capacity * sizeof(*paths));
+
+		if (paths == NULL)
+		{
+			return -1;
+		}
+		list->paths = paths;
+		list->capacity = capacity;
+	}
+	list->paths[list->count] = strdup(path);
+	return list->paths[list->count++] != NULL ? 0x0 : -1;
+}		/* -----  end of function add_rom  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  compare_paths
+ *  Description:  Orders paths for qsort so directory listings come out the same
+ *                on every machine
+ * =====================================================================================
+ */
+	static int
+compare_paths(const void *a, const void *b)
+{
+	return strcmp(*(char * const *) a, *(char * const *) b);
+}		/* -----  end of function compare_paths  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  add_directory
+ *  Description:  Appends every .gb and .gbc file in a directory to a rom list, in
+ *                name order
+ *       Return:  0 on success, -1 if the directory can't be read
+ * =====================================================================================
+ */
+	static int
+add_directory(Rom_List *list, const char *directory)
+{
+	DIR *dir = opendir(directory);
+	unsigned long first = list->count;
+	struct dirent *entry;
+
+	if (dir == NULL)
+	{
+		return -1;
+	}
+	while ((entry = readdir(dir)) != NULL)
+	{
+		char *extension = strrchr(entry->d_name, '.');
+		char path[PATH_MAX];
+
+		if (extension == NULL || (strcmp(extension, ".gb") && strcmp(extension, ".gbc")))
+		{
+			continue;
+		}
+		snprintf(path, sizeof(path), "%s/%s", directory, entry->d_name);
+		if (add_rom(list, path))
+		{
+			closedir(dir);
+			return -1;
+		}
+	}
+	closedir(dir);
+	qsort(list->paths + first, list->count - first, sizeof(*list->paths), compare_paths);
+	return 0x0;
+}		/* -----  end of function add_directory  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  take_job
+ *  Description:  Takes the next job for a worker, from the back of its own deque or
+ *                else from the front of another worker's
+ *       Return:  The index of the job, -1 when there's no work left anywhere
+ * =====================================================================================
+ */
+	static long
+take_job(Runner *runner, unsigned int id)
+{
+	for (unsigned int i = 0; i < runner->workers; i++)
+	{
+		Work_Deque *deque = &runner->deques[(id + i) % runner->workers];
+		long job = -1;
+
+		pthread_mutex_lock(&deque->lock);
+		if (deque->front < deque->back)
+		{
+			job = (long) (i == 0 ? deque->jobs[--deque->back] : deque->jobs[deque->front++]);
+		}
+		pthread_mutex_unlock(&deque->lock);
+		if (job >= 0)
+		{
+			return job;
+		}
+	}
+	return -1;
+}		/* -----  end of function take_job  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  run_job
+ *  Description:  Runs one rom in a fresh instance and keeps its JSON report, a
+ *                boot ROM that can't be read leaves the rom marked unreadable
+ * =====================================================================================
+ */
+	static void
+run_job(Rom_Job *job, const Runner *runner)
+{
+	GB *gb = mattygboy_open(job->path);
+	size_t report_size;
+	FILE *report;
+
+	if (gb == NULL)
+	{
+		return;
+	}
+	if (runner->boot_rom_file != NULL && mattygboy_reset(gb, runner->boot_rom_file))
+	{
+		mattygboy_destroy(gb);
+		return;
+	}
+	job->loaded = 0x1;
+	job->result = run_headless(gb, runner->options);
+	report = open_memstream(&job->report, &report_size);
+	if (report != NULL)
+	{
+		print_run_json(report, job->path, gb, &job->result);
+		fclose(report);
+	}
+	free_run_result(&job->result);
+	mattygboy_destroy(gb);
+}		/* -----  end of function run_job  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  worker_main
+ *  Description:  Runs jobs until every deque is empty
+ * =====================================================================================
+ */
+	static void*
+worker_main(void *argument)
+{
+	Worker *worker = argument;
+	long job;
+
+	while ((job = take_job(worker->runner, worker->id)) >= 0)
+	{
+		run_job(&worker->runner->jobs[job], worker->runner);
+	}
+	return NULL;
+}		/* -----  end of function worker_main  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  run_all
+ *  Description:  Deals the jobs out round robin to a deque per worker and runs them
+ *                on that many threads, or on this one if threads can't be started
+ *       Return:  0 on success, -1 if out of memory
+ * =====================================================================================
+ */
+	static int
+run_all(Rom_Job *jobs, unsigned long count, unsigned int workers, const Run_Options *options,
+        const char *boot_rom_file)
+{
+	Runner runner = {jobs, calloc(workers, sizeof(Work_Deque)), workers, options, boot_rom_file};
+	Worker *pool = calloc(workers, sizeof(Worker));
+	unsigned int started = 0;
+	unsigned int ready = 0; // Deques with a lock and a job array
+	int status = -1;
+
+	if (runner.deques == NULL || pool == NULL)
+	{
+		goto cleanup;
+	}
+	for (; ready < workers; ready++)
+	{
+		pthread_mutex_init(&runner.deques[ready].lock, NULL);
+		runner.deques[ready].jobs = malloc((count / workers + 0x1) * sizeof(unsigned long));
+		if (runner.deques[ready].jobs == NULL)
+		{
+			pthread_mutex_destroy(&runner.deques[ready].lock);
+			goto cleanup;
+		}
+	}
+	for (unsigned long job = 0; job < count; job++)
+	{
+		Work_Deque *deque = &runner.deques[job % workers];
+
+		deque->jobs[deque->back++] = job;
+	}
+
+	for (unsigned int i = 0; i < workers; i++)
+	{
+		pool[i] = (Worker) {&runner, i, 0x0};
+		if (pthread_create(&pool[i].thread, NULL, worker_main, &pool[i]))
+		{
+			break;
+		}
+		started++;
+	}
+	if (!started) // Threads are out, every deque is still full
+	{
+		pool[0] = (Worker) {&runner, 0x0, 0x0};
+		worker_main(&pool[0]);
+	}
+	for (unsigned int i = 0; i < started; i++)
+	{
+		pthread_join(pool[i].thread, NULL);
+	}
+	status = 0x0;
+
+cleanup:
+	for (unsigned int i = 0; i < ready; i++)
+	{
+		pthread_mutex_destroy(&runner.deques[i].lock);
+		free(runner.deques[i].jobs);
+	}
+	free(runner.deques);
+	free(pool);
+	return status;
+}		/* -----  end of function run_all  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  write_report
+ *  Description:  Writes the JSON report: totals by outcome, then one object per rom
+ *                in the order they were given
+ * =====================================================================================
+ */
+	static void
+write_report(FILE *out, const Rom_Job *jobs, unsigned long count, unsigned int workers,
+             double seconds)
+{
+	unsigned long totals[RUN_LOCKED_UP + 0x1] = {0x0};
+	unsigned long errors = 0x0;
+
+	for (unsigned long i = 0; i < count; i++)
+	{
+		if (jobs[i].loaded)
+		{
+			totals[jobs[i].result.outcome]++;
+		}
+		else
+		{
+			errors++;
+		}
+	}
+	fprintf(out, "{\"threads\": %u, \"wall_seconds\": %.6f, \"passed\": %lu, \"failed\": %lu, "
+	        "\"limit\": %lu, \"stuck\": %lu, \"locked_up\": %lu, \"errors\": %lu, \"roms\": [",
+	        workers, seconds, totals[RUN_PASSED], totals[RUN_FAILED], totals[RUN_LIMIT],
+	        totals[RUN_STUCK], totals[RUN_LOCKED_UP], errors);
+	for (unsigned long i = 0; i < count; i++)
+	{
+		fputs(i ? ",\n  " : "\n  ", out);
+		if (jobs[i].report != NULL)
+		{
+			fputs(jobs[i].report, out);
+		}
+		else
+		{
+			fputs("{\"rom\": ", out);
+			print_json_bytes(out, (const unsigned char *) jobs[i].path, strlen(jobs[i].path));
+			fputs(", \"outcome\": \"error\"}", out);
+		}
+	}
+	fputs("\n]}\n", out);
+	fprintf(stderr, "%lu roms on %u threads in %.3f s: %lu passed, %lu failed, %lu out of time, "
+	        "%lu stuck, %lu on illegal opcodes, %lu unreadable\n", count, workers, seconds,
+	        totals[RUN_PASSED], totals[RUN_FAILED], totals[RUN_LIMIT], totals[RUN_STUCK],
+	        totals[RUN_LOCKED_UP], errors);
+}		/* -----  end of function write_report  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  usage
+ *  Description:  Prints the command line options
+ * =====================================================================================
+ */
+	static void
+usage(const char *program)
+{
+	fprintf(stderr, "usage: %s [options] rom.gb|directory ...\n"
+	        "  -t threads  worker threads, defaults to the number of cores\n"
+	        "  -b file     run this 256 byte boot ROM before each rom\n"
+	        "  -c cycles   give each rom at most this many clock cycles\n"
+	        "  -f frames   give each rom at most this many frames, default %d\n"
+	        "  -s string   pass a rom when it sends this over serial, default Passed\n"
+	        "  -x string   fail a rom when it sends this over serial, default Failed\n"
+	        "  -o file     write the report to file instead of stdout\n"
+	        "exit status: 0 if every rom passed, %d otherwise\n",
+	        program, DEFAULT_MAX_FRAMES, RUN_FAILED);
+}		/* -----  end of function usage  ----- */
+
+int main(int argc, char **argv)
+{
+	Run_Options options = {ULONG_MAX, DEFAULT_MAX_FRAMES, -1, "Passed", "Failed", 0x1};
+	long workers = sysconf(_SC_NPROCESSORS_ONLN);
+	const char *report_file = NULL;
+	const char *boot_rom_file = NULL;
+	Rom_List list = {NULL, 0x0, 0x0};
+	Rom_Job *jobs;
+	struct timespec start, end;
+	FILE *report = stdout;
+	int all_passed = 0x1;
+	int option;
+
+	while ((option = getopt(argc, argv, "t:b:c:f:s:x:o:")) != -1)
+	{
+		switch (option)
+		{
+			case 't': workers = strtol(optarg, NULL, 0); break;
+			case 'b': boot_rom_file = optarg; break;
+			case 'c': options.max_cycles = strtoul(optarg, NULL, 0); break;
+			case 'f': options.max_frames = strtoul(optarg, NULL, 0); break;
+			case 's': options.pass_string = optarg; break;
+			case 'x': options.fail_string = optarg; break;
+			case 'o': report_file = optarg; break;
+			default:
+				usage(argv[0]);
+				return EXIT_FAILURE;
+		}
+	}
+	for (int i = optind; i < argc; i++)
+	{
+		struct stat info;
+		int failed = stat(argv[i], &info) == 0 && S_ISDIR(info.st_mode) ?
+		             add_directory(&list, argv[i]) : add_rom(&list, argv[i]);
+
+		if (failed)
+		{
+			fprintf(stderr, "can't read %s\n", argv[i]);
+			return EXIT_FAILURE;
+		}
+	}
+	if (!list.count)
+	{
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+	if (report_file != NULL && (report = fopen(report_file, "w")) == NULL)
+	{
+		fprintf(stderr, "can't write %s\n", report_file);
+		return EXIT_FAILURE;
+	}
+	if (workers < 0x1)
+	{
+		workers = 0x1;
+	}
+	if ((unsigned long) workers > list.count)
+	{
+		workers = (long) list.count;
+	}
+
+	jobs = calloc(list.count, sizeof(Rom_Job));
+	if (jobs == NULL)
+	{
+		return EXIT_FAILURE;
+	}
+	for (unsigned long i = 0; i < list.count; i++)
+	{
+		jobs[i].path = list.paths[i];
+	}
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	if (run_all(jobs, list.count, (unsigned int) workers, &options, boot_rom_file))
+	{
+		fprintf(stderr, "out of memory\n");
+		return EXIT_FAILURE;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	write_report(report, jobs, list.count, (unsigned int) workers,
+	             (double) (end.tv_sec - start.tv_sec) + (double) (end.tv_nsec - start.tv_nsec) / 1e9);
+
+	for (unsigned long i = 0; i < list.count; i++)
+	{
+		all_passed &= jobs[i].loaded && jobs[i].result.outcome == RUN_PASSED;
+		free(jobs[i].report);
+		free(list.paths[i]);
+	}
+	free(jobs);
+	free(list.paths);
+	if (report != stdout)
+	{
+		fclose(report);
+	}
+	return all_passed ? EXIT_SUCCESS : RUN_FAILED;
+}
@@ -0,0 +1,237 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  runner.c
+ *
+ *    Description:  Runs a rom without a screen a frame at a time until a stop
+ *                  condition is met, and reports the result as JSON
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 23:04:19
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Matt Gercz (matt.gercz@icloud.com)
+ *
+ * =====================================================================================
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "mattygboy.h"
+#include "global_declarations.h"
+#include "runner.h"
+
+#define CLOCK_SPEED 4194304.0 // Cycles per second on real hardware
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  collect_serial
+ *  Description:  Drains an instance's serial output onto the end of a result's log,
+ *                dropping the older half of the log whenever it fills
+ *   Parameters:  from is an offset into the log, moved back by the bytes dropped
+ *       Return:  from after any bytes were dropped
+ * =====================================================================================
+ */
+	static unsigned long
+collect_serial(GB *gb, Run_Result *result, unsigned long from)
+{
+	if (result->serial == NULL)
+	{
+		return from;
+	}
+	for (;;)
+	{
+		if (result->serial_length == SERIAL_LOG_LIMIT)
+		{
+			unsigned long dropped = SERIAL_LOG_LIMIT / 0x2;
+
+			memmove(result->serial, result->serial + dropped, SERIAL_LOG_LIMIT - dropped);
+			result->serial_length -= dropped;
+			from = from > dropped ? from - dropped : 0x0;
+		}
+		result->serial_length += mattygboy_drain_serial(gb, result->serial + result->serial_length,
+		                                                SERIAL_LOG_LIMIT - result->serial_length);
+		if (result->serial_length < SERIAL_LOG_LIMIT)
+		{
+			return from;
+		}
+	}
+}		/* -----  end of function collect_serial  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  serial_contains
+ *  Description:  Searches a result's serial log for a string
+ *   Parameters:  from is where the new output starts, only matches that end in it
+ *                are looked for since older ones were looked for already
+ *       Return:  Nonzero if the string was found
+ * =====================================================================================
+ */
+	static int
+serial_contains(const Run_Result *result, const char *string, unsigned long from)
+{
+	unsigned long string_length = strlen(string);
+	unsigned long i = from >= string_length ? from - string_length + 0x1 : 0x0;
+
+	for (; i + string_length <= result->serial_length; i++)
+	{
+		if (!memcmp(result->serial + i, string, string_length))
+		{
+			return 0x1;
+		}
+	}
+	return 0x0;
+}		/* -----  end of function serial_contains  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  run_headless
+ *  Description:  Runs a frame at a time until one of the stop conditions is met,
+ *                collecting serial output after each. The last frame is cut short
+ *                to land exactly on max_cycles
+ *       Return:  Why the run stopped, how long it ran, how long that took, and
+ *                what it sent over serial
+ * =====================================================================================
+ */
+	Run_Result
+run_headless(GB *gb, const Run_Options *options)
+{
+	Run_Result result = {RUN_LIMIT, 0x0, 0x0, 0.0, malloc(SERIAL_LOG_LIMIT), 0x0};
+	struct timespec start, end;
+
+	mattygboy_set_breakpoint(gb, options->stop_pc);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	while (result.cycles < options->max_cycles && result.frames < options->max_frames)
+	{
+		unsigned long to_frame = mattygboy_cycles_to_frame(gb);
+		unsigned long step = to_frame;
+
+		if (step > options->max_cycles - result.cycles)
+		{
+			step = options->max_cycles - result.cycles;
+		}
+		unsigned long ran = mattygboy_run_cycles(gb, step);
+		unsigned long new_serial = collect_serial(gb, &result, result.serial_length);
+		result.cycles += ran;
+		result.frames += ran >= to_frame;
+
+		if (mattygboy_at_breakpoint(gb) ||
+		    (options->pass_string != NULL && serial_contains(&result, options->pass_string, new_serial)))
+		{
+			result.outcome = RUN_PASSED;
+			break;
+		}
+		if (options->fail_string != NULL && serial_contains(&result, options->fail_string, new_serial))
+		{
+			result.outcome = RUN_FAILED;
+			break;
+		}
+		if (mattygboy_is_locked_up(gb)) // Nothing more will run
+		{
+			result.outcome = RUN_LOCKED_UP;
+			break;
+		}
+		if (options->stop_when_stuck && mattygboy_is_stuck(gb))
+		{
+			result.outcome = RUN_STUCK;
+			break;
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	result.seconds = (double) (end.tv_sec - start.tv_sec) +
+	                 (double) (end.tv_nsec - start.tv_nsec) / 1e9;
+	return result;
+}		/* -----  end of function run_headless  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  free_run_result
+ *  Description:  Frees the serial log of a result
+ * =====================================================================================
+ */
+	void
+free_run_result(Run_Result *result)
+{
+	free(result->serial);
+	result->serial = NULL;
+	result->serial_length = 0x0;
+}		/* -----  end of function free_run_result  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  run_outcome_name
+ *  Description:  Returns the name of an outcome used in reports
+ * =====================================================================================
+ */
+	const char*
+run_outcome_name(Run_Outcome outcome)
+{
+	switch (outcome)
+	{
+		case RUN_PASSED: return "passed";
+		case RUN_FAILED: return "failed";
+		case RUN_LIMIT: return "limit";
+		case RUN_STUCK: return "stuck";
+		case RUN_LOCKED_UP: return "locked_up";
+		default: return "unknown";
+	}
+}		/* -----  end of function run_outcome_name  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  print_json_bytes
+ *  Description:  Prints bytes as a quoted JSON string, escaping quotes, backslashes,
+ *                and control characters
+ * =====================================================================================
+ */
+	void
+print_json_bytes(FILE *out, const unsigned char *data, unsigned long length)
+{
+	fputc('"', out);
+	for (unsigned long i = 0; i < length; i++)
+	{
+		if (data[i] == '"' || data[i] == '\\')
+		{
+			fprintf(out, "\\%c", data[i]);
+		}
+		else if (data[i] == '\n')
+		{
+			fputs("\\n", out);
+		}
+		else if (data[i] < 0x20 || data[i] > 0x7E)
+		{
+			fprintf(out, "\\u%04x", data[i]);
+		}
+		else
+		{
+			fputc(data[i], out);
+		}
+	}
+	fputc('"', out);
+}		/* -----  end of function print_json_bytes  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  print_run_json
+ *  Description:  Prints the result of a run as a JSON object: the outcome, cycles,
+ *                frames, and instructions run, wall time, MIPS, speed as a
+ *                multiple of real hardware, and the serial output
+ * =====================================================================================
+ */
+	void
+print_run_json(FILE *out, const char *rom, GB *gb, const Run_Result *result)
+{
+	unsigned long instructions = mattygboy_get_instructions(gb);
+	double seconds = result->seconds > 0.0 ? result->seconds : 1e-9;
+
+	fprintf(out, "{\"rom\": ");
+	print_json_bytes(out, (const unsigned char *) rom, strlen(rom));
+	fprintf(out, ", \"outcome\": \"%s\", \"exit_code\": %d, \"pc\": %d, \"cycles\": %lu, "
+	        "\"frames\": %lu, \"instructions\": %lu, \"wall_seconds\": %.6f, \"mips\": %.3f, "
+	        "\"speed\": %.3f, \"serial\": ", run_outcome_name(result->outcome), result->outcome,
+	        gb->regs.PC, result->cycles, result->frames, instructions, result->seconds,
+	        (double) instructions / seconds / 1e6, (double) result->cycles / CLOCK_SPEED / seconds);
+	print_json_bytes(out, result->serial, result->serial_length);
+	fputc('}', out);
+}		/* -----  end of function print_run_json  ----- */
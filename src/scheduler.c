@@ -0,0 +1,204 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  scheduler.c
+ *
+ *    Description:  Keeps the machine's cycle count and a min-heap of future events.
+ *                  The cpu only calls in here once the earliest event is due, so
+ *                  the cost of the timers and the lcd follows the number of events
+ *                  rather than the number of cycles
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 19:41:26
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Matt Gercz (matt.gercz@icloud.com)
+ *
+ * =====================================================================================
+ */
+#include <limits.h>
+#include "scheduler.h"
+#include "global_declarations.h"
+#include "graphics.h"
+#include "serial.h"
+#include "timers.h"
+
+static const event_handler handlers[EVENT_COUNT] = {
+	[EVENT_TIMER] = timer_event,
+	[EVENT_LCD] = lcd_event,
+	[EVENT_SERIAL] = serial_event,
+};
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  place
+ *  Description:  Stores an event in the heap and records where it went
+ * =====================================================================================
+ */
+	static void
+place (GB *gb, unsigned int index, Event event)
+{
+	gb->scheduler.heap[index] = event;
+	gb->scheduler.heap_index[event.type] = (int) index;
+}		/* -----  end of function place  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  sift
+ *  Description:  Moves the event at index up or down until the heap is ordered again
+ * =====================================================================================
+ */
+	static void
+sift (GB *gb, unsigned int index)
+{
+	Event event = gb->scheduler.heap[index];
+
+	while (index > 0 && gb->scheduler.heap[(index - 0x1) / 0x2].due > event.due)
+	{
+		place(gb, index, gb->scheduler.heap[(index - 0x1) / 0x2]);
+		index = (index - 0x1) / 0x2;
+	}
+	for (;;)
+	{
+		unsigned int child = index * 0x2 + 0x1;
+
+		if (child >= gb->scheduler.heap_size)
+		{
+			break;
+		}
+		if (child + 0x1 < gb->scheduler.heap_size && gb->scheduler.heap[child + 0x1].due < gb->scheduler.heap[child].due)
+		{
+			child++;
+		}
+		if (gb->scheduler.heap[child].due >= event.due)
+		{
+			break;
+		}
+		place(gb, index, gb->scheduler.heap[child]);
+		index = child;
+	}
+	place(gb, index, event);
+	gb->clock.next_event = gb->scheduler.heap[0].due;
+}		/* -----  end of function sift  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  init_scheduler
+ *  Description:  Resets the clock and the devices that schedule events, which
+ *                  schedule their first ones
+ * =====================================================================================
+ */
+void init_scheduler(GB *gb)
+{
+	gb->clock.cycles = 0x0;
+	gb->clock.next_event = ULONG_MAX;
+	gb->clock.run_until = ULONG_MAX;
+	gb->scheduler.heap_size = 0x0;
+	for (int type = 0; type < EVENT_COUNT; type++)
+	{
+		gb->scheduler.heap_index[type] = -1;
+	}
+
+	init_timers(gb);
+	init_graphics(gb);
+	init_serial(gb);
+}		/* -----  end of function init_scheduler  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  schedule_event
+ *  Description:  Schedules an event, replacing the pending one of the same type
+ *   Parameters:  type is the kind of event
+ *                due is the cycle the event should happen on
+ * =====================================================================================
+ */
+void schedule_event(GB *gb, Event_Type type, unsigned long due)
+{
+	int index = gb->scheduler.heap_index[type];
+
+	if (index < 0)
+	{
+		index = (int) gb->scheduler.heap_size++;
+	}
+	gb->scheduler.heap[index] = (Event) {due, type};
+	sift(gb, (unsigned int) index);
+}		/* -----  end of function schedule_event  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  cancel_event
+ *  Description:  Removes the pending event of a type, if there is one
+ * =====================================================================================
+ */
+void cancel_event(GB *gb, Event_Type type)
+{
+	int index = gb->scheduler.heap_index[type];
+
+	if (index < 0)
+	{
+		return;
+	}
+	gb->scheduler.heap_index[type] = -1;
+	if ((unsigned int) index == --gb->scheduler.heap_size)
+	{
+		gb->clock.next_event = gb->scheduler.heap_size ? gb->scheduler.heap[0].due : ULONG_MAX;
+		return;
+	}
+	gb->scheduler.heap[index] = gb->scheduler.heap[gb->scheduler.heap_size];
+	sift(gb, (unsigned int) index);
+}		/* -----  end of function cancel_event  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  event_due
+ *  Description:  Returns the cycle the pending event of a type is due on, ULONG_MAX
+ *                if there isn't one
+ * =====================================================================================
+ */
+unsigned long event_due(GB *gb, Event_Type type)
+{
+	int index = gb->scheduler.heap_index[type];
+
+	return index < 0 ? ULONG_MAX : gb->scheduler.heap[index].due;
+}		/* -----  end of function event_due  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  run_events
+ *  Description:  Handles every event that is due, in the order they were due
+ * =====================================================================================
+ */
+void run_events(GB *gb)
+{
+	while (gb->scheduler.heap_size && gb->scheduler.heap[0].due <= gb->clock.cycles)
+	{
+		Event event = gb->scheduler.heap[0];
+
+		cancel_event(gb, event.type);
+		handlers[event.type](gb, event.due);
+	}
+}		/* -----  end of function run_events  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  skip_to_next_event
+ *  Description:  Jumps the clock straight to the next event and handles it, for when
+ *                  the cpu has nothing to do until something happens
+ *   Parameters:  limit is the latest cycle the clock may jump to
+ *       Return:  The number of cycles skipped
+ * =====================================================================================
+ */
+unsigned long skip_to_next_event(GB *gb, unsigned long limit)
+{
+	unsigned long from = gb->clock.cycles;
+
+	if (gb->clock.next_event > limit)
+	{
+		gb->clock.cycles = limit > from ? limit : from;
+		return gb->clock.cycles - from;
+	}
+	gb->clock.cycles = gb->clock.next_event;
+	run_events(gb);
+	return gb->clock.cycles - from;
+}		/* -----  end of function skip_to_next_event  ----- */
@@ -0,0 +1,120 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  serial.c
+ *
+ *    Description:  Emulates the serial port with nothing plugged in. A transfer
+ *                  started on the internal clock shifts SB out over 8 bits, finishes
+ *                  SERIAL_TRANSFER_CYCLES later with 0xFF shifted in, and requests
+ *                  the serial interrupt. Bytes sent go to a ring buffer the host
+ *                  drains and to an optional callback
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 23:41:50
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Matt Gercz (matt.gercz@icloud.com)
+ *
+ * =====================================================================================
+ */
+
+#include <string.h>
+#include <cpu_emulator.h>
+#include "serial.h"
+#include "scheduler.h"
+#include "global_declarations.h"
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  init_serial
+ *  Description:  Drops any transfer in flight after a reset, bytes already sent
+ *                  stay in the buffer
+ * =====================================================================================
+ */
+	void
+init_serial(GB *gb)
+{
+	gb->memory[0xFF02] = 0x7E; // Unused bits read back as 1
+	gb->serial.sending = 0x0;
+	cancel_event(gb, EVENT_SERIAL);
+}		/* -----  end of function init_serial  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  write_serial_control
+ *  Description:  Handles writes to SC, mem address 0xFF02. Setting bit 7 with the
+ *                  internal clock selected in bit 0 starts a transfer, with the
+ *                  external clock nothing is plugged in to drive it
+ *   Parameters:  data is the byte written
+ * =====================================================================================
+ */
+	void
+write_serial_control(GB *gb, unsigned char data)
+{
+	gb->memory[0xFF02] = (unsigned char) (data | 0x7Eu);
+	if ((data & 0x81u) == 0x81u)
+	{
+		gb->serial.sending = gb->memory[0xFF01];
+		schedule_event(gb, EVENT_SERIAL, gb->clock.cycles + SERIAL_TRANSFER_CYCLES);
+	}
+	else
+	{
+		cancel_event(gb, EVENT_SERIAL);
+	}
+}		/* -----  end of function write_serial_control  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  serial_event
+ *  Description:  Handles a transfer finishing, SB holds the 1 bits shifted in from
+ *                  the empty port, bit 7 of SC clears, and the serial interrupt is
+ *                  requested
+ *   Parameters:  due is the cycle the transfer finished on
+ * =====================================================================================
+ */
+	void
+serial_event(GB *gb, unsigned long due)
+{
+	(void) due;
+	gb->memory[0xFF01] = 0xFF;
+	gb->memory[0xFF02] &= 0x7Fu;
+	request_interrupt(gb, 0x8u);
+
+	if (gb->serial.sent - gb->serial.drained == SERIAL_BUFFER_SIZE) // Full, drop the oldest
+	{
+		gb->serial.drained++;
+	}
+	gb->serial.buffer[gb->serial.sent++ & (SERIAL_BUFFER_SIZE - 0x1)] = gb->serial.sending;
+	if (gb->serial.callback != NULL)
+	{
+		gb->serial.callback(gb->serial.context, gb->serial.sending);
+	}
+}		/* -----  end of function serial_event  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  drain_serial
+ *  Description:  Moves the bytes sent since the last drain out of the ring buffer,
+ *                  oldest first
+ *   Parameters:  buffer receives the bytes and size is its length
+ *       Return:  The number of bytes moved, more remain if this equals size
+ * =====================================================================================
+ */
+	unsigned long
+drain_serial(GB *gb, unsigned char *buffer, unsigned long size)
+{
+	unsigned long count = gb->serial.sent - gb->serial.drained;
+	unsigned long start = gb->serial.drained & (SERIAL_BUFFER_SIZE - 0x1);
+	unsigned long first;
+
+	if (count > size)
+	{
+		count = size;
+	}
+	first = SERIAL_BUFFER_SIZE - start < count ? SERIAL_BUFFER_SIZE - start : count;
+	memcpy(buffer, gb->serial.buffer + start, first);
+	memcpy(buffer + first, gb->serial.buffer, count - first);
+	gb->serial.drained += count;
+	return count;
+}		/* -----  end of function drain_serial  ----- */
@@ -0,0 +1,516 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  state.c
+ *
+ *    Description:  Saves and restores the state of an emulator instance. A state is a
+ *                  header followed by tagged sections, one per part of the machine.
+ *                  Only the parts that can change are kept: no ROM, no boot ROM once
+ *                  it's unmapped, and external RAM only up to its last byte in use.
+ *                  Pointers are rebuilt on load so a state can be restored into any
+ *                  instance that has the same cartridge loaded
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 21:37:05
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Matt Gercz (matt.gercz@icloud.com)
+ *
+ * =====================================================================================
+ */
+#include <limits.h>
+#include <string.h>
+#include "state.h"
+#include "global_declarations.h"
+
+#define STATE_MAGIC 0x5342474Du // "MGBS"
+#define STATE_VERSION 0x3 // Bump whenever a section changes layout
+
+typedef struct State_Header
+{
+	unsigned int magic;
+	unsigned int version;
+	unsigned long size; // Bytes of sections following the header
+} State_Header;
+
+// Sections may come in any order, loaders skip ones they don't know
+typedef enum State_Section
+{
+	SECTION_CARTRIDGE, // Header checksums of the rom the state was saved from
+	SECTION_CPU,
+	SECTION_CLOCK,
+	SECTION_SCHEDULER,
+	SECTION_TIMERS,
+	SECTION_LCD,
+	SECTION_MACHINE, // Banking and inputs
+	SECTION_MEMORY, // 0x8000-0xFFFF, everything below is ROM
+	SECTION_EXT_RAM, // Left out when the cartridge has none, trimmed to the last page used
+	SECTION_BOOT_ROM, // Only while the boot ROM is mapped in
+	SECTION_FRAMEBUFFER,
+	SECTION_SERIAL,
+	SECTION_SERIAL_LOG, // Bytes sent but not yet drained, oldest first
+	SECTION_PIXEL_INDICES
+} State_Section;
+
+typedef struct Section_Header
+{
+	unsigned int id;
+	unsigned int length; // Bytes of data following the section header
+} Section_Header;
+
+typedef struct State_Cartridge
+{
+	unsigned char header_checksum;
+	unsigned char global_checksum[0x2];
+} State_Cartridge;
+
+typedef struct State_Machine
+{
+	MBC_Registers mbc_registers;
+	unsigned char has_mbc;
+	unsigned char has_ext_ram;
+	unsigned char banking_mode;
+	unsigned char boot_up;
+	unsigned char buttons;
+} State_Machine;
+
+typedef struct State_Serial
+{
+	unsigned long sent;
+	unsigned long drained;
+	unsigned char sending;
+} State_Serial;
+
+// Where the next bytes of a state go, the sizing pass only counts them
+typedef struct State_Writer
+{
+	unsigned char *buffer; // NULL to only count
+	unsigned long size;
+	unsigned long used;
+} State_Writer;
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  write_bytes
+ *  Description:  Appends to the state, only counting once it no longer fits
+ * =====================================================================================
+ */
+	static void
+write_bytes(State_Writer *writer, const void *data, unsigned long length)
+{
+	if (writer->buffer != NULL && writer->used + length <= writer->size)
+	{
+		memcpy(writer->buffer + writer->used, data, length);
+	}
+	writer->used += length;
+}		/* -----  end of function write_bytes  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  write_section
+ *  Description:  Appends a section header, the caller writes length bytes after it
+ * =====================================================================================
+ */
+	static void
+write_section(State_Writer *writer, State_Section id, unsigned long length)
+{
+	Section_Header header = {id, (unsigned int) length};
+
+	write_bytes(writer, &header, sizeof(header));
+}		/* -----  end of function write_section  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  cartridge_id
+ *  Description:  Fills in the checksums that tell cartridges apart
+ * =====================================================================================
+ */
+	static State_Cartridge
+cartridge_id(GB *gb)
+{
+	State_Cartridge id = {0x0};
+
+	if (gb->cartridge != NULL)
+	{
+		id.header_checksum = gb->cartridge->rom[0x14D];
+		id.global_checksum[0x0] = gb->cartridge->rom[0x14E];
+		id.global_checksum[0x1] = gb->cartridge->rom[0x14F];
+	}
+	return id;
+}		/* -----  end of function cartridge_id  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  ext_ram_used
+ *  Description:  Returns how much of ext_ram to keep, up to the end of the last 256
+ *                byte page that isn't blank
+ * =====================================================================================
+ */
+	static unsigned long
+ext_ram_used(GB *gb)
+{
+	unsigned long end = sizeof(gb->ext_ram);
+
+	if (gb->ext_ram_bank == NULL)
+	{
+		return 0x0;
+	}
+	while (end > 0x0 && !gb->ext_ram[end - 0x1])
+	{
+		end--;
+	}
+	return (end + 0xFFu) & ~0xFFul;
+}		/* -----  end of function ext_ram_used  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  save_state
+ *  Description:  Writes the state of an instance to a buffer. Pending lazy flags are
+ *                worked out first so states don't depend on how the core was built
+ *   Parameters:  buffer receives the state, pass NULL to only get the size
+ *                size is the length of buffer in bytes
+ *       Return:  The size of the state in bytes, nothing is written when buffer is
+ *                NULL or smaller than that
+ * =====================================================================================
+ */
+	unsigned long
+save_state(GB *gb, unsigned char *buffer, unsigned long size)
+{
+	State_Cartridge cartridge = cartridge_id(gb);
+	State_Machine machine;
+	State_Serial serial;
+	unsigned long ext_ram = ext_ram_used(gb);
+	unsigned long log_start = gb->serial.sent - gb->serial.drained > SERIAL_BUFFER_SIZE ?
+	                          gb->serial.sent - SERIAL_BUFFER_SIZE : gb->serial.drained;
+	unsigned long log_index = log_start % SERIAL_BUFFER_SIZE;
+	unsigned long log_length = gb->serial.sent - log_start;
+	unsigned long log_head = log_length < SERIAL_BUFFER_SIZE - log_index ?
+	                         log_length : SERIAL_BUFFER_SIZE - log_index;
+	State_Header header = {STATE_MAGIC, STATE_VERSION, 0x0};
+	State_Writer writer = {NULL, 0x0, 0x0};
+
+	// Padding is cleared so the same machine always saves the same bytes
+	memset(&machine, 0x0, sizeof(machine));
+	memcpy(&machine.mbc_registers, &gb->mbc_registers, sizeof(machine.mbc_registers));
+	machine.has_mbc = gb->mbc != NULL;
+	machine.has_ext_ram = gb->ext_ram_bank != NULL;
+	machine.banking_mode = gb->banking_mode;
+	machine.boot_up = gb->boot_up;
+	machine.buttons = gb->buttons;
+	memset(&serial, 0x0, sizeof(serial));
+	serial.sent = gb->serial.sent;
+	serial.drained = gb->serial.drained;
+	serial.sending = gb->serial.sending;
+	sync_flags(gb, 0x0);
+
+	// Size everything first so a state is written whole or not at all
+	for (int pass = 0x0; pass < 0x2; pass++)
+	{
+		write_bytes(&writer, &header, sizeof(header));
+		write_section(&writer, SECTION_CARTRIDGE, sizeof(cartridge));
+		write_bytes(&writer, &cartridge, sizeof(cartridge));
+		write_section(&writer, SECTION_CPU, sizeof(gb->regs));
+		write_bytes(&writer, &gb->regs, sizeof(gb->regs));
+		write_section(&writer, SECTION_CLOCK, sizeof(gb->clock));
+		write_bytes(&writer, &gb->clock, sizeof(gb->clock));
+		write_section(&writer, SECTION_SCHEDULER, sizeof(gb->scheduler));
+		write_bytes(&writer, &gb->scheduler, sizeof(gb->scheduler));
+		write_section(&writer, SECTION_TIMERS, sizeof(gb->timers));
+		write_bytes(&writer, &gb->timers, sizeof(gb->timers));
+		write_section(&writer, SECTION_LCD, sizeof(gb->lcd));
+		write_bytes(&writer, &gb->lcd, sizeof(gb->lcd));
+		write_section(&writer, SECTION_MACHINE, sizeof(machine));
+		write_bytes(&writer, &machine, sizeof(machine));
+		write_section(&writer, SECTION_MEMORY, 0x8000);
+		write_bytes(&writer, &gb->memory[0x8000], 0x8000);
+		if (ext_ram)
+		{
+			write_section(&writer, SECTION_EXT_RAM, ext_ram);
+			write_bytes(&writer, gb->ext_ram, ext_ram);
+		}
+		if (gb->boot_up)
+		{
+			write_section(&writer, SECTION_BOOT_ROM, sizeof(gb->boot_rom));
+			write_bytes(&writer, gb->boot_rom, sizeof(gb->boot_rom));
+		}
+		write_section(&writer, SECTION_FRAMEBUFFER, sizeof(gb->framebuffer));
+		write_bytes(&writer, gb->framebuffer, sizeof(gb->framebuffer));
+		write_section(&writer, SECTION_PIXEL_INDICES, sizeof(gb->pixel_indices));
+		write_bytes(&writer, gb->pixel_indices, sizeof(gb->pixel_indices));
+		write_section(&writer, SECTION_SERIAL, sizeof(serial));
+		write_bytes(&writer, &serial, sizeof(serial));
+		if (log_length)
+		{
+			write_section(&writer, SECTION_SERIAL_LOG, log_length);
+			write_bytes(&writer, &gb->serial.buffer[log_index], log_head);
+			write_bytes(&writer, gb->serial.buffer, log_length - log_head);
+		}
+
+		if (pass == 0x0)
+		{
+			if (buffer == NULL || size < writer.used)
+			{
+				return writer.used;
+			}
+			header.size = writer.used - sizeof(header);
+			writer = (State_Writer) {buffer, size, 0x0};
+		}
+	}
+	return writer.used;
+}		/* -----  end of function save_state  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  find_section
+ *  Description:  Looks up a section of a state whose sections have been checked to
+ *                fit inside it
+ *   Parameters:  length receives the size of the section's data
+ *       Return:  The section's data, NULL if the state doesn't have it
+ * =====================================================================================
+ */
+	static const unsigned char*
+find_section(const unsigned char *sections, unsigned long size, State_Section id,
+             unsigned long *length)
+{
+	Section_Header header;
+
+	for (unsigned long offset = 0x0; offset < size; offset += sizeof(header) + header.length)
+	{
+		memcpy(&header, sections + offset, sizeof(header));
+		if (header.id == id)
+		{
+			*length = header.length;
+			return sections + offset + sizeof(header);
+		}
+	}
+	return NULL;
+}		/* -----  end of function find_section  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  fixed_section
+ *  Description:  Looks up a section that must be present with a known size
+ *       Return:  The section's data, NULL if it's missing or the wrong size
+ * =====================================================================================
+ */
+	static const unsigned char*
+fixed_section(const unsigned char *sections, unsigned long size, State_Section id,
+              unsigned long expected)
+{
+	unsigned long length;
+	const unsigned char *data = find_section(sections, size, id, &length);
+
+	return data != NULL && length == expected ? data : NULL;
+}		/* -----  end of function fixed_section  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  scheduler_fits
+ *  Description:  Checks a saved scheduler is a heap of known events whose positions
+ *                agree with heap_index, and that the clock expects its first event
+ * =====================================================================================
+ */
+	static int
+scheduler_fits(const Scheduler *scheduler, const Machine_Clock *clock)
+{
+	if (scheduler->heap_size > EVENT_COUNT)
+	{
+		return 0x0;
+	}
+	for (unsigned int type = 0x0; type < EVENT_COUNT; type++)
+	{
+		int index = scheduler->heap_index[type];
+
+		if (index < -1 || index >= (int) scheduler->heap_size ||
+		    (index >= 0 && scheduler->heap[index].type != (Event_Type) type))
+		{
+			return 0x0;
+		}
+	}
+	for (unsigned int i = 0x0; i < scheduler->heap_size; i++)
+	{
+		const Event *event = &scheduler->heap[i];
+
+		if ((unsigned int) event->type >= EVENT_COUNT || scheduler->heap_index[event->type] != (int) i ||
+		    (i && scheduler->heap[(i - 0x1) / 0x2].due > event->due))
+		{
+			return 0x0;
+		}
+	}
+	return clock->next_event == (scheduler->heap_size ? scheduler->heap[0].due : ULONG_MAX);
+}		/* -----  end of function scheduler_fits  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  machine_fits
+ *  Description:  Checks saved banking against the instance's cartridge, which decides
+ *                whether there's an MBC or external RAM and how big a RAM bank is
+ * =====================================================================================
+ */
+	static int
+machine_fits(GB *gb, const State_Machine *machine)
+{
+	const MBC_Registers *mbc = &machine->mbc_registers;
+	unsigned long bank_size;
+
+	if (machine->has_mbc != (gb->mbc != NULL) || machine->banking_mode != gb->banking_mode ||
+	    machine->has_ext_ram != (gb->ext_ram_bank != NULL))
+	{
+		return 0x0;
+	}
+	if (!machine->has_mbc)
+	{
+		return 0x1;
+	}
+	if (mbc->ram_bank_size != gb->mbc->ram_bank_size)
+	{
+		return 0x0;
+	}
+
+	// Mapping RAM in may take a whole 0x2000 page whatever the bank size
+	bank_size = mbc->ram_bank_size > 0x2000 ? mbc->ram_bank_size : 0x2000;
+	return !machine->has_ext_ram || (mbc->ram_bank_number + 0x1ul) * bank_size <= sizeof(gb->ext_ram);
+}		/* -----  end of function machine_fits  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  load_state
+ *  Description:  Restores an instance from a state made by save_state. The whole
+ *                state is checked before anything changes. The instance keeps its
+ *                own cartridge, serial callback, breakpoint, statistics, and code
+ *                caches, cached code is dropped since RAM may now hold different code
+ *   Parameters:  buffer holds the state and size is its length in bytes
+ *       Return:  0 on success, -1 if the state is damaged, from another version or
+ *                build, or saved from a different cartridge
+ * =====================================================================================
+ */
+	int
+load_state(GB *gb, const unsigned char *buffer, unsigned long size)
+{
+	State_Header header;
+	Section_Header section;
+	State_Cartridge cartridge = cartridge_id(gb), saved_cartridge;
+	State_Machine machine;
+	State_Serial serial;
+	Scheduler scheduler;
+	Machine_Clock saved_clock;
+	const unsigned char *sections, *cpu, *clock, *timers, *lcd, *memory, *ext_ram, *boot_rom,
+	                    *framebuffer, *pixel_indices, *log;
+	unsigned long ext_ram_length = 0x0, log_length = 0x0, length;
+
+	if (buffer == NULL || size < sizeof(header))
+	{
+		return -1;
+	}
+	memcpy(&header, buffer, sizeof(header));
+	if (header.magic != STATE_MAGIC || header.version != STATE_VERSION ||
+	    header.size > size - sizeof(header))
+	{
+		return -1;
+	}
+	sections = buffer + sizeof(header);
+
+	// Every section has to fit before any can be looked up
+	for (unsigned long offset = 0x0; offset < header.size; offset += section.length)
+	{
+		if (header.size - offset < sizeof(section))
+		{
+			return -1;
+		}
+		memcpy(&section, sections + offset, sizeof(section));
+		offset += sizeof(section);
+		if (section.length > header.size - offset)
+		{
+			return -1;
+		}
+	}
+
+	cpu = fixed_section(sections, header.size, SECTION_CPU, sizeof(gb->regs));
+	clock = fixed_section(sections, header.size, SECTION_CLOCK, sizeof(gb->clock));
+	timers = fixed_section(sections, header.size, SECTION_TIMERS, sizeof(gb->timers));
+	lcd = fixed_section(sections, header.size, SECTION_LCD, sizeof(gb->lcd));
+	memory = fixed_section(sections, header.size, SECTION_MEMORY, 0x8000);
+	framebuffer = fixed_section(sections, header.size, SECTION_FRAMEBUFFER, sizeof(gb->framebuffer));
+	pixel_indices = fixed_section(sections, header.size, SECTION_PIXEL_INDICES, sizeof(gb->pixel_indices));
+	boot_rom = fixed_section(sections, header.size, SECTION_BOOT_ROM, sizeof(gb->boot_rom));
+	ext_ram = find_section(sections, header.size, SECTION_EXT_RAM, &ext_ram_length);
+	log = find_section(sections, header.size, SECTION_SERIAL_LOG, &log_length);
+	if (cpu == NULL || clock == NULL || timers == NULL || lcd == NULL || memory == NULL ||
+	    framebuffer == NULL || pixel_indices == NULL ||
+	    fixed_section(sections, header.size, SECTION_SCHEDULER, sizeof(scheduler)) == NULL ||
+	    fixed_section(sections, header.size, SECTION_CARTRIDGE, sizeof(saved_cartridge)) == NULL ||
+	    fixed_section(sections, header.size, SECTION_MACHINE, sizeof(machine)) == NULL ||
+	    fixed_section(sections, header.size, SECTION_SERIAL, sizeof(serial)) == NULL)
+	{
+		return -1;
+	}
+	memcpy(&saved_cartridge, find_section(sections, header.size, SECTION_CARTRIDGE, &length),
+	       sizeof(saved_cartridge));
+	memcpy(&machine, find_section(sections, header.size, SECTION_MACHINE, &length),
+	       sizeof(machine));
+	memcpy(&serial, find_section(sections, header.size, SECTION_SERIAL, &length),
+	       sizeof(serial));
+	memcpy(&scheduler, find_section(sections, header.size, SECTION_SCHEDULER, &length),
+	       sizeof(scheduler));
+	memcpy(&saved_clock, clock, sizeof(saved_clock));
+	if (memcmp(&saved_cartridge, &cartridge, sizeof(cartridge)) ||
+	    !scheduler_fits(&scheduler, &saved_clock) || !machine_fits(gb, &machine) ||
+	    ext_ram_length > sizeof(gb->ext_ram) ||
+	    (machine.boot_up && boot_rom == NULL) ||
+	    serial.drained > serial.sent || log_length > SERIAL_BUFFER_SIZE ||
+	    log_length > serial.sent - serial.drained)
+	{
+		return -1;
+	}
+
+	memcpy(&gb->regs, cpu, sizeof(gb->regs));
+	gb->clock = saved_clock;
+	gb->scheduler = scheduler;
+	memcpy(&gb->timers, timers, sizeof(gb->timers));
+	memcpy(&gb->lcd, lcd, sizeof(gb->lcd));
+#ifdef LAZY_FLAGS
+	gb->lazy.pending = 0x0; // Saved states never owe flags
+#endif
+	gb->mbc_registers = machine.mbc_registers;
+	gb->mbc = machine.has_mbc ? &gb->mbc_registers : NULL;
+	gb->ext_ram_bank = machine.has_ext_ram ? gb->ext_ram : NULL;
+	gb->banking_mode = machine.banking_mode;
+	gb->boot_up = machine.boot_up;
+	gb->buttons = machine.buttons;
+	memcpy(&gb->memory[0x8000], memory, 0x8000);
+	invalidate_graphics(gb);
+	if (ext_ram != NULL)
+	{
+		memcpy(gb->ext_ram, ext_ram, ext_ram_length);
+	}
+	memset(&gb->ext_ram[ext_ram_length], 0x0, sizeof(gb->ext_ram) - ext_ram_length);
+	if (machine.boot_up)
+	{
+		memcpy(gb->boot_rom, boot_rom, sizeof(gb->boot_rom));
+	}
+	memcpy(gb->framebuffer, framebuffer, sizeof(gb->framebuffer));
+	memcpy(gb->pixel_indices, pixel_indices, sizeof(gb->pixel_indices));
+
+	// Undrained bytes go back where the ring had them, the rest were drained already
+	gb->serial.sent = serial.sent;
+	gb->serial.drained = serial.sent - log_length;
+	gb->serial.sending = serial.sending;
+	for (unsigned long i = 0x0; i < log_length; i++)
+	{
+		gb->serial.buffer[(gb->serial.drained + i) % SERIAL_BUFFER_SIZE] = log[i];
+	}
+
+	gb->locked_up = 0x0; // A locked up state locks up again on its first instruction
+
+	// Loops found by the last run may not be code any more
+	memset(gb->idle_loops.loops, 0x0, sizeof(gb->idle_loops.loops));
+	gb->idle_loops.confirming_key = 0xFFFFFFFFu;
+	update_memory_map(gb);
+#ifdef JIT
+	jit_flush(gb);
+#elif defined(BLOCK_CACHE)
+	block_cache_flush(gb);
+#endif
+	return 0x0;
+}		/* -----  end of function load_state  ----- */
@@ -0,0 +1,239 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  threaded_core.c
+ *
+ *    Description:  Threaded-code interpreter loop built on GCC/Clang "labels as
+ *                  values". PC is kept in a local and every instruction ends in its
+ *                  own indirect jump to the next one, so the host branch predictor
+ *                  can learn opcode sequences. The most common instructions that
+ *                  don't touch flags are emulated inline, everything else goes
+ *                  through the opcode tables. Built when THREADED_CORE is defined
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 11:02:18
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Matt Gercz (matt.gercz@icloud.com)
+ *
+ * =====================================================================================
+ */
+#ifdef THREADED_CORE
+#include "cpu_emulator.h"
+#include "global_declarations.h"
+#include "idle_loop.h"
+#include "scheduler.h"
+
+// Checks the stop conditions then jumps straight to the next opcode's label
+#define DISPATCH() \
+	do { \
+		if (executed == max_instructions || pc == stop_pc || \
+		    gb->clock.cycles >= gb->clock.run_until) \
+		{ \
+			goto done; \
+		} \
+		executed++; \
+		opcode = read_memory(gb, pc++); \
+		goto *labels[opcode]; \
+	} while (0)
+
+// Ends every instruction, the clock still advances once per instruction
+#define NEXT(cycles) \
+	do { \
+		advance_clock(cycles); \
+		DISPATCH(); \
+	} while (0)
+
+#define LD_R_R(label, dst, src) \
+	label: \
+		r->dst = r->src; \
+		NEXT(0x4)
+
+#define LD_R_IMM(label, dst) \
+	label: \
+		r->dst = read_memory(gb, pc++); \
+		NEXT(0x8)
+
+#define LD_RR_IMM(label, pair) \
+	label: \
+		operand = read_memory(gb, pc++); \
+		r->pair = combine_bytes(read_memory(gb, pc++), (unsigned char) operand); \
+		NEXT(0xC)
+
+#define JR(label, condition) \
+	label: \
+		offset = (char) read_memory(gb, pc++); \
+		sync_flags(gb, 0x0); \
+		if (condition) \
+		{ \
+			if (offset < 0) \
+			{ \
+				idle_loop_branch(gb, (unsigned short) (pc + offset), pc); \
+			} \
+			pc += offset; \
+			NEXT(0xC); \
+		} \
+		NEXT(0x8)
+
+#define JP(label, condition) \
+	label: \
+		operand = read_memory(gb, pc++); \
+		operand = combine_bytes(read_memory(gb, pc++), (unsigned char) operand); \
+		sync_flags(gb, 0x0); \
+		if (condition) \
+		{ \
+			pc = operand; \
+			NEXT(0x10); \
+		} \
+		NEXT(0xC)
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  cpu_run
+ *  Description:  Executes instructions until a limit, a PC breakpoint or the end of a cycle run
+ *   Parameters:  max_instructions is the most instructions to execute
+ *                stop_pc stops execution when PC reaches it, pass -1 for no breakpoint
+ *       Return:  The number of instructions executed
+ * =====================================================================================
+ */
+unsigned long cpu_run(GB *gb, unsigned long max_instructions, int stop_pc)
+{
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Woverride-init" // Opcodes with their own handler replace the default
+	static const void *labels[0x100] = {
+		[0x00 ... 0xFF] = &&generic,
+		[0x00] = &&nop,
+		[0x01] = &&ld_bc_imm, [0x11] = &&ld_de_imm, [0x21] = &&ld_hl_imm,
+		[0x31] = &&ld_sp_imm,
+		[0x06] = &&ld_b_imm, [0x0E] = &&ld_c_imm, [0x16] = &&ld_d_imm,
+		[0x1E] = &&ld_e_imm, [0x26] = &&ld_h_imm, [0x2E] = &&ld_l_imm,
+		[0x3E] = &&ld_a_imm,
+		[0x18] = &&jr, [0x20] = &&jr_nz, [0x28] = &&jr_z, [0x30] = &&jr_nc,
+		[0x38] = &&jr_c,
+		[0xC3] = &&jp, [0xC2] = &&jp_nz, [0xCA] = &&jp_z, [0xD2] = &&jp_nc,
+		[0xDA] = &&jp_c,
+		[0x40] = &&ld_b_b, [0x41] = &&ld_b_c, [0x42] = &&ld_b_d, [0x43] = &&ld_b_e,
+		[0x44] = &&ld_b_h, [0x45] = &&ld_b_l, [0x47] = &&ld_b_a,
+		[0x48] = &&ld_c_b, [0x49] = &&ld_c_c, [0x4A] = &&ld_c_d, [0x4B] = &&ld_c_e,
+		[0x4C] = &&ld_c_h, [0x4D] = &&ld_c_l, [0x4F] = &&ld_c_a,
+		[0x50] = &&ld_d_b, [0x51] = &&ld_d_c, [0x52] = &&ld_d_d, [0x53] = &&ld_d_e,
+		[0x54] = &&ld_d_h, [0x55] = &&ld_d_l, [0x57] = &&ld_d_a,
+		[0x58] = &&ld_e_b, [0x59] = &&ld_e_c, [0x5A] = &&ld_e_d, [0x5B] = &&ld_e_e,
+		[0x5C] = &&ld_e_h, [0x5D] = &&ld_e_l, [0x5F] = &&ld_e_a,
+		[0x60] = &&ld_h_b, [0x61] = &&ld_h_c, [0x62] = &&ld_h_d, [0x63] = &&ld_h_e,
+		[0x64] = &&ld_h_h, [0x65] = &&ld_h_l, [0x67] = &&ld_h_a,
+		[0x68] = &&ld_l_b, [0x69] = &&ld_l_c, [0x6A] = &&ld_l_d, [0x6B] = &&ld_l_e,
+		[0x6C] = &&ld_l_h, [0x6D] = &&ld_l_l, [0x6F] = &&ld_l_a,
+		[0x78] = &&ld_a_b, [0x79] = &&ld_a_c, [0x7A] = &&ld_a_d, [0x7B] = &&ld_a_e,
+		[0x7C] = &&ld_a_h, [0x7D] = &&ld_a_l, [0x7F] = &&ld_a_a,
+		[0xE0] = &&ldh_imm_a, [0xF0] = &&ldh_a_imm,
+		[0xF3] = &&di, [0xFB] = &&ei,
+	};
+#pragma GCC diagnostic pop
+
+	// Hot state lives in locals and is only written back around table handlers
+	Registers *r = &gb->regs;
+	unsigned short pc = gb->regs.PC;
+	unsigned long executed = 0;
+	unsigned short operand;
+	unsigned char opcode;
+	unsigned char cycles;
+	char offset;
+
+	if (gb->locked_up)
+	{
+		goto done;
+	}
+	DISPATCH();
+
+generic:
+	operand = 0;
+	if (opcode_table[opcode].length)
+	{
+		operand = read_memory(gb, pc++);
+		if (opcode_table[opcode].length == 0x2)
+		{
+			operand = combine_bytes(read_memory(gb, pc++), (unsigned char) operand);
+		}
+	}
+	gb->regs.PC = pc;
+	cycles = opcode_table[opcode].execute(gb, operand);
+	pc = gb->regs.PC;
+	if (gb->locked_up) // Only table handlers can run an illegal opcode
+	{
+		advance_clock(cycles);
+		goto done;
+	}
+	NEXT(cycles);
+
+nop:
+	NEXT(0x4);
+
+	LD_RR_IMM(ld_bc_imm, BC);
+	LD_RR_IMM(ld_de_imm, DE);
+	LD_RR_IMM(ld_hl_imm, HL);
+	LD_RR_IMM(ld_sp_imm, SP);
+
+	LD_R_IMM(ld_b_imm, B);
+	LD_R_IMM(ld_c_imm, C);
+	LD_R_IMM(ld_d_imm, D);
+	LD_R_IMM(ld_e_imm, E);
+	LD_R_IMM(ld_h_imm, H);
+	LD_R_IMM(ld_l_imm, L);
+	LD_R_IMM(ld_a_imm, A);
+
+	JR(jr, 0x1);
+	JR(jr_nz, !(r->F & FLAG_Z));
+	JR(jr_z, r->F & FLAG_Z);
+	JR(jr_nc, !(r->F & FLAG_C));
+	JR(jr_c, r->F & FLAG_C);
+
+	JP(jp, 0x1);
+	JP(jp_nz, !(r->F & FLAG_Z));
+	JP(jp_z, r->F & FLAG_Z);
+	JP(jp_nc, !(r->F & FLAG_C));
+	JP(jp_c, r->F & FLAG_C);
+
+	LD_R_R(ld_b_b, B, B); LD_R_R(ld_b_c, B, C); LD_R_R(ld_b_d, B, D);
+	LD_R_R(ld_b_e, B, E); LD_R_R(ld_b_h, B, H); LD_R_R(ld_b_l, B, L);
+	LD_R_R(ld_b_a, B, A);
+	LD_R_R(ld_c_b, C, B); LD_R_R(ld_c_c, C, C); LD_R_R(ld_c_d, C, D);
+	LD_R_R(ld_c_e, C, E); LD_R_R(ld_c_h, C, H); LD_R_R(ld_c_l, C, L);
+	LD_R_R(ld_c_a, C, A);
+	LD_R_R(ld_d_b, D, B); LD_R_R(ld_d_c, D, C); LD_R_R(ld_d_d, D, D);
+	LD_R_R(ld_d_e, D, E); LD_R_R(ld_d_h, D, H); LD_R_R(ld_d_l, D, L);
+	LD_R_R(ld_d_a, D, A);
+	LD_R_R(ld_e_b, E, B); LD_R_R(ld_e_c, E, C); LD_R_R(ld_e_d, E, D);
+	LD_R_R(ld_e_e, E, E); LD_R_R(ld_e_h, E, H); LD_R_R(ld_e_l, E, L);
+	LD_R_R(ld_e_a, E, A);
+	LD_R_R(ld_h_b, H, B); LD_R_R(ld_h_c, H, C); LD_R_R(ld_h_d, H, D);
+	LD_R_R(ld_h_e, H, E); LD_R_R(ld_h_h, H, H); LD_R_R(ld_h_l, H, L);
+	LD_R_R(ld_h_a, H, A);
+	LD_R_R(ld_l_b, L, B); LD_R_R(ld_l_c, L, C); LD_R_R(ld_l_d, L, D);
+	LD_R_R(ld_l_e, L, E); LD_R_R(ld_l_h, L, H); LD_R_R(ld_l_l, L, L);
+	LD_R_R(ld_l_a, L, A);
+	LD_R_R(ld_a_b, A, B); LD_R_R(ld_a_c, A, C); LD_R_R(ld_a_d, A, D);
+	LD_R_R(ld_a_e, A, E); LD_R_R(ld_a_h, A, H); LD_R_R(ld_a_l, A, L);
+	LD_R_R(ld_a_a, A, A);
+
+ldh_a_imm:
+	r->A = read_memory(gb, (unsigned short) (read_memory(gb, pc++) + 0xFF00));
+	NEXT(0xC);
+ldh_imm_a:
+	write_memory(gb, (unsigned short) (read_memory(gb, pc++) + 0xFF00), r->A);
+	NEXT(0xC);
+
+di:
+	r->IME = 0x0;
+	NEXT(0x4);
+ei:
+	r->IME = 0x1;
+	NEXT(0x4);
+
+done:
+	gb->regs.PC = pc;
+	sync_flags(gb, 0x0); // Leave the flags readable by the caller
+	return executed;
+}		/* -----  end of function cpu_run  ----- */
+#endif
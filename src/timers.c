@@ -3,7 +3,9 @@
  *
  *       Filename:  graphics.c
  *
- *    Description:  Contains functions that control access to memory for timers
+ *    Description:  Contains functions that control access to memory for timers.
+ *                  DIV and TIMA are worked out from the machine clock when they are
+ *                  read, the only event scheduled is the next TIMA overflow
  *
  *        Version:  1.0
  *        Created:  08/29/2018 08:55:12
@@ -19,103 +21,154 @@
 #include <cpu_emulator.h>
 #include "timers.h"
 #include "memory.h"
+#include "scheduler.h"
 #include "global_declarations.h"
 
-// Used to track when the actual timer and divider registers should be incremented
-static unsigned char divider_counter = 0x0;
-static unsigned int timer_counter = 0x0;
+// Clock cycles between TIMA increments for each setting of the 2 LSB of TAC
+static const unsigned short timer_periods[0x4] = {0x400, 0x10, 0x40, 0x100};
 
 /*
  * ===  FUNCTION  ======================================================================
- *         Name:  update_timers
- *  Description:  Handles updates to the timer registers
+ *         Name:  timer_ticks
+ *  Description:  Counts the TIMA increments between two cycles
+ *   Parameters:  from is the cycle to count from, exclusive
+ *                to is the cycle to count to, inclusive
  * =====================================================================================
  */
-void
-update_timers(unsigned char cycles)
+static unsigned long
+timer_ticks(GB *gb, unsigned long from, unsigned long to)
 {
-    // Only increment timer register if bit 3 of TAC set
-    unsigned char tac_reg = read_memory(0xFF07);
-    unsigned char timer_frequency = (unsigned char) (tac_reg & 0x3u);
-    unsigned char tima_enable = (unsigned char) (tac_reg & 0x4u);
+    unsigned long period = timer_periods[gb->timers.timer_control & 0x3u];
 
-    for (int i = 0x0; i < cycles; i++)
+    if (!(gb->timers.timer_control & 0x4u)) // Only increment timer register if bit 3 of TAC set
     {
-        // Update the divider register
-        divider_counter++;
-        if (divider_counter == 0x0) {
-            increment_divider();
-        }
+        return 0x0;
+    }
+    return (to - gb->timers.divider_base) / period - (from - gb->timers.divider_base) / period;
+}        /* -----  end of function timer_ticks  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  sync_timer
+ *  Description:  Brings timer_value up to the current cycle, needed before anything
+ *                  that changes how TIMA counts
+ * =====================================================================================
+ */
+static void
+sync_timer(GB *gb)
+{
+    gb->timers.timer_value = read_timer_counter(gb);
+    gb->timers.timer_base = gb->clock.cycles;
+}        /* -----  end of function sync_timer  ----- */
 
-        // Update the timer register
-        timer_counter++;
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  schedule_overflow
+ *  Description:  Schedules the cycle TIMA next overflows on, if it's enabled
+ * =====================================================================================
+ */
+static void
+schedule_overflow(GB *gb)
+{
+    unsigned long period = timer_periods[gb->timers.timer_control & 0x3u];
+    unsigned long ticks_left = 0x100u - gb->timers.timer_value;
+    unsigned long counter = gb->timers.timer_base - gb->timers.divider_base;
 
-        // TIMA update frequency specified by 2 LSB in TAC
-        switch (timer_frequency)
-        {
-            case 0x00:
-                if (timer_counter == 0x400) // 4096 Hz / 1024 clocks
-                {
-                    if (tima_enable)
-                    {
-                        increment_timer();
-                    }
-                    timer_counter = 0x0;
-                }
-                break;
-            case 0x01:
-                if (timer_counter == 0x10) // 262144 Hz / 16 clocks
-                {
-                    if (tima_enable)
-                    {
-                        increment_timer();
-                    }
-                    timer_counter = 0x0;
-                }
-                break;
-            case 0x02:
-                if (timer_counter == 0x40) // 65536 Hz / 64 clocks
-                {
-                    if (tima_enable)
-                    {
-                        increment_timer();
-                    }
-                    timer_counter = 0x0;
-                }
-                break;
-            case 0x3:
-                if (timer_counter == 0x100) // 16384 Hz / 256 clocks
-                {
-                    if (tima_enable)
-                    {
-                        increment_timer();
-                    }
-                    timer_counter = 0x0;
-                }
-                break;
-            default:
-                break;
-        }
+    if (!(gb->timers.timer_control & 0x4u))
+    {
+        cancel_event(gb, EVENT_TIMER);
+        return;
     }
-}        /* -----  end of function update timers  ----- */
+    schedule_event(gb, EVENT_TIMER, gb->timers.divider_base + (counter / period + ticks_left) * period);
+}        /* -----  end of function schedule_overflow  ----- */
 
 /*
  * ===  FUNCTION  ======================================================================
- *         Name:  increment_timer
- *  Description:  Increments the divider register, mem address 0xFF04
+ *         Name:  init_timers
+ *  Description:  Starts DIV and TIMA over after a reset, TIMA starts at 0
  * =====================================================================================
  */
 void
-increment_timer()
+init_timers(GB *gb)
+{
+    gb->timers.divider_base = gb->clock.cycles;
+    gb->timers.timer_base = gb->clock.cycles;
+    gb->timers.timer_value = 0x0;
+    gb->timers.timer_control = read_memory(gb, 0xFF07);
+    gb->timers.timer_modulo = read_memory(gb, 0xFF06);
+    schedule_overflow(gb);
+}        /* -----  end of function init_timers  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  read_divider
+ *  Description:  Returns the divider register, mem address 0xFF04
+ * =====================================================================================
+ */
+unsigned char
+read_divider(GB *gb)
 {
-    unsigned char timer = read_memory(0xFF05);
-    timer++;
+    return (unsigned char) ((gb->clock.cycles - gb->timers.divider_base) >> 0x8u);
+}        /* -----  end of function read_divider  ----- */
 
-    if (timer == 0x0)
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  read_timer_counter
+ *  Description:  Returns the timer register, mem address 0xFF05. The overflow event
+ *                  runs before TIMA can pass 0xFF, so no reload is needed here
+ * =====================================================================================
+ */
+unsigned char
+read_timer_counter(GB *gb)
+{
+    return (unsigned char) (gb->timers.timer_value + timer_ticks(gb, gb->timers.timer_base, gb->clock.cycles));
+}        /* -----  end of function read_timer_counter  ----- */
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  write_timer_register
+ *  Description:  Handles writes to DIV, TIMA, TMA, and TAC, mem addresses 0xFF04 to
+ *                  0xFF07, then reschedules the overflow
+ *   Parameters:  addr is the register written
+ *                data is the byte written there
+ * =====================================================================================
+ */
+void
+write_timer_register(GB *gb, unsigned short addr, unsigned char data)
+{
+    sync_timer(gb); // Ticks so far count at the old settings
+
+    switch (addr)
     {
-        timer = read_memory(0xFF06); // Value resets to value in TMA reg at overflow
-        request_interrupt(0x4u);
+        case 0xFF04: // Any write sets DIV to 0, which restarts the TIMA period too
+            gb->timers.divider_base = gb->clock.cycles;
+            break;
+        case 0xFF05:
+            gb->timers.timer_value = data;
+            break;
+        case 0xFF06:
+            gb->timers.timer_modulo = data;
+            break;
+        default:
+            gb->timers.timer_control = data;
+            break;
     }
+    schedule_overflow(gb);
+}        /* -----  end of function write_timer_register  ----- */
 
-    write_memory(0xFF05, timer);
-}		/* -----  end of function increment_timer  ----- */
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  timer_event
+ *  Description:  Handles TIMA overflowing, it reloads from TMA and requests the
+ *                  timer interrupt
+ *   Parameters:  due is the cycle the overflow happened on
+ * =====================================================================================
+ */
+void
+timer_event(GB *gb, unsigned long due)
+{
+    gb->timers.timer_value = gb->timers.timer_modulo; // Value resets to value in TMA reg at overflow
+    gb->timers.timer_base = due;
+    request_interrupt(gb, 0x4u);
+    schedule_overflow(gb);
+}        /* -----  end of function timer_event  ----- */